@@ -0,0 +1,52 @@
+/*
+ * AltitudeFusion.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/Barometer.h"
+#include "GAUL_Drivers/L76LM33.h"
+
+#ifndef INC_GAUL_ALTITUDEFUSION_H_
+#define INC_GAUL_ALTITUDEFUSION_H_
+
+// Number of GNSS epochs averaged on the pad to get the pad altitude
+#define ALTFUSION_PAD_SAMPLES 10
+
+// GNSS epoch quality gates
+#define ALTFUSION_MIN_SATELLITES 5
+#define ALTFUSION_MAX_HDOP 4.0f
+#define ALTFUSION_MAX_VERTICAL_SPEED_MPS 30.0f // GNSS altitude lags too much above this speed
+#define ALTFUSION_MAX_INNOVATION_M 150.0f
+
+// Correction gains applied on each accepted GNSS epoch
+#define ALTFUSION_OFFSET_GAIN 0.05f
+#define ALTFUSION_DRIFT_GAIN 0.002f
+
+typedef struct {
+	float altitude_msl_m;		// Fused altitude above mean sea level
+	float altitude_agl_m;		// Fused altitude above pad
+	float offset_m;				// Barometer to MSL offset (pad altitude + accumulated drift)
+	float drift_mps;			// Estimated barometer drift rate
+	float pad_altitude_m;		// Pad altitude above mean sea level from GNSS
+	float baro_altitude_m;		// Last barometer altitude (relative to BMP280 reference)
+	float pad_sum_m;
+	uint8_t pad_samples;
+	uint8_t pad_locked;			// 1 when pad altitude is set from GNSS
+	uint32_t timestamp_ms;		// Timestamp of the last fused sample (barometer rate)
+	uint32_t gnss_timestamp_ms;	// Timestamp of the last GNSS epoch used
+	uint32_t baro_count;		// Barometer samples read from the bus
+	uint32_t gnss_count;		// GNSS epochs read from the bus
+} AltitudeFusion;
+
+void ALTFUSION_Init(AltitudeFusion *fusion);
+
+int8_t ALTFUSION_Update(AltitudeFusion *fusion);
+
+void ALTFUSION_UpdateBarometer(AltitudeFusion *fusion, const Barometer *barometer);
+int8_t ALTFUSION_UpdateGNSS(AltitudeFusion *fusion, const L76LM33 *gnss);
+
+#endif /* INC_GAUL_ALTITUDEFUSION_H_ */
@@ -25,10 +25,33 @@
 #define BAROMETER_MIN_ACC_MPSS -300
 #define BAROMETER_MAX_ACC_MPSS 300
 
+// Robust prefilter: samples further than the threshold from the running median are replaced
+#define BAROMETER_MEDIAN_WINDOW 5
+#define BAROMETER_OUTLIER_THRESHOLD_M 50
+
+// Alpha-beta-gamma estimator gains (altitude, speed, acceleration)
+#define BAROMETER_ESTIMATOR_ALPHA 0.5f
+#define BAROMETER_ESTIMATOR_BETA 0.1f
+#define BAROMETER_ESTIMATOR_GAMMA 0.01f
+#define BAROMETER_ESTIMATOR_MAX_DT_S 1.0f // Restart estimator after a longer gap
+
+// Apogee prediction during coast
+#define BAROMETER_GRAVITY_MPSS 9.80665f
+#define BAROMETER_COAST_MIN_SPD_MPS 5.0f
+#define BAROMETER_DRAG_FILTER 0.1f // Low pass on the drag coefficient estimate
+#define BAROMETER_APOGEE_PREARM_S 2.0f
+
 typedef struct {
 	float altitude_m;
 	float speed_mps;
 	float acceleration_mps2;
+	uint32_t timestamp_ms;
+	uint64_t timestamp_us; // Sample time from the microsecond clock (GAUL/Clock.h)
+	uint8_t outlier; // 1 if altitude sample was replaced by the running median
+	uint8_t coasting; // 1 when going up without thrust, apogee prediction is valid
+	float drag_per_m; // Quadratic drag estimate, acceleration = -g - drag * speed^2
+	float predicted_apogee_m;
+	float time_to_apogee_s;
 } Barometer;
 
 int8_t BAROMETER_Init();
@@ -36,4 +59,6 @@ int8_t BAROMETER_Init();
 int8_t BAROMETER_ReadAltitude(Barometer *barometer);
 int8_t BAROMETER_ReadAltitude_Validation(Barometer *barometer);
 
+uint8_t BAROMETER_ApogeeImminent(const Barometer *barometer);
+
 #endif /* INC_GAUL_BAROMETER_H_ */
@@ -0,0 +1,37 @@
+/*
+ * Beacon.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/L76LM33.h"
+
+#ifndef INC_GAUL_BEACON_H_
+#define INC_GAUL_BEACON_H_
+
+// GNSS duty cycle once landed (in ms)
+#define BEACON_PERIOD_MS 60000
+#define BEACON_FIX_TIMEOUT_MS 30000
+
+#define BEACON_STATE_ACQUIRE 0
+#define BEACON_STATE_SLEEP 1
+
+typedef struct {
+	L76LM33 last_fix;		// Last good GNSS fix
+	uint8_t state;			// BEACON_STATE_ACQUIRE or BEACON_STATE_SLEEP
+	uint32_t state_ms;		// Timestamp of the last state change
+	uint32_t landed_ms;		// Timestamp of BEACON_Init(), older fixes are ignored
+	uint32_t sent;			// Number of beacons sent
+	uint32_t gnss_count;	// GNSS epochs read from the bus
+} Beacon;
+
+void BEACON_Init();
+
+int8_t BEACON_Update();
+
+int8_t BEACON_Send();
+
+#endif /* INC_GAUL_BEACON_H_ */
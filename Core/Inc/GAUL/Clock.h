@@ -0,0 +1,22 @@
+/*
+ * Clock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_CLOCK_H_
+#define INC_GAUL_CLOCK_H_
+
+// Hardware counter width, the overflow count extends it in software
+#define CLOCK_COUNTER_BITS 16
+
+int8_t CLOCK_Init(TIM_HandleTypeDef *htim);
+
+void CLOCK_IRQHandler();
+
+uint64_t CLOCK_GetTime_us();
+
+#endif /* INC_GAUL_CLOCK_H_ */
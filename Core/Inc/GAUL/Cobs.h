@@ -0,0 +1,85 @@
+/*
+ * Cobs.h
+ *
+ * Consistent Overhead Byte Stuffing, shared by the telemetry frames
+ * (GAUL/Telemetry.h), the log download packets (GAUL/DownloadProtocol.h) and
+ * the host tools. The encoded bytes hold no 0x00, so 0x00 only marks the end
+ * of a frame and a receiver resynchronizes on the next one. Only depends on
+ * the C library.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stdint.h"
+
+#ifndef INC_GAUL_COBS_H_
+#define INC_GAUL_COBS_H_
+
+// Longest frame of a payload: 1 code byte per 254 bytes (at least one), then the delimiter
+#define COBS_MAX_FRAME(length) ((length) + (length) / 254 + 2)
+
+/**
+ * COBS encode a payload and append the frame delimiter.
+ *
+ * @param data: payload bytes.
+ * @param length: payload length.
+ * @param frame: output, at least COBS_MAX_FRAME(length) bytes.
+ *
+ * @return Frame length (delimiter included)
+ */
+static inline uint16_t COBS_Encode(const uint8_t *data, uint16_t length, uint8_t *frame) {
+	uint16_t code_index = 0; // Position of the current code byte
+	uint16_t out = 1;
+	uint8_t code = 1;
+
+	for (uint16_t i = 0; i < length; i++) {
+		if (data[i] == 0x00) {
+			frame[code_index] = code;
+			code_index = out++;
+			code = 1;
+		} else {
+			frame[out++] = data[i];
+			if (++code == 0xFF) {
+				frame[code_index] = code;
+				code_index = out++;
+				code = 1;
+			}
+		}
+	}
+	frame[code_index] = code;
+	frame[out++] = 0x00; // Delimiter
+
+	return out;
+}
+
+/**
+ * COBS decode a frame (without its delimiter).
+ *
+ * @param frame: frame bytes.
+ * @param length: frame length.
+ * @param data: output, at least length bytes.
+ *
+ * @return Payload length, 0 if the frame is invalid
+ */
+static inline uint16_t COBS_Decode(const uint8_t *frame, uint16_t length, uint8_t *data) {
+	uint16_t in = 0;
+	uint16_t out = 0;
+
+	while (in < length) {
+		uint8_t code = frame[in++];
+		if (code == 0x00 || in + code - 1 > length) {
+			return 0; // Invalid
+		}
+		for (uint8_t i = 1; i < code; i++) {
+			data[out++] = frame[in++];
+		}
+		if (code != 0xFF && in < length) {
+			data[out++] = 0x00;
+		}
+	}
+
+	return out;
+}
+
+#endif /* INC_GAUL_COBS_H_ */
@@ -0,0 +1,62 @@
+/*
+ * CpuLoad.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/Scheduler.h"
+
+#ifndef INC_GAUL_CPULOAD_H_
+#define INC_GAUL_CPULOAD_H_
+
+// Interrupt nesting levels (one per preemption priority)
+#define CPULOAD_MAX_NESTING 16
+
+// Instrumented interrupts, add one when adding an interrupt handler
+typedef enum {
+	CPULOAD_ISR_TIM2,
+	CPULOAD_ISR_TIM3,
+	CPULOAD_ISR_USART1,
+	CPULOAD_ISR_USART2,
+	CPULOAD_ISR_DMA1_CHANNEL4,
+	CPULOAD_ISR_DMA1_CHANNEL5,
+	CPULOAD_ISR_DMA1_CHANNEL7,
+	CPULOAD_ISR_EXTI15_10,
+	CPULOAD_ISR_SYSTICK,
+	CPULOAD_ISR_PENDSV,
+	CPULOAD_ISR_COUNT
+} CpuLoadIsr;
+
+typedef struct {
+	uint32_t count;			// Calls since boot
+	uint32_t cycles;		// Cycles in the current window (nested interrupts excluded)
+	uint32_t max_cycles;	// Longest call since boot
+	uint16_t load_permille;	// CPU share over the last window
+} CpuLoadCounter;
+
+typedef struct {
+	CpuLoadCounter isr[CPULOAD_ISR_COUNT];
+	CpuLoadCounter task[SCHEDULER_MAX_TASKS];
+	uint32_t idle_us;		// Sleep time in the current window (interrupts excluded)
+	uint16_t idle_permille;	// Idle share over the last window
+	uint64_t window_us;		// Start of the current window (microsecond clock)
+	uint32_t windows;		// Completed windows
+} CpuLoad;
+
+int8_t CPULOAD_Init();
+
+void CPULOAD_EnterISR();
+void CPULOAD_ExitISR(CpuLoadIsr isr);
+
+uint32_t CPULOAD_GetThreadCycles();
+void CPULOAD_AddTask(int8_t task_id, uint32_t cycles);
+void CPULOAD_Sleep();
+
+void CPULOAD_Update();
+
+const CpuLoad *CPULOAD_Get();
+
+#endif /* INC_GAUL_CPULOAD_H_ */
@@ -0,0 +1,24 @@
+/*
+ * Crc.h
+ *
+ * CRC-32 computed by the STM32F1 CRC unit: polynomial 0x04C11DB7, initial
+ * value 0xFFFFFFFF, 32-bit words fed most significant bit first, no final XOR
+ * (CRC-32/MPEG-2 over each word read as a little endian integer). Host tools
+ * compute the same CRC in software (see Tools/).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_CRC_H_
+#define INC_GAUL_CRC_H_
+
+void CRC32_Init();
+
+uint32_t CRC32_Compute(const uint32_t *words, uint32_t count);
+
+uint32_t CRC32_Accumulate(const uint32_t *words, uint32_t count);
+
+#endif /* INC_GAUL_CRC_H_ */
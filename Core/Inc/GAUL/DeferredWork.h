@@ -0,0 +1,34 @@
+/*
+ * DeferredWork.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_DEFERREDWORK_H_
+#define INC_GAUL_DEFERREDWORK_H_
+
+#define DEFERRED_QUEUE_SIZE 16 // Power of 2
+
+typedef void (*DeferredFunction)(uint32_t argument);
+
+typedef struct {
+	DeferredFunction function;
+	uint32_t argument;
+} DeferredItem;
+
+typedef struct {
+	uint32_t posted;
+	uint32_t dropped;		// Queue full
+	uint32_t max_pending;
+} DeferredStats;
+
+int8_t DEFERRED_Post(DeferredFunction function, uint32_t argument);
+
+void DEFERRED_Run();
+
+const DeferredStats *DEFERRED_GetStats();
+
+#endif /* INC_GAUL_DEFERREDWORK_H_ */
@@ -0,0 +1,80 @@
+/*
+ * Download.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/DownloadProtocol.h"
+
+#ifndef INC_GAUL_DOWNLOAD_H_
+#define INC_GAUL_DOWNLOAD_H_
+
+#define DOWNLOAD_RX_RING_SIZE 64 // Power of 2
+#define DOWNLOAD_MAX_RX_FRAME 32 // Host packets are short
+#define DOWNLOAD_TX_BUFFERS 2 // One frame is sent by DMA while the next one is built
+
+// Task period: HELLO polling, then blocks built while frame buffers are free
+#define DOWNLOAD_IDLE_PERIOD_MS 20
+#define DOWNLOAD_ACTIVE_PERIOD_MS 1
+
+// Without a new ACK for the window transfer time plus this delay, sending goes
+// back to the acknowledged offset
+#define DOWNLOAD_ACK_TIMEOUT_MS 100
+
+// Baud rate error accepted (UART divisor on the APB1 clock, in permille)
+#define DOWNLOAD_MAX_BAUD_ERROR_PERMILLE 15
+
+typedef enum {
+	DOWNLOAD_STATE_IDLE,		// Telemetry owns the UART, waiting for HELLO
+	DOWNLOAD_STATE_INFO,		// Waiting for the end of telemetry transfers, then INFO
+	DOWNLOAD_STATE_SWITCH,		// Waiting for the end of INFO, then new baud rate
+	DOWNLOAD_STATE_ACTIVE,		// Sending blocks
+	DOWNLOAD_STATE_LEAVE		// Waiting for the last transfer, then telemetry
+} DownloadState;
+
+typedef enum {
+	DOWNLOAD_TX_FREE,
+	DOWNLOAD_TX_READY,			// Frame built, waiting for the UART
+	DOWNLOAD_TX_SENDING			// DMA transfer in progress
+} DownloadTxState;
+
+typedef struct {
+	uint8_t frame[DOWNLOAD_MAX_FRAME];
+	uint16_t length;
+	volatile DownloadTxState state;
+} DownloadTxBuffer;
+
+typedef struct {
+	uint32_t sessions;			// Downloads started (INFO sent)
+	uint32_t completed;			// Downloads with every byte acknowledged
+	uint32_t refused;			// HELLO received in flight, ERASE refused
+	uint32_t erases;			// Logs erased (ERASE after DONE)
+	uint32_t blocks_sent;		// DATA packets sent, resent blocks included
+	uint32_t blocks_resent;		// DATA packets sent again after NACK or ACK timeout
+	uint32_t nacks;
+	uint32_t ack_timeouts;
+	uint32_t rx_errors;			// Invalid host packets (COBS, CRC, version) and UART errors
+	uint32_t rx_overruns;		// Bytes lost, RX ring full
+	uint32_t tx_errors;			// DMA or UART errors, the frame is lost
+	uint32_t baud_rate;			// Baud rate of the last download
+	uint32_t duration_ms;		// Duration of the last download (INFO to every byte acknowledged)
+	uint32_t bytes_per_s;		// Log throughput of the last download
+} DownloadStats;
+
+int8_t DOWNLOAD_Init(UART_HandleTypeDef *huart);
+
+void DOWNLOAD_Update();
+
+uint8_t DOWNLOAD_IsActive();
+uint32_t DOWNLOAD_GetPeriod_ms();
+
+void DOWNLOAD_RxCpltCallback(UART_HandleTypeDef *huart);
+void DOWNLOAD_TxCpltCallback(UART_HandleTypeDef *huart);
+void DOWNLOAD_ErrorCallback(UART_HandleTypeDef *huart);
+
+const DownloadStats *DOWNLOAD_GetStats();
+
+#endif /* INC_GAUL_DOWNLOAD_H_ */
@@ -0,0 +1,163 @@
+/*
+ * DownloadProtocol.h
+ *
+ * Post-flight log download protocol over USART2, shared by the firmware
+ * (GAUL/Download.c) and the host tools (Tools/download_receiver.c,
+ * Tools/download_simulator.c). Only depends on the C library.
+ *
+ * Packet: <header> <body> <CRC-32>, all little endian 32-bit words. The CRC is
+ * computed over the header and body words like the STM32F1 CRC unit
+ * (GAUL/Crc.h). Each packet is COBS encoded (GAUL/Cobs.h) and ends with 0x00,
+ * like telemetry frames (GAUL/Telemetry.h): a receiver resynchronizes on the
+ * next 0x00.
+ *
+ * Session:
+ * 1. Host: HELLO (baud rate), repeated until INFO. The board only answers out
+ *    of flight: telemetry is paused, then INFO (log size and ID, baud rate used)
+ *    is sent at the current baud rate before switching.
+ * 2. Host: NACK (offset) at the new baud rate: start, or resume a partial
+ *    download of the same log ID (CRC-32 of the first DOWNLOAD_LOG_ID_SIZE
+ *    bytes of the log).
+ * 3. Board: DATA blocks from the offset, at most a window of blocks ahead of
+ *    the last acknowledged offset. Host: ACK (offset) every few blocks, all
+ *    bytes before it were received. Go-back-N: a lost or corrupted block makes
+ *    the host send NACK (first missing offset), blocks after it are dropped.
+ *    Without progress, the board also goes back to the acknowledged offset.
+ * 4. Board: DONE (size, CRC-32 of the whole log) once every byte is
+ *    acknowledged, sent again on NACK(size).
+ * 5. Optional, once the host checked the log against DONE: ERASE (size and
+ *    CRC-32 of DONE), repeated until ERASED. The board only erases the log
+ *    (GAUL/Recorder.h) after DONE was sent, if both match it: ERASE is the
+ *    acknowledgement of DONE. No packet is handled during the erase (blocking,
+ *    ~20-40 ms per page). Board: ERASED (status), again on a repeated ERASE.
+ * 6. Host: BYE, the board restores telemetry. The board also leaves after
+ *    DOWNLOAD_IDLE_TIMEOUT_MS without a valid packet.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stdint.h"
+
+#include "GAUL/Cobs.h"
+
+#ifndef INC_GAUL_DOWNLOADPROTOCOL_H_
+#define INC_GAUL_DOWNLOADPROTOCOL_H_
+
+#define DOWNLOAD_PROTOCOL_VERSION 1
+
+#define DOWNLOAD_INITIAL_BAUD_RATE 115200	// Telemetry baud rate, HELLO and INFO
+#define DOWNLOAD_DEFAULT_BAUD_RATE 921600	// 0.16% error on the 36 MHz APB1 clock
+#define DOWNLOAD_BLOCK_SIZE 256				// Multiple of 4, the log size is a multiple of it
+#define DOWNLOAD_WINDOW_BLOCKS 8			// Blocks sent ahead of the acknowledged offset
+#define DOWNLOAD_LOG_ID_SIZE 32				// Start of the first record (header of the oldest page, without its CRC)
+
+#define DOWNLOAD_IDLE_TIMEOUT_MS 5000		// Board leaves download mode without a valid packet
+
+// Packet types, board packets have bit 7 set
+#define DOWNLOAD_PACKET_HELLO 0x01	// Host: enter download mode
+#define DOWNLOAD_PACKET_NACK 0x02	// Host: (re)send from offset
+#define DOWNLOAD_PACKET_ACK 0x03	// Host: every byte before offset received
+#define DOWNLOAD_PACKET_BYE 0x04	// Host: leave download mode
+#define DOWNLOAD_PACKET_ERASE 0x05	// Host: erase the log, after DONE
+#define DOWNLOAD_PACKET_INFO 0x81	// Board: log description
+#define DOWNLOAD_PACKET_DATA 0x82	// Board: log block
+#define DOWNLOAD_PACKET_DONE 0x83	// Board: every byte acknowledged
+#define DOWNLOAD_PACKET_ERASED 0x84	// Board: erase result
+
+// ERASED status
+#define DOWNLOAD_ERASE_OK 0
+#define DOWNLOAD_ERASE_REFUSED -1	// DONE not sent, size or CRC not matching DONE, or in flight
+#define DOWNLOAD_ERASE_FAILED -2	// Flash erase error, ERASE may be sent again
+
+typedef struct {
+	uint8_t type;		// DOWNLOAD_PACKET_*
+	uint8_t version;	// DOWNLOAD_PROTOCOL_VERSION
+	uint16_t length;	// Body bytes (multiple of 4), the CRC follows the body
+} DownloadHeader;
+
+typedef struct {
+	DownloadHeader header;
+	uint32_t baud_rate;		// Requested baud rate after INFO, 0: keep
+	uint32_t crc;
+} DownloadHello;
+
+// ACK and NACK
+typedef struct {
+	DownloadHeader header;
+	uint32_t offset;
+	uint32_t crc;
+} DownloadAck;
+
+typedef struct {
+	DownloadHeader header;
+	uint32_t crc;
+} DownloadBye;
+
+// Same size and log CRC as DONE
+typedef struct {
+	DownloadHeader header;
+	uint32_t size;
+	uint32_t log_crc;
+	uint32_t crc;
+} DownloadErase;
+
+typedef struct {
+	DownloadHeader header;
+	uint32_t size;			// Log bytes
+	uint32_t log_id;		// CRC-32 of the first DOWNLOAD_LOG_ID_SIZE bytes, 0 if shorter
+	uint32_t baud_rate;		// Baud rate used after INFO
+	uint16_t block_size;	// DATA bytes (DOWNLOAD_BLOCK_SIZE)
+	uint16_t window_blocks;	// DOWNLOAD_WINDOW_BLOCKS
+	uint32_t crc;
+} DownloadInfo;
+
+// The CRC follows the data, the last block may be shorter
+typedef struct {
+	DownloadHeader header;
+	uint32_t offset;
+	uint8_t data[DOWNLOAD_BLOCK_SIZE];
+	uint32_t crc;
+} DownloadData;
+
+typedef struct {
+	DownloadHeader header;
+	uint32_t size;
+	uint32_t log_crc;		// CRC-32 of the whole log (words)
+	uint32_t crc;
+} DownloadDone;
+
+typedef struct {
+	DownloadHeader header;
+	int32_t status;			// DOWNLOAD_ERASE_*
+	uint32_t crc;
+} DownloadErased;
+
+// Largest packet, then COBS overhead and delimiter
+#define DOWNLOAD_MAX_PACKET sizeof(DownloadData)
+#define DOWNLOAD_MAX_FRAME COBS_MAX_FRAME(DOWNLOAD_MAX_PACKET)
+
+// Body length of a packet type (sizeof without header and CRC)
+#define DOWNLOAD_BODY_LENGTH(type) (sizeof(type) - sizeof(DownloadHeader) - sizeof(uint32_t))
+
+/**
+ * CRC-32 of words in software, same result as the STM32F1 CRC unit (host
+ * tools, the firmware uses GAUL/Crc.h).
+ *
+ * @param crc: CRC of the previous words (0xFFFFFFFF to start).
+ * @param words: words to add.
+ * @param count: number of words.
+ *
+ * @return Updated CRC
+ */
+static inline uint32_t DOWNLOAD_Crc32(uint32_t crc, const uint32_t *words, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		crc ^= words[i];
+		for (uint8_t bit = 0; bit < 32; bit++) {
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+#endif /* INC_GAUL_DOWNLOADPROTOCOL_H_ */
@@ -0,0 +1,81 @@
+/*
+ * Fault.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FAULT_H_
+#define INC_GAUL_FAULT_H_
+
+#define FAULT_RECORD_MAGIC 0xFA017EC0
+
+// Trace entries kept before a fault
+#define FAULT_TRACE_SIZE 16
+
+// Fault reasons
+#define FAULT_REASON_HARDFAULT 1
+#define FAULT_REASON_MEMMANAGE 2
+#define FAULT_REASON_BUSFAULT 3
+#define FAULT_REASON_USAGEFAULT 4
+#define FAULT_REASON_ERROR_HANDLER 5
+
+// Trace events
+#define FAULT_TRACE_TASK 1		// data: task ID
+#define FAULT_TRACE_STATE 2		// data: new flight state
+#define FAULT_TRACE_BOOT 3		// data: RCC reset flags (upper bits of RCC_CSR)
+
+typedef struct {
+	uint32_t tick_ms;
+	uint16_t event;
+	uint16_t data;
+} FaultTraceEntry;
+
+// Flight context, kept across fault resets so the flight resumes (see FLIGHT_Init())
+typedef struct {
+	uint8_t state;				// Flight state (FlightState), 0 on the pad
+	uint32_t launch_ms;			// HAL tick of the launch, rebased on the tick of the next boot at capture
+	float press_ref_Pa;			// BMP280 ground reference pressure
+} FaultFlight;
+
+typedef struct {
+	uint32_t magic;				// FAULT_RECORD_MAGIC when a fault was captured
+	uint32_t reason;			// FAULT_REASON_*
+	uint32_t r0, r1, r2, r3, r12, lr, pc, xpsr;	// Stacked registers (pc: faulting instruction)
+	uint32_t sp;				// Stack pointer before the exception
+	uint32_t exc_return;		// LR on exception entry (stack used, thread or handler mode)
+	uint32_t cfsr;				// Configurable fault status (MemManage, BusFault, UsageFault)
+	uint32_t hfsr;				// HardFault status
+	uint32_t bfar;				// BusFault address
+	uint32_t mmfar;				// MemManage fault address
+	uint32_t tick_ms;			// Scheduler tick at the fault
+	int8_t task_id;				// Running scheduler task, -1 if none (main loop or init)
+	uint8_t trace_index;		// Next trace entry
+	uint16_t resets;			// Faults since power on
+	FaultFlight flight;			// Flight context at the fault
+	FaultTraceEntry trace[FAULT_TRACE_SIZE];
+	uint32_t checksum;
+} FaultRecord;
+
+void FAULT_Init();
+
+void FAULT_Trace(uint16_t event, uint16_t data);
+
+void FAULT_SaveFlight(uint8_t state, uint32_t launch_ms);
+void FAULT_SaveReference(float press_ref_Pa);
+
+void FAULT_Capture(uint32_t *frame, uint32_t exc_return, uint32_t reason) __attribute__((noreturn));
+void FAULT_Error(uint32_t caller) __attribute__((noreturn));
+
+const FaultRecord *FAULT_GetLast();
+const FaultFlight *FAULT_GetFlight();
+void FAULT_Report();
+
+void HardFault_Handler(void);
+void MemManage_Handler(void);
+void BusFault_Handler(void);
+void UsageFault_Handler(void);
+
+#endif /* INC_GAUL_FAULT_H_ */
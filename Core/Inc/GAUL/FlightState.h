@@ -0,0 +1,64 @@
+/*
+ * FlightState.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/Barometer.h"
+
+#ifndef INC_GAUL_FLIGHTSTATE_H_
+#define INC_GAUL_FLIGHTSTATE_H_
+
+// Sampling period of each flight state (in ms)
+#define FLIGHT_PAD_PERIOD_MS 100
+#define FLIGHT_FULL_RATE_PERIOD_MS 40
+#define FLIGHT_LANDED_PERIOD_MS 250
+
+// Launch detection: altitude or speed above threshold for consecutive samples
+#define FLIGHT_LAUNCH_ALT_M 20.0f
+#define FLIGHT_LAUNCH_SPD_MPS 15.0f
+#define FLIGHT_LAUNCH_SAMPLES 3
+
+// Guaranteed launch detection latency once the BMP280 output crosses a threshold
+// (BMP280 low power output is refreshed every ~85ms, faster than the pad period)
+#define FLIGHT_LAUNCH_DETECT_MAX_MS ((FLIGHT_LAUNCH_SAMPLES + 1) * FLIGHT_PAD_PERIOD_MS)
+
+// Apogee detection: going down for consecutive samples
+#define FLIGHT_APOGEE_SPD_MPS -2.0f
+#define FLIGHT_APOGEE_SAMPLES 5
+
+// Rates are raised from the apogee prediction (BAROMETER_ApogeeImminent()), or
+// from apogee if it was not predicted, until this delay after apogee
+#define FLIGHT_APOGEE_HOLD_MS 3000
+
+// Landing detection: speed close to zero for some time
+#define FLIGHT_LANDED_SPD_MPS 1.0f
+#define FLIGHT_LANDED_TIME_MS 5000
+
+typedef enum {
+	FLIGHT_STATE_PAD_IDLE,
+	FLIGHT_STATE_ASCENT,
+	FLIGHT_STATE_DESCENT,
+	FLIGHT_STATE_LANDED
+} FlightState;
+
+// Published on BUS_TOPIC_EVENT on each state change
+typedef struct {
+	uint32_t timestamp_ms;	// Timestamp of the barometer sample triggering the change
+	uint64_t timestamp_us;	// Same, from the microsecond clock
+	FlightState state;		// New state
+} FlightEvent;
+
+int8_t FLIGHT_Init();
+
+int8_t FLIGHT_Update();
+int8_t FLIGHT_UpdateGNSS();
+
+FlightState FLIGHT_GetState();
+uint32_t FLIGHT_GetPeriod_ms();
+uint8_t FLIGHT_ApogeeArmed();
+
+#endif /* INC_GAUL_FLIGHTSTATE_H_ */
@@ -0,0 +1,86 @@
+/*
+ * Log.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_LOG_H_
+#define INC_GAUL_LOG_H_
+
+// ITM stimulus port of the tokenized logs (port 0 is printf, see _write in main.c)
+#define LOG_ITM_PORT 1
+
+// Frame header: marker in the upper byte, format string address in .log_fmt below
+#define LOG_FRAME_MARKER 0xA5000000
+#define LOG_TOKEN_MASK 0x00FFFFFF
+
+// Longest string argument sent (longer strings are truncated)
+#define LOG_MAX_STRING_LENGTH 128
+
+typedef enum {
+	LOG_TYPE_END,
+	LOG_TYPE_INT,		// 1 word
+	LOG_TYPE_INT64,		// 2 words, low word first
+	LOG_TYPE_FLOAT,		// 1 word, IEEE 754 single precision (double arguments are converted)
+	LOG_TYPE_STRING		// 1 word length, then the characters packed in words
+} LogType;
+
+typedef struct {
+	LogType type;
+	union {
+		uint32_t u32;
+		uint64_t u64;
+		float f32;
+		const char *str;
+	};
+} LogArg;
+
+static inline LogArg LOG_ArgInt(uint32_t value) { return (LogArg){ .type = LOG_TYPE_INT, .u32 = value }; }
+static inline LogArg LOG_ArgInt64(uint64_t value) { return (LogArg){ .type = LOG_TYPE_INT64, .u64 = value }; }
+static inline LogArg LOG_ArgFloat(float value) { return (LogArg){ .type = LOG_TYPE_FLOAT, .f32 = value }; }
+static inline LogArg LOG_ArgString(const char *value) { return (LogArg){ .type = LOG_TYPE_STRING, .str = value }; }
+
+#define LOG_ARG(x) _Generic((x), \
+	float: LOG_ArgFloat, \
+	double: LOG_ArgFloat, \
+	int64_t: LOG_ArgInt64, \
+	uint64_t: LOG_ArgInt64, \
+	char *: LOG_ArgString, \
+	const char *: LOG_ArgString, \
+	default: LOG_ArgInt)(x),
+
+// Apply LOG_ARG to each argument (up to 8)
+#define LOG_MAP_0()
+#define LOG_MAP_1(x) LOG_ARG(x)
+#define LOG_MAP_2(x, ...) LOG_ARG(x) LOG_MAP_1(__VA_ARGS__)
+#define LOG_MAP_3(x, ...) LOG_ARG(x) LOG_MAP_2(__VA_ARGS__)
+#define LOG_MAP_4(x, ...) LOG_ARG(x) LOG_MAP_3(__VA_ARGS__)
+#define LOG_MAP_5(x, ...) LOG_ARG(x) LOG_MAP_4(__VA_ARGS__)
+#define LOG_MAP_6(x, ...) LOG_ARG(x) LOG_MAP_5(__VA_ARGS__)
+#define LOG_MAP_7(x, ...) LOG_ARG(x) LOG_MAP_6(__VA_ARGS__)
+#define LOG_MAP_8(x, ...) LOG_ARG(x) LOG_MAP_7(__VA_ARGS__)
+#define LOG_COUNT(...) LOG_COUNT_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_COUNT_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define LOG_MAP_N(N, ...) LOG_MAP_##N(__VA_ARGS__)
+#define LOG_MAP(N, ...) LOG_MAP_N(N, __VA_ARGS__)
+
+/**
+ * Log a message with printf like format (%d %i %u %x %X %c %f %e %g %s, l and ll
+ * modifiers, flags, width and precision). The format string stays in the ELF
+ * (.log_fmt section, not loaded in flash), only its address and the raw
+ * arguments are sent. Decode on the host with Tools/log_decoder.c.
+ *
+ * No line ending in the format, each message is a line.
+ */
+#define LOG(format, ...) do { \
+	static const char _log_format[] __attribute__((section(".log_fmt"), used)) = format; \
+	const LogArg _log_args[] = { LOG_MAP(LOG_COUNT(_, ##__VA_ARGS__), ##__VA_ARGS__) { .type = LOG_TYPE_END } }; \
+	LOG_Write((uint32_t)(uintptr_t)_log_format, _log_args); \
+} while (0)
+
+void LOG_Write(uint32_t token, const LogArg args[]);
+
+#endif /* INC_GAUL_LOG_H_ */
@@ -0,0 +1,27 @@
+/*
+ * MedianFilter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_MEDIANFILTER_H_
+#define INC_GAUL_MEDIANFILTER_H_
+
+#define MEDIANFILTER_MAX_SIZE 15
+
+typedef struct {
+	float window[MEDIANFILTER_MAX_SIZE];	// Samples in arrival order (ring)
+	float sorted[MEDIANFILTER_MAX_SIZE];	// Same samples sorted
+	uint8_t size;							// Window size (odd)
+	uint8_t count;							// Number of samples in window
+	uint8_t index;							// Oldest sample in window
+} MedianFilter;
+
+int8_t MEDIANFILTER_Init(MedianFilter *filter, uint8_t size);
+
+float MEDIANFILTER_Update(MedianFilter *filter, float sample);
+
+#endif /* INC_GAUL_MEDIANFILTER_H_ */
@@ -0,0 +1,88 @@
+/*
+ * Profile.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_PROFILE_H_
+#define INC_GAUL_PROFILE_H_
+
+// Set to 1 (or define it in the build settings) to record profiling zones
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 0
+#endif
+
+// Profiling zones, add one here then wrap code with PROFILE_BEGIN(name) and PROFILE_END(name)
+#define PROFILE_ZONES(ZONE) \
+	ZONE(BMP280_READ_ALTITUDE) \
+	ZONE(BMP280_READ_PRESSURE) \
+	ZONE(BMP280_PRESSURE_TO_ALTITUDE) \
+	ZONE(L76LM33_READ_SENTENCE) \
+	ZONE(L76LM33_PARSE_SENTENCE)
+
+// Histogram bin n counts durations from 2^(n-1) to 2^n - 1 cycles (bin 0: 0 cycle)
+#define PROFILE_HISTOGRAM_BINS 33
+
+#define PROFILE_ZONE_ID(name) PROFILE_ZONE_##name,
+typedef enum {
+	PROFILE_ZONES(PROFILE_ZONE_ID)
+	PROFILE_ZONE_COUNT
+} ProfileZoneId;
+#undef PROFILE_ZONE_ID
+
+typedef struct {
+	uint32_t count;
+	uint32_t min_cycles;
+	uint32_t max_cycles;
+	uint64_t total_cycles; // Mean is total_cycles / count
+	uint32_t histogram[PROFILE_HISTOGRAM_BINS];
+} ProfileZone;
+
+#if PROFILE_ENABLED
+
+extern ProfileZone _profile_zones[PROFILE_ZONE_COUNT];
+
+/**
+ * Record a zone duration. A zone must only be recorded from one context
+ * (main loop or a single interrupt).
+ *
+ * @param zone: zone ID.
+ * @param cycles: duration in CPU cycles.
+ */
+static inline void PROFILE_Record(ProfileZoneId zone, uint32_t cycles) {
+	ProfileZone *profile = &_profile_zones[zone];
+
+	profile->count++;
+	profile->total_cycles += cycles;
+	if (cycles < profile->min_cycles) {
+		profile->min_cycles = cycles;
+	}
+	if (cycles > profile->max_cycles) {
+		profile->max_cycles = cycles;
+	}
+	profile->histogram[32 - __CLZ(cycles)]++;
+}
+
+#define PROFILE_BEGIN(name) uint32_t _profile_start_##name = DWT->CYCCNT
+#define PROFILE_END(name) PROFILE_Record(PROFILE_ZONE_##name, DWT->CYCCNT - _profile_start_##name)
+
+void PROFILE_Init();
+void PROFILE_Reset();
+void PROFILE_Report();
+
+#else
+
+// Profiling disabled, compiles to nothing
+#define PROFILE_BEGIN(name)
+#define PROFILE_END(name)
+
+#define PROFILE_Init()
+#define PROFILE_Reset()
+#define PROFILE_Report()
+
+#endif /* PROFILE_ENABLED */
+
+#endif /* INC_GAUL_PROFILE_H_ */
@@ -0,0 +1,129 @@
+/*
+ * Recorder.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/TelemetrySchema.h"
+#include "GAUL/SampleCodec.h"
+#include "GAUL/FlightState.h"
+#include "GAUL/Crc.h"
+
+#ifndef INC_GAUL_RECORDER_H_
+#define INC_GAUL_RECORDER_H_
+
+// Fixed-size records, a flash page holds a page header record then data records
+#define RECORDER_PAGE_SIZE FLASH_PAGE_SIZE
+#define RECORDER_RECORD_SIZE 64
+#define RECORDER_RECORDS_PER_PAGE (RECORDER_PAGE_SIZE / RECORDER_RECORD_SIZE)
+#define RECORDER_RECORD_DATA (RECORDER_RECORD_SIZE - 6)
+
+// Record IDs, other IDs are telemetry message IDs with TELEMETRY_ID_* flags (GAUL/TelemetrySchema.h)
+#define RECORDER_ID_PAGE 0x3F	// Page header
+#define RECORDER_ID_ERASED 0xFF	// Free slot
+#define RECORDER_ID_SKIPPED 0x00	// Page skipped at the head, programmed but not opened (0x0000 programs over any halfword)
+
+#define RECORDER_VERSION 2
+
+// Page header flags
+#define RECORDER_PAGE_FLIGHT 0x01 // The log held a flight when the page was opened
+
+// RAM double buffer: records of one buffer are programmed while the other one is filled
+#define RECORDER_BUFFER_RECORDS 8 // Holds the pre-launch ring flushed at launch
+
+// Records programmed per RECORDER_Update() call (~2 ms each)
+#define RECORDER_PROGRAM_RECORDS 1
+
+// A partially filled record waits at most this delay in RAM
+#define RECORDER_FLUSH_MS 1000
+
+// Pages are only erased on the pad, one page per period (a page erase stalls the CPU ~20-40 ms)
+#define RECORDER_ERASE_PERIOD_MS 250
+// Oldest pages kept on the pad, other pages are erased ahead of the flight
+#define RECORDER_PAD_HISTORY_PAGES 4
+
+// Pre-launch ring: the last barometer samples of the pad are kept in RAM, and
+// flushed to the log ahead of live samples when the launch is declared (Power of 2)
+#define RECORDER_PRELAUNCH_SAMPLES 32
+#define RECORDER_PRELAUNCH_MS (RECORDER_PRELAUNCH_SAMPLES * FLIGHT_PAD_PERIOD_MS)
+
+// STREAM(message, compressed, pad period ms), pad period 0: every sample is logged on the pad
+#define RECORDER_STREAMS(STREAM) \
+	STREAM(EVENT, 0, 0) \
+	STREAM(GNSS, 1, 0) \
+	STREAM(ALTITUDE, 1, 1000) \
+	STREAM(BARO, 1, 1000)
+
+#define RECORDER_STREAM_ENUM(name, compressed, pad_period_ms) RECORDER_STREAM_##name,
+typedef enum {
+	RECORDER_STREAMS(RECORDER_STREAM_ENUM)
+	RECORDER_STREAM_COUNT
+} RecorderStreamId;
+
+// Programmed in order, the CRC last: a record cut by a reset fails the CRC, and
+// a slot whose ID is erased was never started
+typedef struct {
+	uint8_t id;			// Record ID
+	uint8_t length;		// Data bytes used, unused bytes are 0xFF
+	uint8_t data[RECORDER_RECORD_DATA];
+	uint32_t crc;		// CRC-32 of the other words (GAUL/Crc.h)
+} RecorderRecord;
+
+// Data of a page header record
+typedef struct __attribute__((packed)) {
+	uint32_t sequence;	// Incremented for each page opened: consecutive in ring order up to the head page
+	uint8_t state;		// Flight state when the page was opened
+	uint8_t version;	// RECORDER_VERSION
+	uint8_t schema;		// TELEMETRY_SCHEMA_VERSION
+	uint8_t flags;		// RECORDER_PAGE_*
+} RecorderPageHeader;
+
+typedef struct {
+	uint8_t id;				// Message ID
+	uint8_t compressed;		// 1: delta/varint samples, each record starts with a keyframe
+	uint16_t pad_period_ms;	// Logging period on the pad, 0: every sample
+	uint32_t last_ms;		// Timestamp of the last sample logged on the pad
+	SampleCodec codec;
+	RecorderRecord record;	// Record being filled
+	uint32_t record_ms;		// Tick of the first sample of the record
+	uint32_t samples;
+} RecorderStream;
+
+typedef struct {
+	RecorderRecord records[RECORDER_BUFFER_RECORDS];
+	uint8_t count;
+} RecorderBuffer;
+
+typedef struct {
+	uint32_t records;			// Records programmed since boot
+	uint32_t dropped;			// Records dropped, buffers full or no erased page
+	uint32_t program_errors;	// Programming or verification failures
+	uint32_t erases;			// Pages erased since boot
+	uint32_t erase_max_us;		// Longest page erase (CPU stalled)
+	uint32_t lost_ticks;		// Scheduler (TIM3) ticks lost while erasing (interrupts stalled), SysTick loses as many
+	uint32_t program_max_us;	// Longest record programming
+	uint16_t prelaunch_flushed;	// Pre-launch samples added to the log at launch
+	uint16_t pages;				// Pages of the recorder region
+	uint16_t pages_ready;		// Erased pages ahead of the head
+	uint8_t flight_logged;		// 1: the log holds a flight, pages are not erased anymore
+	uint16_t pages_skipped;		// Pages skipped at the head, programmed but not opened (cut header or erase)
+	uint8_t mount_scan;			// 1: broken sequence, the head was found by a scan of every page header
+	uint16_t mount_reads;		// Headers and slots read to find the head
+	uint32_t mount_us;			// Time to find the head
+} RecorderStats;
+
+int8_t RECORDER_Init();
+
+void RECORDER_Update();
+
+int8_t RECORDER_Erase();
+
+uint32_t RECORDER_GetLogSize();
+int8_t RECORDER_ReadLog(uint32_t offset, uint8_t *data, uint16_t size);
+
+const RecorderStats *RECORDER_GetStats();
+
+#endif /* INC_GAUL_RECORDER_H_ */
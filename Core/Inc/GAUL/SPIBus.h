@@ -0,0 +1,90 @@
+/*
+ * SPIBus.h
+ *
+ * SPI2 bus manager. Devices do not use the HAL SPI functions, they submit
+ * transactions (chip select, TX bytes then RX bytes, callback) which are run
+ * back-to-back by DMA: the next transaction starts from the DMA interrupt of
+ * the previous one. The chip select is driven by the manager, and always
+ * raised at the end of a transaction, also on error.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_SPIBUS_H_
+#define INC_GAUL_SPIBUS_H_
+
+#define SPIBUS_QUEUE_SIZE 8 // Power of 2
+
+// Blocking transfers: longest wait for the queued transactions and the transfer
+// itself (~280 bytes/ms at 2.25 MHz), the bus is reset after it
+#define SPIBUS_TIMEOUT_MS 5
+#define SPIBUS_BYTES_PER_MS 256
+
+// Transaction status
+#define SPIBUS_PENDING 1 // Queued or in progress, 0 OK, -1 ERROR
+
+typedef enum {
+	SPIBUS_DEVICE_BMP280,
+	SPIBUS_DEVICE_NORFLASH,
+	SPIBUS_DEVICE_COUNT
+} SPIBusDevice;
+
+typedef struct SPIBusTransaction SPIBusTransaction;
+
+// Called from the DMA interrupt when a transaction ends (chip select already
+// high), must not submit transactions
+typedef void (*SPIBusCallback)(SPIBusTransaction *transaction);
+
+// Caller owned, the transaction and its buffers stay valid until the status
+// is not SPIBUS_PENDING anymore
+struct SPIBusTransaction {
+	SPIBusDevice device;
+	const uint8_t *tx;			// Sent first (command, address, data)
+	uint16_t tx_size;
+	uint8_t *rx;				// Received after the TX bytes (0xFF sent)
+	uint16_t rx_size;
+	SPIBusCallback callback;	// NULL: none
+	void *context;				// For the callback
+	volatile int8_t status;		// SPIBUS_PENDING, 0 OK, -1 ERROR
+};
+
+typedef struct {
+	uint32_t transactions;
+	uint32_t bytes;				// TX and RX bytes
+	uint32_t errors;			// SPI/DMA errors and aborted transactions
+	uint32_t bytes_per_s;		// Throughput over the last window (SPIBUS_Update())
+	uint32_t window_bytes;
+} SPIBusDeviceStats;
+
+typedef struct {
+	SPIBusDeviceStats device[SPIBUS_DEVICE_COUNT];
+	uint32_t queue_full;		// Transactions refused
+	uint8_t queue_max;			// Most transactions pending (queued and in progress)
+	uint32_t resets;			// Bus reset after a stuck transfer
+	uint64_t window_us;			// Start of the current window (microsecond clock)
+} SPIBusStats;
+
+int8_t SPIBUS_Init(SPI_HandleTypeDef *hspi);
+
+void SPIBUS_SetChipSelect(SPIBusDevice device, GPIO_TypeDef *port, uint16_t pin);
+
+int8_t SPIBUS_Submit(SPIBusTransaction *transaction);
+
+int8_t SPIBUS_Transfer(SPIBusDevice device, const uint8_t *tx, uint16_t tx_size, uint8_t *rx, uint16_t rx_size);
+
+void SPIBUS_Reset();
+
+uint8_t SPIBUS_GetPending();
+
+void SPIBUS_CpltCallback(SPI_HandleTypeDef *hspi);
+
+void SPIBUS_ErrorCallback(SPI_HandleTypeDef *hspi);
+
+void SPIBUS_Update();
+
+const SPIBusStats *SPIBUS_GetStats();
+
+#endif /* INC_GAUL_SPIBUS_H_ */
@@ -0,0 +1,44 @@
+/*
+ * SampleBus.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_SAMPLEBUS_H_
+#define INC_GAUL_SAMPLEBUS_H_
+
+// Read attempts while the writer is updating the sample
+#define BUS_READ_RETRIES 4
+
+// Samples kept per topic (1: latest only)
+#define BUS_BARO_HISTORY 8
+#define BUS_GNSS_HISTORY 2
+#define BUS_ALTITUDE_HISTORY 2
+#define BUS_EVENT_HISTORY 4
+
+typedef enum {
+	BUS_TOPIC_BARO,		// Barometer
+	BUS_TOPIC_GNSS,		// L76LM33
+	BUS_TOPIC_ALTITUDE,	// AltitudeFusion
+	BUS_TOPIC_EVENT,	// FlightEvent
+	BUS_TOPIC_COUNT
+} BusTopic;
+
+typedef struct {
+	volatile uint32_t sequence;	// Odd while a sample is written, published samples = sequence / 2
+	uint16_t sample_size;
+	uint8_t history;
+	uint8_t *samples;			// history * sample_size bytes
+} BusTopicSlot;
+
+int8_t BUS_Publish(BusTopic topic, const void *sample);
+
+int8_t BUS_Read(BusTopic topic, void *sample, uint32_t *count);
+int8_t BUS_ReadHistory(BusTopic topic, uint8_t age, void *sample);
+
+uint32_t BUS_GetCount(BusTopic topic);
+
+#endif /* INC_GAUL_SAMPLEBUS_H_ */
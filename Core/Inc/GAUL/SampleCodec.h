@@ -0,0 +1,40 @@
+/*
+ * SampleCodec.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stdint.h"
+
+#ifndef INC_GAUL_SAMPLECODEC_H_
+#define INC_GAUL_SAMPLECODEC_H_
+
+#define CODEC_MAX_FIELDS 12
+
+// Samples between keyframes (resynchronization after a lost frame)
+#define CODEC_KEYFRAME_INTERVAL 32
+
+// Longest encoded sample (a keyframe at worst): 5 bytes per 32-bit varint
+#define CODEC_SAMPLE_SIZE(field_count) (5 * (field_count))
+#define CODEC_MAX_SAMPLE_SIZE CODEC_SAMPLE_SIZE(CODEC_MAX_FIELDS)
+
+typedef struct {
+	uint8_t field_count;
+	uint16_t keyframe_interval;
+	uint16_t since_keyframe;	// Samples since the last keyframe, keyframe_interval forces one
+	int32_t previous[CODEC_MAX_FIELDS];
+} SampleCodec;
+
+void CODEC_Init(SampleCodec *codec, uint8_t field_count, uint16_t keyframe_interval);
+void CODEC_Reset(SampleCodec *codec);
+
+uint8_t CODEC_KeyframeDue(const SampleCodec *codec);
+
+uint8_t CODEC_Encode(SampleCodec *codec, const int32_t *values, uint8_t *out);
+int8_t CODEC_Decode(SampleCodec *codec, const uint8_t *in, uint8_t length, uint8_t keyframe, int32_t *values);
+
+uint8_t CODEC_PutVarint(uint8_t *out, uint32_t value);
+int8_t CODEC_GetVarint(const uint8_t *in, uint8_t length, uint32_t *value);
+
+#endif /* INC_GAUL_SAMPLECODEC_H_ */
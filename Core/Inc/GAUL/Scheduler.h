@@ -0,0 +1,43 @@
+/*
+ * Scheduler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_SCHEDULER_H_
+#define INC_GAUL_SCHEDULER_H_
+
+#define SCHEDULER_MAX_TASKS 8
+
+typedef void (*SchedulerFunction)(void);
+
+typedef struct {
+	const char *name;
+	SchedulerFunction function;
+	uint32_t period_ms;
+	uint32_t release_ms;	// Tick of the next release
+	uint32_t runs;
+	uint32_t overruns;		// Releases missed or completed after the next release
+	uint32_t last_us;		// Last execution time
+	uint32_t wcet_us;		// Worst case execution time
+} SchedulerTask;
+
+int8_t SCHEDULER_Init(TIM_HandleTypeDef *htim);
+
+int8_t SCHEDULER_AddTask(const char *name, SchedulerFunction function, uint32_t period_ms);
+int8_t SCHEDULER_SetPeriod(int8_t task_id, uint32_t period_ms);
+
+void SCHEDULER_TickCallback(TIM_HandleTypeDef *htim);
+void SCHEDULER_Dispatch();
+
+uint32_t SCHEDULER_GetTick_ms();
+uint32_t SCHEDULER_GetTime_us();
+
+int8_t SCHEDULER_GetCurrentTask();
+
+const SchedulerTask *SCHEDULER_GetTask(int8_t task_id);
+
+#endif /* INC_GAUL_SCHEDULER_H_ */
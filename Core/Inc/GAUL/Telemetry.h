@@ -0,0 +1,131 @@
+/*
+ * Telemetry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/TelemetrySchema.h"
+#include "GAUL/SampleCodec.h"
+#include "GAUL/Cobs.h"
+#include "GAUL/AltitudeFusion.h"
+#include "GAUL/FlightState.h"
+
+#ifndef INC_GAUL_TELEMETRY_H_
+#define INC_GAUL_TELEMETRY_H_
+
+#define TELEMETRY_RING_SIZE 1024 // Power of 2
+#define TELEMETRY_PRIORITY_RING_SIZE 128 // Power of 2, critical frames and beacons
+
+// Longest DMA transfer (in bytes), a critical frame waits at most one transfer
+// (~11 ms at 115200 baud)
+#define TELEMETRY_MAX_TX_CHUNK 128
+
+// Header (ID, sequence) + body + CRC
+#define TELEMETRY_MAX_PAYLOAD (2 + TELEMETRY_MAX_BODY + 2)
+// COBS overhead + delimiter
+#define TELEMETRY_MAX_FRAME COBS_MAX_FRAME(TELEMETRY_MAX_PAYLOAD)
+
+// Longest raw text (recovery beacon)
+#define TELEMETRY_MAX_TEXT 80
+
+#define TELEMETRY_WINDOW_MS 1000 // Frame rate and byte budget accounting window
+
+// Stream priorities, 0 is the most urgent
+#define TELEMETRY_PRIORITY_CRITICAL 0	// Priority ring, sent ahead of other frames, never decimated
+#define TELEMETRY_PRIORITY_HIGH 1
+#define TELEMETRY_PRIORITY_NORMAL 2
+#define TELEMETRY_PRIORITY_LOW 3
+
+// TX ring occupancy above which streams of each priority are decimated (in permille),
+// decimation is halved again below half of it
+#define TELEMETRY_BACKPRESSURE_HIGH_PERMILLE 750
+#define TELEMETRY_BACKPRESSURE_NORMAL_PERMILLE 500
+#define TELEMETRY_BACKPRESSURE_LOW_PERMILLE 250
+#define TELEMETRY_MAX_DECIMATION 16
+#define TELEMETRY_RATE_PERIOD_MS 100 // Decimation update period
+
+// Compressed streams: samples are batched in one frame for at most this delay
+#define TELEMETRY_BATCH_MS 200
+
+// STREAM(message, priority, target period ms, compressed), period 0: every new sample
+// Around apogee (FLIGHT_ApogeeArmed()), the fused altitude is sent at every new sample
+// Listed in sending order
+#define TELEMETRY_STREAMS(STREAM) \
+	STREAM(EVENT, TELEMETRY_PRIORITY_CRITICAL, 0, 0) \
+	STREAM(HEALTH, TELEMETRY_PRIORITY_HIGH, 1000, 0) \
+	STREAM(GNSS, TELEMETRY_PRIORITY_HIGH, 0, 1) \
+	STREAM(ALTITUDE, TELEMETRY_PRIORITY_NORMAL, 100, 1) \
+	STREAM(BARO, TELEMETRY_PRIORITY_LOW, 0, 1)
+
+#define TELEMETRY_STREAM_ENUM(name, priority, period_ms, compressed) TELEMETRY_STREAM_##name,
+typedef enum {
+	TELEMETRY_STREAMS(TELEMETRY_STREAM_ENUM)
+	TELEMETRY_STREAM_COUNT
+} TelemetryStreamId;
+
+typedef struct {
+	uint8_t id;				// Message ID
+	uint8_t priority;		// TELEMETRY_PRIORITY_*
+	uint16_t period_ms;		// Target period, 0: every new sample
+	uint8_t decimation;		// Send 1 of N due samples, follows TX ring occupancy
+	uint8_t skipped;
+	uint8_t sequence;		// Sequence number of the next frame
+	uint32_t last_ms;		// Last due sample
+	uint32_t sent;
+	uint32_t decimated;		// Due samples not sent because of backpressure
+	uint8_t compressed;		// 1: delta/varint samples, batched (GAUL/SampleCodec.h)
+	SampleCodec codec;
+	uint8_t batch[TELEMETRY_MAX_BODY];
+	uint8_t batch_length;
+	uint8_t batch_keyframe;	// 1 if the first sample of the batch is a keyframe
+	uint32_t batch_ms;		// Tick of the first sample of the batch
+	uint32_t raw_bytes;		// Body bytes without compression
+	uint32_t encoded_bytes;	// Body bytes sent (compression ratio: raw / encoded)
+} TelemetryStream;
+
+typedef struct {
+	uint8_t *data;
+	uint32_t size;			// Power of 2
+	volatile uint32_t head;	// Next free byte (main loop), only moved by whole frames
+	volatile uint32_t tail;	// Next byte to send (TX interrupt)
+} TelemetryRing;
+
+typedef struct {
+	uint32_t frames;			// Frames queued since boot
+	uint32_t dropped;			// Frames dropped, TX ring full
+	uint32_t decimated;			// Samples not sent because of backpressure
+	uint32_t bytes_queued;		// Bytes queued since boot (frames and raw text)
+	uint32_t bytes_sent;		// Bytes sent by DMA since boot
+	uint32_t tx_errors;			// DMA or UART errors, bytes of the transfer are lost
+	uint16_t max_used;			// Highest TX ring occupancy (in bytes)
+	uint16_t used_permille;		// TX ring occupancy at the last rate update
+	uint16_t frame_rate;		// Frames per second over the last window
+	uint16_t byte_rate;			// Bytes per second over the last window
+	uint16_t budget_permille;	// Byte rate over link capacity (8N1) over the last window
+} TelemetryStats;
+
+int8_t TELEMETRY_Init(UART_HandleTypeDef *huart);
+
+void TELEMETRY_Update();
+
+void TELEMETRY_PackBarometer(const Barometer *barometer, TelemetryBaro *body);
+void TELEMETRY_PackGNSS(const L76LM33 *gnss, TelemetryGNSS *body);
+void TELEMETRY_PackAltitude(const AltitudeFusion *fusion, TelemetryAltitude *body);
+void TELEMETRY_PackEvent(const FlightEvent *event, TelemetryEvent *body);
+
+int8_t TELEMETRY_Send(uint8_t id, const uint8_t *body, uint8_t length);
+int8_t TELEMETRY_Write(const char *text, uint16_t length);
+
+void TELEMETRY_Pause(uint8_t paused);
+uint8_t TELEMETRY_IsIdle();
+
+void TELEMETRY_TxCpltCallback(UART_HandleTypeDef *huart);
+void TELEMETRY_ErrorCallback(UART_HandleTypeDef *huart);
+
+const TelemetryStats *TELEMETRY_GetStats();
+const TelemetryStream *TELEMETRY_GetStream(TelemetryStreamId stream);
+
+#endif /* INC_GAUL_TELEMETRY_H_ */
@@ -0,0 +1,260 @@
+/*
+ * TelemetrySchema.h
+ *
+ * Telemetry message definitions, shared by the firmware (GAUL/Telemetry.c) and
+ * the host decoder (Tools/telemetry_decoder.c). Only depends on the C library.
+ *
+ * Each message is a list of FIELD(message, name, type, scale, unit). A field
+ * is sent as a little endian integer: value * scale, truncated and clamped to
+ * the range of its type (an outlier saturates instead of wrapping). From these
+ * lists are generated:
+ * - a packed struct per message (TelemetryBaro, ...), filled in place by the
+ *   firmware with TELEMETRY_SET() and sent as the frame body,
+ * - a field descriptor table per message, used by the host to decode any
+ *   message without knowing its layout,
+ * - TELEMETRY_<type>ToValues(), giving the scaled fields in order, as input of
+ *   the sample codec (GAUL/SampleCodec.h) for compressed frames.
+ *
+ * Increment TELEMETRY_SCHEMA_VERSION on any change of a field list. The
+ * version is sent in the health message.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stdint.h"
+#include "stddef.h" // for offsetof()
+
+#ifndef INC_GAUL_TELEMETRYSCHEMA_H_
+#define INC_GAUL_TELEMETRYSCHEMA_H_
+
+#define TELEMETRY_SCHEMA_VERSION 1
+
+// Largest message body (before CRC and COBS encoding), raw or compressed
+#define TELEMETRY_MAX_BODY 48
+
+// Barometer sample, flags bit 0: outlier, bit 1: coasting
+#define TELEMETRY_BARO_FIELDS(FIELD, M) \
+	FIELD(M, timestamp_ms, U32, 1, "ms") \
+	FIELD(M, altitude_m, I32, 100, "m") \
+	FIELD(M, speed_mps, I32, 100, "m/s") \
+	FIELD(M, acceleration_mps2, I16, 100, "m/s^2") \
+	FIELD(M, flags, U8, 1, "")
+
+// GNSS epoch
+#define TELEMETRY_GNSS_FIELDS(FIELD, M) \
+	FIELD(M, timestamp_ms, U32, 1, "ms") \
+	FIELD(M, latitude, I32, 10000000, "deg") \
+	FIELD(M, longitude, I32, 10000000, "deg") \
+	FIELD(M, altitude_m, I32, 10, "m") \
+	FIELD(M, hdop, U16, 100, "") \
+	FIELD(M, fix_quality, U8, 1, "") \
+	FIELD(M, satellites, U8, 1, "")
+
+// Fused altitude
+#define TELEMETRY_ALTITUDE_FIELDS(FIELD, M) \
+	FIELD(M, timestamp_ms, U32, 1, "ms") \
+	FIELD(M, altitude_msl_m, I32, 100, "m") \
+	FIELD(M, altitude_agl_m, I32, 100, "m")
+
+// Flight state change
+#define TELEMETRY_EVENT_FIELDS(FIELD, M) \
+	FIELD(M, timestamp_ms, U32, 1, "ms") \
+	FIELD(M, state, U8, 1, "")
+
+// System health, fault fields are from the previous boot (reason 0: none)
+#define TELEMETRY_HEALTH_FIELDS(FIELD, M) \
+	FIELD(M, uptime_ms, U32, 1, "ms") \
+	FIELD(M, schema_version, U8, 1, "") \
+	FIELD(M, idle_permille, U16, 1, "permille") \
+	FIELD(M, flight_state, U8, 1, "") \
+	FIELD(M, timesync_source, U8, 1, "") \
+	FIELD(M, timesync_residual_us, I32, 1, "us") \
+	FIELD(M, drift_ppm, I16, 100, "ppm") \
+	FIELD(M, fault_reason, U8, 1, "") \
+	FIELD(M, fault_pc, U32, 1, "") \
+	FIELD(M, fault_resets, U16, 1, "") \
+	FIELD(M, dropped, U16, 1, "") \
+	FIELD(M, budget_permille, U16, 1, "permille")
+
+// MESSAGE(name, ID, type name)
+#define TELEMETRY_MESSAGES(MESSAGE) \
+	MESSAGE(BARO, 1, Baro) \
+	MESSAGE(GNSS, 2, GNSS) \
+	MESSAGE(ALTITUDE, 3, Altitude) \
+	MESSAGE(EVENT, 4, Event) \
+	MESSAGE(HEALTH, 5, Health)
+
+// Compressed frames: message ID with TELEMETRY_ID_COMPRESSED set, and
+// TELEMETRY_ID_KEYFRAME set if the first sample is a keyframe. The body holds one
+// or more samples, each sample is the scaled fields in order, encoded by the
+// sample codec (delta from the previous sample of the same message, varint).
+#define TELEMETRY_ID_COMPRESSED 0x80
+#define TELEMETRY_ID_KEYFRAME 0x40
+#define TELEMETRY_ID_MASK 0x3F
+
+// Field types
+typedef uint8_t TELEMETRY_TYPE_U8;
+typedef int8_t TELEMETRY_TYPE_I8;
+typedef uint16_t TELEMETRY_TYPE_U16;
+typedef int16_t TELEMETRY_TYPE_I16;
+typedef uint32_t TELEMETRY_TYPE_U32;
+typedef int32_t TELEMETRY_TYPE_I32;
+
+typedef enum {
+	TELEMETRY_FIELD_U8,
+	TELEMETRY_FIELD_I8,
+	TELEMETRY_FIELD_U16,
+	TELEMETRY_FIELD_I16,
+	TELEMETRY_FIELD_U32,
+	TELEMETRY_FIELD_I32
+} TelemetryFieldType;
+
+// Message IDs (TELEMETRY_MSG_BARO, ...)
+#define TELEMETRY_MSG_ID(name, id, type) TELEMETRY_MSG_##name = id,
+enum {
+	TELEMETRY_MESSAGES(TELEMETRY_MSG_ID)
+};
+
+// Field scales (TELEMETRY_SCALE_BARO_altitude_m, ...)
+#define TELEMETRY_FIELD_SCALE(M, name, type, scale, unit) TELEMETRY_SCALE_##M##_##name = scale,
+#define TELEMETRY_MSG_SCALES(name, id, type) TELEMETRY_##name##_FIELDS(TELEMETRY_FIELD_SCALE, name)
+enum {
+	TELEMETRY_MESSAGES(TELEMETRY_MSG_SCALES)
+};
+
+// Field counts (TELEMETRY_FIELD_COUNT_BARO, ...)
+#define TELEMETRY_FIELD_ONE(M, name, type, scale, unit) + 1
+#define TELEMETRY_MSG_FIELD_COUNT(name, id, type) \
+	TELEMETRY_FIELD_COUNT_##name = 0 TELEMETRY_##name##_FIELDS(TELEMETRY_FIELD_ONE, name),
+enum {
+	TELEMETRY_MESSAGES(TELEMETRY_MSG_FIELD_COUNT)
+};
+
+// Packed message bodies (TelemetryBaro, ...), little endian on both ends
+#define TELEMETRY_FIELD_MEMBER(M, name, type, scale, unit) TELEMETRY_TYPE_##type name;
+#define TELEMETRY_MSG_STRUCT(name, id, type) \
+	typedef struct __attribute__((packed)) { \
+		TELEMETRY_##name##_FIELDS(TELEMETRY_FIELD_MEMBER, name) \
+	} Telemetry##type;
+TELEMETRY_MESSAGES(TELEMETRY_MSG_STRUCT)
+
+// Scaled fields in order (TELEMETRY_BaroToValues(), ...)
+#define TELEMETRY_FIELD_TO_VALUE(M, name, type, scale, unit) values[count++] = (int32_t)body->name;
+#define TELEMETRY_MSG_TO_VALUES(name, id, type) \
+	static inline uint8_t TELEMETRY_##type##ToValues(const Telemetry##type *body, int32_t *values) { \
+		uint8_t count = 0; \
+		TELEMETRY_##name##_FIELDS(TELEMETRY_FIELD_TO_VALUE, name) \
+		return count; \
+	}
+TELEMETRY_MESSAGES(TELEMETRY_MSG_TO_VALUES)
+
+// Range of a field (TELEMETRY_TYPE_*)
+#define TELEMETRY_FIELD_MIN(field) _Generic((field), \
+	uint8_t: (int64_t)0, int8_t: (int64_t)INT8_MIN, \
+	uint16_t: (int64_t)0, int16_t: (int64_t)INT16_MIN, \
+	uint32_t: (int64_t)0, int32_t: (int64_t)INT32_MIN)
+#define TELEMETRY_FIELD_MAX(field) _Generic((field), \
+	uint8_t: (int64_t)UINT8_MAX, int8_t: (int64_t)INT8_MAX, \
+	uint16_t: (int64_t)UINT16_MAX, int16_t: (int64_t)INT16_MAX, \
+	uint32_t: (int64_t)UINT32_MAX, int32_t: (int64_t)INT32_MAX)
+
+/**
+ * Clamp a scaled value to a field range. Converting an out of range float to
+ * an integer is undefined (it wraps on the target), NaN gives 0.
+ *
+ * @param value: scaled value.
+ * @param min: lowest value of the field type.
+ * @param max: highest value of the field type.
+ *
+ * @return Value in range
+ */
+static inline int64_t TELEMETRY_ClampFloat(float value, int64_t min, int64_t max) {
+	if (value != value) {
+		return 0; // NaN
+	}
+	if (value <= (float)min) {
+		return min;
+	}
+	if (value >= (float)max) {
+		return max; // (float)max may round up, out of range
+	}
+	return (int64_t)value;
+}
+
+static inline int64_t TELEMETRY_ClampDouble(double value, int64_t min, int64_t max) {
+	if (value != value) {
+		return 0; // NaN
+	}
+	if (value <= (double)min) {
+		return min;
+	}
+	if (value >= (double)max) {
+		return max;
+	}
+	return (int64_t)value;
+}
+
+static inline int64_t TELEMETRY_ClampInt(int64_t value, int64_t min, int64_t max) {
+	return value < min ? min : value > max ? max : value;
+}
+
+// Float values are clamped in float (no double math on the target), integers are exact
+#define TELEMETRY_CLAMP(value, min, max) _Generic((value), \
+	float: TELEMETRY_ClampFloat, \
+	double: TELEMETRY_ClampDouble, \
+	default: TELEMETRY_ClampInt)((value), (min), (max))
+
+/**
+ * Set a field of a message body, scaled and clamped to the field type.
+ *
+ * @param message: message name (BARO, ...).
+ * @param body: message body (TelemetryBaro, ...).
+ * @param field: field name.
+ * @param value: value in the field unit.
+ */
+#define TELEMETRY_SET(message, body, field, value) \
+	((body).field = (__typeof__((body).field))TELEMETRY_CLAMP((value) * TELEMETRY_SCALE_##message##_##field, \
+		TELEMETRY_FIELD_MIN((body).field), TELEMETRY_FIELD_MAX((body).field)))
+
+// Field and message descriptors, for decoders
+typedef struct {
+	const char *name;
+	const char *unit;
+	TelemetryFieldType type;
+	uint8_t offset;
+	int32_t scale;
+} TelemetryField;
+
+typedef struct {
+	const char *name;
+	uint8_t id;
+	uint8_t size;				// Body size
+	uint8_t field_count;
+	const TelemetryField *fields;
+} TelemetryMessage;
+
+#define TELEMETRY_FIELD_DESCRIPTOR(M, name, type, scale, unit) \
+	{ #name, unit, TELEMETRY_FIELD_##type, offsetof(TELEMETRY_##M##_BODY, name), scale },
+#define TELEMETRY_MSG_FIELDS_TABLE(name, id, type) \
+	typedef Telemetry##type TELEMETRY_##name##_BODY; \
+	static const TelemetryField TELEMETRY_##name##_FIELD_TABLE[] = { \
+		TELEMETRY_##name##_FIELDS(TELEMETRY_FIELD_DESCRIPTOR, name) \
+	};
+#define TELEMETRY_MSG_DESCRIPTOR(name, id, type) \
+	{ #name, id, sizeof(Telemetry##type), \
+	  sizeof(TELEMETRY_##name##_FIELD_TABLE) / sizeof(TelemetryField), TELEMETRY_##name##_FIELD_TABLE },
+
+/**
+ * Define the message descriptor table (only in the decoder, tables are not
+ * needed by the firmware).
+ *
+ * @param table: name of the TelemetryMessage array.
+ */
+#define TELEMETRY_DEFINE_MESSAGE_TABLE(table) \
+	TELEMETRY_MESSAGES(TELEMETRY_MSG_FIELDS_TABLE) \
+	static const TelemetryMessage table[] = { \
+		TELEMETRY_MESSAGES(TELEMETRY_MSG_DESCRIPTOR) \
+	};
+
+#endif /* INC_GAUL_TELEMETRYSCHEMA_H_ */
@@ -0,0 +1,57 @@
+/*
+ * TimeSync.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_TIMESYNC_H_
+#define INC_GAUL_TIMESYNC_H_
+
+#define TIMESYNC_SOURCE_NONE 0
+#define TIMESYNC_SOURCE_NMEA 1 // RMC sentence start, ~1 ms jitter
+#define TIMESYNC_SOURCE_PPS 2  // 1PPS edge, ~1 us jitter
+
+// Delay between the UTC epoch and the start of its RMC sentence, measured on
+// each PPS measurement (low pass gain). Without PPS it is unknown: NMEA
+// measurements are not compensated and UTC estimates lag by this delay.
+#define TIMESYNC_LATENCY_GAIN 0.1f
+
+// PPS edge used if the RMC sentence of the same second starts within this delay (in us)
+#define TIMESYNC_PPS_MAX_AGE_US 900000
+
+// Correction gains applied on each UTC measurement
+#define TIMESYNC_OFFSET_GAIN 0.2f
+#define TIMESYNC_DRIFT_GAIN 0.02f
+#define TIMESYNC_MAX_DRIFT_PPM 200.0f // Crystal tolerance with margin
+
+// Measurements further than this from the estimate are rejected, resync after a few
+#define TIMESYNC_MAX_RESIDUAL_US 50000
+#define TIMESYNC_MAX_REJECTS 3
+
+typedef struct {
+	int64_t offset_us;			// UTC - local time at the reference time
+	uint64_t reference_us;		// Local time of the last accepted measurement
+	float drift_ppm;			// Local clock rate error (positive: local clock slow)
+	int32_t residual_us;		// Last measurement minus estimate
+	uint32_t updates;			// Accepted measurements
+	uint8_t rejects;			// Consecutive rejected measurements
+	uint8_t source;				// TIMESYNC_SOURCE_NONE (not synchronized), _NMEA or _PPS
+	uint64_t utc_us;			// UTC of the last measurement used
+	uint64_t pps_us;			// Local time of the last PPS edge
+	int32_t nmea_latency_us;	// RMC sentence start after its PPS edge, 0 if never measured
+} TimeSync;
+
+void TIMESYNC_Init();
+
+int8_t TIMESYNC_Update();
+
+void TIMESYNC_PPSCallback(uint64_t local_us);
+
+uint64_t TIMESYNC_ToUTC_us(uint64_t local_us);
+
+const TimeSync *TIMESYNC_Get();
+
+#endif /* INC_GAUL_TIMESYNC_H_ */
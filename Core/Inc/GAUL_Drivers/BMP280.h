@@ -16,8 +16,6 @@
 #define BMP_CS_Pin              GPIO_PIN_8
 #define BMP_CS_GPIO_Port        GPIOA
 
-#define BMP280_SPI_TIMEOUT      1000
-
 #define BMP280_DEVICE_ID        0x58
 #define BMP280_RESET_VALUE      0xB6
 
@@ -36,6 +34,7 @@
 
 #define BMP280_MODE_LOW_POWER 0
 #define BMP280_MODE_NORMAL_POWER 1
+#define BMP280_MODE_SLEEP 2
 
 // Setting ctrl_meas (data acquisition) register (temp/press oversampling and power mode)
 // Temperature (osrs_t)    osrs_t x2    010
@@ -51,13 +50,20 @@
 // 010;101;11 = 0x57 (normal)
 #define BMP280_SETTING_CTRL_MEAS_NORMAL 0x57
 
+// Setting ctrl_meas (data acquisition) register (temp/press oversampling and power mode)
+// Temperature (osrs_t)    osrs_t x2    010
+// Pressure (osrs_p)       osrs_p x8    100
+// Power mode              sleep        00  (no measurement, lowest power)
+// 010;100;00 = 0x50 (sleep)
+#define BMP280_SETTING_CTRL_MEAS_SLEEP 0x50
+
 //Setting config register (rate, filter, interface options)
 //Stanby time    62.5ms  001
-//IIR filter     16x     100
+//IIR filter     2x      001 (short step response to detect launch quickly)
 //Bit 1          N/A     0
 //Spi3w          4wire   0
-//001;100;00 = 0x30
-#define BMP280_SETTING_CONFIG_LOW 0x30
+//001;001;00 = 0x24
+#define BMP280_SETTING_CONFIG_LOW 0x24
 
 //Setting config register (rate, filter, interface options)
 //Stanby time    0.5ms   000
@@ -92,7 +98,7 @@ typedef struct {
     BMP280_CalibData 	calib_data;
 } BMP280;
 
-int8_t BMP280_Init(BMP280 *BMP_data, SPI_HandleTypeDef *hspi);
+int8_t BMP280_Init(BMP280 *BMP_data);
 
 int8_t BMP280_SetMode(uint8_t mode);
 int8_t BMP280_ReadCalibrationData(BMP280 *BMP_data);
@@ -17,19 +17,43 @@
 
 #define L76LM33_UART_TIMEOUT 1000
 
+// NMEA sentences waiting to be parsed (one slot is always free for the next sentence)
+#define L76LM33_SENTENCE_QUEUE_SIZE 4
+#define L76LM33_SENTENCE_SIZE 128
+
+#define L76LM33_MODE_PERIODIC 0
+#define L76LM33_MODE_FULL_POWER 1
+#define L76LM33_MODE_STANDBY 2
+
+// Maximum time between two GGA epochs to derive a vertical speed (in ms)
+#define L76LM33_MAX_EPOCH_GAP_MS 2000
+
 typedef struct {
 	float latitude;
 	float longitude;
+	float altitude_m;			// Altitude above mean sea level (GGA)
+	float vertical_speed_mps;	// Derived from consecutive GGA altitudes
+	float hdop;
+	uint8_t fix_quality;		// GGA fix quality (0: no fix)
+	uint8_t satellites;
+	uint32_t timestamp_ms;		// HAL tick of the last GGA epoch
+	uint64_t timestamp_us;		// Microsecond clock when the last GGA sentence started arriving
+	uint64_t utc_us;			// UTC of the last valid RMC epoch (us since 1970-01-01), 0 if unknown
+	uint64_t utc_timestamp_us;	// Microsecond clock when that RMC sentence started arriving
 } L76LM33;
 
 int8_t L76LM33_Init(UART_HandleTypeDef *huart);
 
 void L76LM33_RxCallback(UART_HandleTypeDef *huart);
 
+void L76LM33_ErrorCallback(UART_HandleTypeDef *huart);
+
 //int8_t L76LM33_Read(GPS_Data *GPS_data);
 int8_t L76LM33_Read(L76LM33 *L76_Data);
+int8_t L76LM33_ParseSentence(L76LM33 *L76_Data, const char *sentence, uint64_t timestamp_us);
 int8_t L76LM33_ReadSentence();
 
+int8_t L76LM33_SetMode(uint8_t mode);
 int8_t L76LM33_SendCommand(char command[], uint8_t size);
 
 #endif /* INC_GAUL_DRIVERS_L76LM33_H_ */
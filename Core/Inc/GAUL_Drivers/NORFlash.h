@@ -0,0 +1,105 @@
+/*
+ * NORFlash.h
+ *
+ * External SPI NOR flash (JEDEC 25-series, e.g. W25Q128) on SPI2, shared with
+ * the BMP280 through the bus manager (GAUL/SPIBus.h).
+ * Erases and page programs are queued and run in the background by
+ * NORFLASH_Update(): page programs are sent by DMA (one bus manager
+ * transaction, GAUL/SPIBus.h), and pages queued behind a sector erase start as
+ * soon as the erase ends. The bus is free while the chip erases or programs.
+ * Not used by the recorder yet (internal flash only): main only detects the
+ * chip, NORFLASH_Update() must be polled once operations are queued.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_DRIVERS_NORFLASH_H_
+#define INC_GAUL_DRIVERS_NORFLASH_H_
+
+#define NORFLASH_PAGE_SIZE      256  // Program unit, a program must not cross a page
+#define NORFLASH_SECTOR_SIZE    4096 // Erase unit
+#define NORFLASH_COMMAND_SIZE   4    // Command and 3-byte address
+
+// Longest busy time before an operation is given up (datasheet maximums, W25Q128JV)
+#define NORFLASH_PROGRAM_TIMEOUT_MS 5
+#define NORFLASH_ERASE_TIMEOUT_MS   500
+
+// Queued operations (erases and programs), and page buffers of queued programs (Power of 2)
+#define NORFLASH_QUEUE_SIZE     4
+#define NORFLASH_PAGE_BUFFERS   2
+
+// Commands
+#define NORFLASH_CMD_WRITE_ENABLE   0x06
+#define NORFLASH_CMD_READ_STATUS    0x05
+#define NORFLASH_CMD_READ_DATA      0x03
+#define NORFLASH_CMD_PAGE_PROGRAM   0x02
+#define NORFLASH_CMD_SECTOR_ERASE   0x20
+#define NORFLASH_CMD_JEDEC_ID       0x9F
+#define NORFLASH_CMD_RELEASE_POWER_DOWN 0xAB
+
+// Status register 1
+#define NORFLASH_STATUS_BUSY    0x01 // Erase or program in progress
+#define NORFLASH_STATUS_WEL     0x02 // Write enable latch
+
+// 3-byte addresses, up to 16 MB
+#define NORFLASH_MIN_CAPACITY_ID 0x10 // 64 KB
+#define NORFLASH_MAX_CAPACITY_ID 0x18 // 16 MB
+
+typedef enum {
+	NORFLASH_OP_ERASE,
+	NORFLASH_OP_PROGRAM
+} NORFlashOpType;
+
+typedef struct {
+	uint8_t type;		// NORFLASH_OP_*
+	uint16_t size;		// Program bytes
+	uint32_t address;
+} NORFlashOp;
+
+typedef enum {
+	NORFLASH_STATE_IDLE,	// No operation started
+	NORFLASH_STATE_DMA,		// Page program transaction queued or being sent
+	NORFLASH_STATE_BUSY		// Chip erasing or programming (bus free)
+} NORFlashState;
+
+typedef struct {
+	uint8_t manufacturer_id;
+	uint8_t memory_type;
+	uint8_t capacity_id;	// Size is 2^capacity_id bytes
+	uint32_t size;			// Bytes
+} NORFlashInfo;
+
+typedef struct {
+	uint32_t pages_programmed;
+	uint32_t sectors_erased;
+	uint32_t bytes_programmed;
+	uint32_t errors;			// SPI errors and timeouts, the operation is dropped
+	uint32_t queue_full;		// Operations refused
+	uint32_t program_max_us;	// Longest page program (command to ready)
+	uint32_t erase_max_us;		// Longest sector erase (command to ready)
+} NORFlashStats;
+
+int8_t NORFLASH_Init();
+
+int8_t NORFLASH_EraseSector(uint32_t address);
+
+int8_t NORFLASH_ProgramPage(uint32_t address, const uint8_t *data, uint16_t size);
+
+void NORFLASH_Update();
+
+int8_t NORFLASH_Flush(uint32_t timeout_ms);
+
+int8_t NORFLASH_Read(uint32_t address, uint8_t *data, uint16_t size);
+
+uint8_t NORFLASH_GetPending();
+
+uint8_t NORFLASH_GetFreePages();
+
+const NORFlashInfo *NORFLASH_GetInfo();
+
+const NORFlashStats *NORFLASH_GetStats();
+
+#endif /* INC_GAUL_DRIVERS_NORFLASH_H_ */
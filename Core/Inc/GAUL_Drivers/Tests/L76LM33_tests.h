@@ -10,9 +10,6 @@
 #ifndef INC_GAUL_DRIVERS_TESTS_L76LM33_TESTS_H_
 #define INC_GAUL_DRIVERS_TESTS_L76LM33_TESTS_H_
 
-#define DEBUG_Pin GPIO_PIN_7
-#define DEBUG_GPIO_Port GPIOC
-
 int8_t L76LM33_TESTS_LogDataUART();
 int8_t L76LM33_TESTS_LogDataSTLINK();
 
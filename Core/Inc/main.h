@@ -66,6 +66,8 @@ void Error_Handler(void);
 #define USART_RX_GPIO_Port GPIOA
 #define LD2_Pin GPIO_PIN_5
 #define LD2_GPIO_Port GPIOA
+#define NOR_CS_Pin GPIO_PIN_12
+#define NOR_CS_GPIO_Port GPIOB
 #define DEBUG_Pin GPIO_PIN_7
 #define DEBUG_GPIO_Port GPIOC
 #define BMP_CS_Pin GPIO_PIN_8
@@ -79,6 +81,33 @@ void Error_Handler(void);
 
 /* USER CODE BEGIN Private defines */
 
+/* Interrupt priorities (NVIC_PRIORITYGROUP_4: 16 preemption levels, 0 is the most urgent)
+ * Set in the .ioc (CubeMX), keep this plan up to date when adding an interrupt.
+ *
+ *  0  Reserved (faults capture only)
+ *  1  TIM3         Scheduler tick / sampling timer, must never be delayed
+ *  1  TIM2         Microsecond clock overflow (see GAUL/Clock.h)
+ *  2  SPI2 DMA     SPI2 transactions, DMA1 Channel4 (RX) and Channel5 (TX), next one
+ *                  started from the interrupt (see GAUL/SPIBus.h)
+ *  3  USART1       GNSS RX, 1 byte every ~1ms at 9600 baud, must re-arm before the next byte
+ *  4  USART2 DMA   Telemetry TX, DMA1 Channel7 and USART2 (see GAUL/Telemetry.h)
+ *  5  SysTick      HAL tick, HAL_Delay() only from the main loop
+ *  6  EXTI15_10    Button
+ * 15  PendSV       Deferred work (see GAUL/DeferredWork.h)
+ *
+ * Each handler calls CPULOAD_EnterISR() first and CPULOAD_ExitISR() last
+ * (stm32f1xx_it.c USER CODE sections), add its ID in GAUL/CpuLoad.h.
+ *
+ * Shared state rules:
+ * - A variable is written by only one context (single writer), 8/16/32-bit
+ *   aligned accesses are atomic on Cortex-M3.
+ * - Producer/consumer buffers (circular buffer, sentence queue, deferred work)
+ *   publish data before moving their index.
+ * - Drivers on SPI2 (BMP280, NOR flash) are only called from the main loop (tasks),
+ *   and only submit transactions to the bus manager (GAUL/SPIBus.h).
+ * Interleavings of these paths are tested on the host by Tools/interleaving_test.c.
+ */
+
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
@@ -0,0 +1,148 @@
+/*
+ * AltitudeFusion.c
+ *
+ * Fuse the high rate barometer altitude with the low rate GNSS altitude above
+ * mean sea level. The barometer gives a smooth relative altitude, but drifts
+ * with temperature and weather over a long flight or descent. The GNSS gives an
+ * absolute altitude, but is noisy and lags under high dynamics.
+ *
+ * The fused altitude is the barometer altitude plus an offset. The offset starts
+ * at the pad altitude (averaged GNSS epochs on the pad), then is corrected on each
+ * accepted GNSS epoch. The drift rate is estimated from the same corrections and
+ * applied between GNSS epochs, so the output stays at the barometer rate.
+ *
+ * Barometer samples and GNSS epochs are read from the sample bus, and the fused
+ * altitude is published on BUS_TOPIC_ALTITUDE.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/AltitudeFusion.h"
+#include "GAUL/SampleBus.h"
+
+#include "math.h" // for fabsf()
+
+/**
+ * Initialize altitude fusion structure.
+ *
+ * @param fusion: pointer to an AltitudeFusion structure.
+ */
+void ALTFUSION_Init(AltitudeFusion *fusion) {
+	fusion->altitude_msl_m = 0;
+	fusion->altitude_agl_m = 0;
+	fusion->offset_m = 0;
+	fusion->drift_mps = 0;
+	fusion->pad_altitude_m = 0;
+	fusion->baro_altitude_m = 0;
+	fusion->pad_sum_m = 0;
+	fusion->pad_samples = 0;
+	fusion->pad_locked = 0;
+	fusion->timestamp_ms = 0;
+	fusion->gnss_timestamp_ms = 0;
+	fusion->baro_count = 0;
+	fusion->gnss_count = 0;
+}
+
+/**
+ * Update fused altitude with new samples from the bus: GNSS epoch first, then
+ * barometer sample. The fused altitude is published on each new barometer sample.
+ *
+ * @param fusion: pointer to an AltitudeFusion structure.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no new barometer sample
+ */
+int8_t ALTFUSION_Update(AltitudeFusion *fusion) {
+	L76LM33 gnss;
+	Barometer barometer;
+
+	if (BUS_Read(BUS_TOPIC_GNSS, &gnss, &fusion->gnss_count) == 0) {
+		ALTFUSION_UpdateGNSS(fusion, &gnss);
+	}
+
+	if (BUS_Read(BUS_TOPIC_BARO, &barometer, &fusion->baro_count) != 0) {
+		return -1; // No new barometer sample
+	}
+
+	ALTFUSION_UpdateBarometer(fusion, &barometer);
+	BUS_Publish(BUS_TOPIC_ALTITUDE, fusion);
+
+	return 0; // OK
+}
+
+/**
+ * Update fused altitude with a new barometer sample. Call this function at
+ * the barometer rate.
+ *
+ * @param fusion: pointer to an AltitudeFusion structure.
+ * @param barometer: pointer to the latest Barometer sample.
+ */
+void ALTFUSION_UpdateBarometer(AltitudeFusion *fusion, const Barometer *barometer) {
+	// Apply estimated drift since last sample
+	if (fusion->timestamp_ms != 0) {
+		float dt_s = (barometer->timestamp_ms - fusion->timestamp_ms) / 1000.0f;
+		fusion->offset_m += fusion->drift_mps * dt_s;
+	}
+
+	fusion->baro_altitude_m = barometer->altitude_m;
+	fusion->timestamp_ms = barometer->timestamp_ms;
+
+	fusion->altitude_msl_m = barometer->altitude_m + fusion->offset_m;
+	if (fusion->pad_locked) {
+		fusion->altitude_agl_m = fusion->altitude_msl_m - fusion->pad_altitude_m;
+	} else {
+		fusion->altitude_agl_m = barometer->altitude_m; // BMP280 reference is taken on the pad
+	}
+}
+
+/**
+ * Correct barometer offset and drift with a new GNSS epoch. Epochs already used,
+ * without enough satellites, with a poor HDOP or during fast vertical movements
+ * are ignored.
+ *
+ * @param fusion: pointer to an AltitudeFusion structure.
+ * @param gnss: pointer to the latest L76LM33 data.
+ *
+ * @retval 0 OK
+ * @retval -1 GNSS epoch ignored
+ */
+int8_t ALTFUSION_UpdateGNSS(AltitudeFusion *fusion, const L76LM33 *gnss) {
+	if (gnss->timestamp_ms == fusion->gnss_timestamp_ms || fusion->timestamp_ms == 0) {
+		return -1; // No new GNSS epoch or no barometer sample yet
+	}
+	if (gnss->fix_quality == 0 || gnss->satellites < ALTFUSION_MIN_SATELLITES || gnss->hdop > ALTFUSION_MAX_HDOP) {
+		return -1; // Poor GNSS epoch
+	}
+	if (fabsf(gnss->vertical_speed_mps) > ALTFUSION_MAX_VERTICAL_SPEED_MPS) {
+		return -1; // GNSS altitude lags too much
+	}
+
+	float dt_s = (gnss->timestamp_ms - fusion->gnss_timestamp_ms) / 1000.0f;
+	fusion->gnss_timestamp_ms = gnss->timestamp_ms;
+
+	// Pad altitude from averaged GNSS epochs
+	if (!fusion->pad_locked) {
+		fusion->pad_sum_m += gnss->altitude_m - fusion->baro_altitude_m;
+		fusion->pad_samples++;
+		if (fusion->pad_samples >= ALTFUSION_PAD_SAMPLES) {
+			fusion->offset_m = fusion->pad_sum_m / fusion->pad_samples;
+			fusion->pad_altitude_m = fusion->offset_m;
+			fusion->pad_locked = 1;
+		}
+		return 0; // OK
+	}
+
+	float innovation_m = gnss->altitude_m - (fusion->baro_altitude_m + fusion->offset_m);
+	if (fabsf(innovation_m) > ALTFUSION_MAX_INNOVATION_M) {
+		return -1; // GNSS outlier
+	}
+
+	// Correct offset and drift rate
+	fusion->offset_m += ALTFUSION_OFFSET_GAIN * innovation_m;
+	if (dt_s > 0) {
+		fusion->drift_mps += ALTFUSION_DRIFT_GAIN * innovation_m / dt_s;
+	}
+
+	return 0; // OK
+}
@@ -7,20 +7,143 @@
 
 #include "GAUL/Barometer.h"
 
+#include "GAUL/Clock.h"
+#include "GAUL/Fault.h"
+#include "GAUL/MedianFilter.h"
 #include "GAUL_Drivers/BMP280.h"
 
-extern SPI_HandleTypeDef hspi2;
+#include "math.h" // for fabsf(), sqrtf(), logf(), atanf()
 
 BMP280 _bmp_data;
 
+// Running median of the raw altitude samples
+MedianFilter _altitude_filter;
+
+// Estimated altitude of the alpha-beta-gamma estimator
+float _estimate_altitude_m;
+
+/**
+ * Robust prefilter between the BMP280 sample and the barometer altitude.
+ * A sample too far from the running median (e.g. corrupted SPI transfer)
+ * is replaced by the median and flagged.
+ *
+ * @param barometer: pointer to a Barometer structure to update.
+ * @param altitude_m: raw altitude from the BMP280.
+ */
+static void BAROMETER_Prefilter(Barometer *barometer, float altitude_m) {
+	float median_m = MEDIANFILTER_Update(&_altitude_filter, altitude_m);
+
+	if (fabsf(altitude_m - median_m) > BAROMETER_OUTLIER_THRESHOLD_M) {
+		barometer->altitude_m = median_m;
+		barometer->outlier = 1;
+	} else {
+		barometer->altitude_m = altitude_m;
+		barometer->outlier = 0;
+	}
+}
+
+/**
+ * Update speed and acceleration with an alpha-beta-gamma estimator
+ * on the prefiltered altitude.
+ *
+ * @param barometer: pointer to a Barometer structure to update.
+ * @param timestamp_us: timestamp of the new altitude sample.
+ */
+static void BAROMETER_Estimate(Barometer *barometer, uint64_t timestamp_us) {
+	// Microsecond timestamps, a 1 ms tick is too coarse at 25 Hz
+	float dt_s = (timestamp_us - barometer->timestamp_us) / 1000000.0f;
+	barometer->timestamp_us = timestamp_us;
+	barometer->timestamp_ms = HAL_GetTick();
+
+	if (dt_s <= 0 || dt_s > BAROMETER_ESTIMATOR_MAX_DT_S) {
+		// First sample or long gap, restart estimator
+		_estimate_altitude_m = barometer->altitude_m;
+		barometer->speed_mps = 0;
+		barometer->acceleration_mps2 = 0;
+		return;
+	}
+
+	// Predict
+	_estimate_altitude_m += barometer->speed_mps * dt_s + barometer->acceleration_mps2 * dt_s * dt_s / 2;
+	barometer->speed_mps += barometer->acceleration_mps2 * dt_s;
+
+	// Correct
+	float residual_m = barometer->altitude_m - _estimate_altitude_m;
+	_estimate_altitude_m += BAROMETER_ESTIMATOR_ALPHA * residual_m;
+	barometer->speed_mps += BAROMETER_ESTIMATOR_BETA * residual_m / dt_s;
+	barometer->acceleration_mps2 += 2 * BAROMETER_ESTIMATOR_GAMMA * residual_m / (dt_s * dt_s);
+}
+
+/**
+ * Predict apogee altitude and time to apogee during coast, from the current
+ * speed and acceleration with a quadratic drag model:
+ * acceleration = -g - drag * speed^2
+ *
+ * The drag is estimated from the measured deceleration, then:
+ * apogee = altitude + ln(1 + drag * speed^2 / g) / (2 * drag)
+ * time = atan(speed * sqrt(drag / g)) / sqrt(g * drag)
+ *
+ * @param barometer: pointer to a Barometer structure to update.
+ */
+static void BAROMETER_PredictApogee(Barometer *barometer) {
+	float speed = barometer->speed_mps;
+
+	if (speed < BAROMETER_COAST_MIN_SPD_MPS || barometer->acceleration_mps2 >= 0) {
+		// Under thrust or going down, no prediction
+		barometer->coasting = 0;
+		barometer->drag_per_m = 0;
+		barometer->predicted_apogee_m = barometer->altitude_m;
+		barometer->time_to_apogee_s = 0;
+		return;
+	}
+
+	// Update drag estimate (low pass, drag can't be negative)
+	float drag = (-barometer->acceleration_mps2 - BAROMETER_GRAVITY_MPSS) / (speed * speed);
+	if (drag < 0) {
+		drag = 0;
+	}
+	if (barometer->coasting) {
+		drag = barometer->drag_per_m + BAROMETER_DRAG_FILTER * (drag - barometer->drag_per_m);
+	}
+	barometer->drag_per_m = drag;
+	barometer->coasting = 1;
+
+	if (drag < 1e-6f) {
+		// Ballistic
+		barometer->predicted_apogee_m = _estimate_altitude_m + speed * speed / (2 * BAROMETER_GRAVITY_MPSS);
+		barometer->time_to_apogee_s = speed / BAROMETER_GRAVITY_MPSS;
+	} else {
+		barometer->predicted_apogee_m = _estimate_altitude_m + logf(1 + drag * speed * speed / BAROMETER_GRAVITY_MPSS) / (2 * drag);
+		barometer->time_to_apogee_s = atanf(speed * sqrtf(drag / BAROMETER_GRAVITY_MPSS)) / sqrtf(BAROMETER_GRAVITY_MPSS * drag);
+	}
+}
+
 /**
- * Initialize sensors for barometer.
+ * Initialize sensors for barometer, and measure the ground reference pressure
+ * (~2 s). After a fault reset out of the pad, the reference of the fault record
+ * is used instead: the rocket is not on the ground anymore.
  *
  * @retval 0 OK
  * @retval -1 ERROR
  */
 int8_t BAROMETER_Init() {
-	if (BMP280_Init(&_bmp_data, &hspi2) != 0) {
+	const FaultFlight *flight = FAULT_GetFlight();
+
+	if (BMP280_Init(&_bmp_data) != 0) {
+		return -1;
+	}
+
+	// Delay to get first measurement
+	HAL_Delay(200);
+
+	if (flight != NULL) {
+		_bmp_data.press_ref_Pa = flight->press_ref_Pa;
+	} else if (BMP280_MeasureReference(&_bmp_data, 40, 50) != 0 || _bmp_data.press_ref_Pa < 90000.0 || _bmp_data.press_ref_Pa > 110000.0) {
+		_bmp_data.press_ref_Pa = 101325.0; // Default value if error or extreme values
+	}
+	FAULT_SaveReference(_bmp_data.press_ref_Pa);
+
+	if (MEDIANFILTER_Init(&_altitude_filter, BAROMETER_MEDIAN_WINDOW) != 0) {
 		return -1;
 	}
 
@@ -29,7 +152,9 @@ int8_t BAROMETER_Init() {
 
 /**
  * Reads temperature and pressure values from the sensors,
- * then calculate the altitude from them.
+ * then calculate the altitude from them. The altitude goes through
+ * the median prefilter, then updates the speed, acceleration and
+ * apogee prediction.
  *
  * @retval 0 OK
  * @retval -1 ERROR
@@ -38,8 +163,11 @@ int8_t BAROMETER_ReadAltitude(Barometer *barometer) {
 	if (BMP280_ReadAltitude(&_bmp_data) != 0) {
 		return -1;
 	}
+	uint64_t timestamp_us = CLOCK_GetTime_us();
 
-	barometer->altitude_m = _bmp_data.alt_m;
+	BAROMETER_Prefilter(barometer, _bmp_data.alt_m);
+	BAROMETER_Estimate(barometer, timestamp_us);
+	BAROMETER_PredictApogee(barometer);
 
 	return 0;
 }
@@ -57,6 +185,7 @@ int8_t BAROMETER_ReadAltitude_Validation(Barometer *barometer) {
 	if (BMP280_ReadAltitude(&_bmp_data) != 0) {
 		return -1; // Error reading altitude
 	}
+	uint64_t timestamp_us = CLOCK_GetTime_us();
 
 	if (_bmp_data.temp_C < BAROMETER_MIN_TEMP_C || _bmp_data.temp_C > BAROMETER_MAX_TEMP_C) {
 		return -2; // Temperature exceed thresholds
@@ -70,7 +199,22 @@ int8_t BAROMETER_ReadAltitude_Validation(Barometer *barometer) {
 		return -2; // Altitude exceed thresholds
 	}
 
-	barometer->altitude_m = _bmp_data.alt_m;
+	BAROMETER_Prefilter(barometer, _bmp_data.alt_m);
+	BAROMETER_Estimate(barometer, timestamp_us);
+	BAROMETER_PredictApogee(barometer);
 
 	return 0;
 }
+
+/**
+ * Check if apogee is predicted soon, so logging and sampling rates can be
+ * raised ahead of apogee.
+ *
+ * @param barometer: pointer to a Barometer structure.
+ *
+ * @retval 1 apogee predicted in less than BAROMETER_APOGEE_PREARM_S
+ * @retval 0 otherwise
+ */
+uint8_t BAROMETER_ApogeeImminent(const Barometer *barometer) {
+	return barometer->coasting && barometer->time_to_apogee_s < BAROMETER_APOGEE_PREARM_S;
+}
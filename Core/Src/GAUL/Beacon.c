@@ -0,0 +1,120 @@
+/*
+ * Beacon.c
+ *
+ * Recovery beacon once landed. The GNSS module sleeps (standby), wakes up every
+ * BEACON_PERIOD_MS to get a fresh fix, then a compact position beacon is sent
+ * with the telemetry downlink. The last good fix is kept and sent with its age if no fresh fix
+ * is found before BEACON_FIX_TIMEOUT_MS.
+ *
+ * Beacon format (NMEA like, integer fields):
+ * $GAULB,<latitude x1e6>,<longitude x1e6>,<altitude m>,<fix age s>,<satellites>*<checksum><CR><LF>
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Beacon.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/Telemetry.h"
+
+#include "stdio.h" // for snprintf()
+
+Beacon _beacon;
+
+/**
+ * Initialize beacon when landing. The GNSS module is expected to be in full
+ * power mode, the first beacon is sent as soon as a fix stamped after this call
+ * is found (the bus may still hold an in-flight fix).
+ */
+void BEACON_Init() {
+	_beacon.last_fix.fix_quality = 0;
+	_beacon.last_fix.timestamp_ms = 0;
+	_beacon.state = BEACON_STATE_ACQUIRE;
+	_beacon.state_ms = HAL_GetTick();
+	_beacon.landed_ms = _beacon.state_ms;
+	_beacon.sent = 0;
+	_beacon.gnss_count = 0;
+}
+
+/**
+ * Update beacon duty cycle with the latest GNSS epoch from the bus. Call this
+ * function frequently once landed.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t BEACON_Update() {
+	uint32_t now_ms = HAL_GetTick();
+	uint8_t fresh_fix = 0;
+	L76LM33 gnss;
+
+	// Keep last good fix, ignore fixes from before landing
+	if (BUS_Read(BUS_TOPIC_GNSS, &gnss, &_beacon.gnss_count) == 0 && gnss.fix_quality != 0
+			&& (int32_t)(gnss.timestamp_ms - _beacon.landed_ms) >= 0
+			&& gnss.timestamp_ms != _beacon.last_fix.timestamp_ms) {
+		_beacon.last_fix = gnss;
+		fresh_fix = 1;
+	}
+
+	if (_beacon.state == BEACON_STATE_ACQUIRE) {
+		if (fresh_fix || now_ms - _beacon.state_ms >= BEACON_FIX_TIMEOUT_MS) {
+			// Send position, then GNSS module goes back to standby
+			_beacon.state = BEACON_STATE_SLEEP;
+			_beacon.state_ms = now_ms;
+			if (BEACON_Send() != 0 || L76LM33_SetMode(L76LM33_MODE_STANDBY) != 0) {
+				return -1; // Error with telemetry or GNSS UART
+			}
+		}
+	} else {
+		if (now_ms - _beacon.state_ms >= BEACON_PERIOD_MS) {
+			// Wake up GNSS module for a fresh fix
+			_beacon.state = BEACON_STATE_ACQUIRE;
+			_beacon.state_ms = now_ms;
+			if (L76LM33_SetMode(L76LM33_MODE_FULL_POWER) != 0) {
+				return -1; // Error with UART
+			}
+		}
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Send last good fix as a compact position beacon.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t BEACON_Send() {
+	char beacon[64];
+	uint32_t age_s = 0xFFFF; // No fix yet
+	if (_beacon.last_fix.timestamp_ms != 0) {
+		age_s = (HAL_GetTick() - _beacon.last_fix.timestamp_ms) / 1000;
+	}
+
+	int length = snprintf(beacon, sizeof(beacon), "$GAULB,%ld,%ld,%ld,%lu,%u*",
+			(long)(_beacon.last_fix.latitude * 1e6f),
+			(long)(_beacon.last_fix.longitude * 1e6f),
+			(long)_beacon.last_fix.altitude_m,
+			(unsigned long)age_s,
+			_beacon.last_fix.satellites);
+	if (length < 0 || length > sizeof(beacon) - 5) {
+		return -1; // Error, beacon too long
+	}
+
+	// NMEA checksum (XOR of characters between '$' and '*')
+	uint8_t checksum = 0;
+	for (int i = 1; i < length - 1; i++) {
+		checksum ^= beacon[i];
+	}
+	length += snprintf(&beacon[length], sizeof(beacon) - length, "%02X\r\n", checksum);
+
+	// Sent between telemetry frames
+	if (TELEMETRY_Write(beacon, length) != 0) {
+		return -1; // Error, telemetry TX ring full
+	}
+
+	_beacon.sent++;
+
+	return 0; // OK
+}
@@ -0,0 +1,87 @@
+/*
+ * Clock.c
+ *
+ * 64-bit monotonic microsecond clock. A hardware timer free runs at 1 MHz over
+ * its 16-bit counter, and its update interrupt (every 65.536 ms) counts the
+ * overflows. The time is the overflow count followed by the counter value, it
+ * doesn't wrap during the life of the board.
+ *
+ * Any context can read the clock: an overflow not handled yet by the interrupt
+ * (reader with higher priority, or interrupts disabled) is detected with the
+ * update flag.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Clock.h"
+
+// Pointer to TIM handler
+TIM_HandleTypeDef *CLOCK_htim;
+
+// Counter overflows, incremented by the timer update interrupt
+volatile uint32_t _clock_overflows = 0;
+
+/**
+ * Initialize clock and start its timer. The timer must count at 1 MHz
+ * over its full 16-bit range (period 65535).
+ *
+ * @param htim: pointer to a HAL TIM handler.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t CLOCK_Init(TIM_HandleTypeDef *htim) {
+	CLOCK_htim = htim;
+	_clock_overflows = 0;
+
+	// Update flag set by the timer initialization, not an overflow
+	__HAL_TIM_CLEAR_FLAG(CLOCK_htim, TIM_FLAG_UPDATE);
+
+	if (HAL_TIM_Base_Start_IT(CLOCK_htim) != HAL_OK) {
+		return -1; // Error with TIM
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Count a counter overflow. Call this function from the timer interrupt
+ * handler, before HAL_TIM_IRQHandler().
+ *
+ * The flag is cleared and the count incremented together, a reader preempting
+ * the interrupt never sees the overflow twice or not at all.
+ */
+void CLOCK_IRQHandler() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (__HAL_TIM_GET_FLAG(CLOCK_htim, TIM_FLAG_UPDATE) != RESET) {
+		__HAL_TIM_CLEAR_FLAG(CLOCK_htim, TIM_FLAG_UPDATE);
+		_clock_overflows++;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Get time since the clock started.
+ *
+ * @return Time in us
+ */
+uint64_t CLOCK_GetTime_us() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t overflows = _clock_overflows;
+	uint32_t counter = __HAL_TIM_GET_COUNTER(CLOCK_htim);
+	if (__HAL_TIM_GET_FLAG(CLOCK_htim, TIM_FLAG_UPDATE) != RESET) {
+		// Overflow not counted yet, read the counter again after the overflow
+		overflows++;
+		counter = __HAL_TIM_GET_COUNTER(CLOCK_htim);
+	}
+
+	__set_PRIMASK(primask);
+
+	return ((uint64_t)overflows << CLOCK_COUNTER_BITS) | counter;
+}
@@ -0,0 +1,201 @@
+/*
+ * CpuLoad.c
+ *
+ * CPU load meter using the DWT cycle counter. Each interrupt handler calls
+ * CPULOAD_EnterISR() and CPULOAD_ExitISR() (stm32f1xx_it.c), the scheduler
+ * accounts its tasks and its sleep time. Time spent in a nested interrupt is
+ * only counted for the nested interrupt, and time spent in interrupts is
+ * removed from the task or sleep it preempted.
+ *
+ * Loads are computed over a window (each CPULOAD_Update() call) and stored in
+ * _cpuload, readable from the debugger (live expressions) or for telemetry.
+ *
+ * The cycle counter stops while the core sleeps (unless a debugger keeps the
+ * clocks running), so sleep time is measured with the microsecond clock.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/CpuLoad.h"
+#include "GAUL/Clock.h"
+
+CpuLoad _cpuload;
+
+// Interrupt nesting: cycle counter at entry and cycles of nested interrupts, per level
+uint8_t _cpuload_depth = 0;
+uint32_t _cpuload_start[CPULOAD_MAX_NESTING];
+uint32_t _cpuload_nested[CPULOAD_MAX_NESTING];
+
+// Cycles spent in interrupts preempting thread mode (tasks, main loop, sleep)
+volatile uint32_t _cpuload_isr_cycles = 0;
+
+/**
+ * Add a measurement to a counter.
+ *
+ * @param counter: pointer to a CpuLoadCounter.
+ * @param cycles: cycles of the call.
+ */
+static void CPULOAD_Count(CpuLoadCounter *counter, uint32_t cycles) {
+	counter->count++;
+	counter->cycles += cycles;
+	if (cycles > counter->max_cycles) {
+		counter->max_cycles = cycles;
+	}
+}
+
+/**
+ * Start the DWT cycle counter and clear statistics. Call this function
+ * after CLOCK_Init().
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR cycle counter not available
+ */
+int8_t CPULOAD_Init() {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	for (uint8_t i = 0; i < CPULOAD_ISR_COUNT; i++) {
+		_cpuload.isr[i] = (CpuLoadCounter){ 0 };
+	}
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		_cpuload.task[i] = (CpuLoadCounter){ 0 };
+	}
+	_cpuload.idle_us = 0;
+	_cpuload.idle_permille = 0;
+	_cpuload.window_us = CLOCK_GetTime_us();
+	_cpuload.windows = 0;
+
+	if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0) {
+		return -1; // Error, no cycle counter
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Start accounting an interrupt. Call this function first in the handler.
+ */
+void CPULOAD_EnterISR() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (_cpuload_depth < CPULOAD_MAX_NESTING) {
+		_cpuload_start[_cpuload_depth] = DWT->CYCCNT;
+		_cpuload_nested[_cpuload_depth] = 0;
+	}
+	_cpuload_depth++;
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Stop accounting an interrupt. Call this function last in the handler.
+ *
+ * @param isr: interrupt ID.
+ */
+void CPULOAD_ExitISR(CpuLoadIsr isr) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t depth = --_cpuload_depth;
+	if (depth < CPULOAD_MAX_NESTING) {
+		uint32_t elapsed = DWT->CYCCNT - _cpuload_start[depth];
+		CPULOAD_Count(&_cpuload.isr[isr], elapsed - _cpuload_nested[depth]);
+
+		if (depth > 0) {
+			_cpuload_nested[depth - 1] += elapsed; // Preempted interrupt
+		} else {
+			_cpuload_isr_cycles += elapsed; // Preempted thread
+		}
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Get the thread mode cycle counter: cycles not spent in interrupts.
+ * Only use it for differences.
+ *
+ * @return Cycles
+ */
+uint32_t CPULOAD_GetThreadCycles() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t cycles = DWT->CYCCNT - _cpuload_isr_cycles;
+	__set_PRIMASK(primask);
+
+	return cycles;
+}
+
+/**
+ * Account a task run.
+ *
+ * @param task_id: scheduler task ID.
+ * @param cycles: thread cycles of the run (see CPULOAD_GetThreadCycles()).
+ */
+void CPULOAD_AddTask(int8_t task_id, uint32_t cycles) {
+	if (task_id >= 0 && task_id < SCHEDULER_MAX_TASKS) {
+		CPULOAD_Count(&_cpuload.task[task_id], cycles);
+	}
+}
+
+/**
+ * Sleep until the next interrupt, and account the sleep time. May be called
+ * with interrupts masked (see SCHEDULER_Dispatch()): the interrupt waking up
+ * the core then runs after this function.
+ */
+void CPULOAD_Sleep() {
+	uint32_t isr_cycles = _cpuload_isr_cycles;
+	uint64_t start_us = CLOCK_GetTime_us();
+
+	HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+
+	// Interrupts woke up the core and ran before coming back here (unless masked)
+	uint32_t sleep_us = CLOCK_GetTime_us() - start_us;
+	uint32_t isr_us = (_cpuload_isr_cycles - isr_cycles) / (SystemCoreClock / 1000000);
+	if (sleep_us > isr_us) {
+		_cpuload.idle_us += sleep_us - isr_us;
+	}
+}
+
+/**
+ * Compute loads over the window since the last call, then start a new window.
+ * Call this function periodically (less than ~50 s apart, cycle counter range).
+ */
+void CPULOAD_Update() {
+	uint64_t now_us = CLOCK_GetTime_us();
+	uint32_t window_us = now_us - _cpuload.window_us;
+	if (window_us == 0) {
+		return; // Empty window
+	}
+	uint64_t window_cycles = (uint64_t)window_us * (SystemCoreClock / 1000000);
+
+	for (uint8_t i = 0; i < CPULOAD_ISR_COUNT; i++) {
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		uint32_t cycles = _cpuload.isr[i].cycles;
+		_cpuload.isr[i].cycles = 0;
+		__set_PRIMASK(primask);
+		_cpuload.isr[i].load_permille = (uint64_t)cycles * 1000 / window_cycles;
+	}
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		_cpuload.task[i].load_permille = (uint64_t)_cpuload.task[i].cycles * 1000 / window_cycles;
+		_cpuload.task[i].cycles = 0;
+	}
+	_cpuload.idle_permille = (uint64_t)_cpuload.idle_us * 1000 / window_us;
+	_cpuload.idle_us = 0;
+
+	_cpuload.window_us = now_us;
+	_cpuload.windows++;
+}
+
+/**
+ * Get CPU load statistics (for debug or telemetry).
+ *
+ * @return Pointer to the CpuLoad statistics
+ */
+const CpuLoad *CPULOAD_Get() {
+	return &_cpuload;
+}
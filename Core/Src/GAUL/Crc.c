@@ -0,0 +1,48 @@
+/*
+ * Crc.c
+ *
+ * The CRC unit holds a single running CRC: call these functions from the main
+ * loop only (not from interrupts).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Crc.h"
+
+/**
+ * Initialize the CRC unit (AHB clock).
+ */
+void CRC32_Init() {
+	__HAL_RCC_CRC_CLK_ENABLE();
+	CRC->CR = CRC_CR_RESET;
+}
+
+/**
+ * Compute the CRC-32 of words, from the initial value.
+ *
+ * @param words: pointer to the first word (word aligned).
+ * @param count: number of words.
+ *
+ * @return CRC-32
+ */
+uint32_t CRC32_Compute(const uint32_t *words, uint32_t count) {
+	CRC->CR = CRC_CR_RESET;
+	return CRC32_Accumulate(words, count);
+}
+
+/**
+ * Continue the CRC-32 of the previous call with more words (data split in
+ * several buffers).
+ *
+ * @param words: pointer to the first word (word aligned).
+ * @param count: number of words.
+ *
+ * @return CRC-32 of every word since the last CRC32_Compute()
+ */
+uint32_t CRC32_Accumulate(const uint32_t *words, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		CRC->DR = words[i];
+	}
+	return CRC->DR;
+}
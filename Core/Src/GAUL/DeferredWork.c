@@ -0,0 +1,81 @@
+/*
+ * DeferredWork.c
+ *
+ * Deferred work queue (bottom half). Interrupt handlers only do the time
+ * critical part of their job, then post a work item. Work items run later in
+ * PendSV, which has the lowest priority: they still preempt the main loop, but
+ * never delay another interrupt.
+ *
+ * Any interrupt can post (short critical section), only PendSV consumes.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/DeferredWork.h"
+
+DeferredItem _deferred_queue[DEFERRED_QUEUE_SIZE];
+volatile uint32_t _deferred_head = 0; // Next item to run (PendSV only)
+volatile uint32_t _deferred_tail = 0; // Next free item (posting interrupts)
+
+DeferredStats _deferred_stats;
+
+/**
+ * Post a work item to run in PendSV. Can be called from any interrupt
+ * or from the main loop.
+ *
+ * @param function: function to run.
+ * @param argument: argument given to the function.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR queue full, work item dropped
+ */
+int8_t DEFERRED_Post(DeferredFunction function, uint32_t argument) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t pending = _deferred_tail - _deferred_head;
+	if (pending >= DEFERRED_QUEUE_SIZE) {
+		_deferred_stats.dropped++;
+		__set_PRIMASK(primask);
+		return -1; // Error, queue full
+	}
+
+	DeferredItem *item = &_deferred_queue[_deferred_tail & (DEFERRED_QUEUE_SIZE - 1)];
+	item->function = function;
+	item->argument = argument;
+	_deferred_tail++;
+
+	_deferred_stats.posted++;
+	if (pending + 1 > _deferred_stats.max_pending) {
+		_deferred_stats.max_pending = pending + 1;
+	}
+
+	__set_PRIMASK(primask);
+
+	// Run work items when no other interrupt is active
+	SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+
+	return 0; // OK
+}
+
+/**
+ * Run all pending work items. Called from PendSV_Handler.
+ */
+void DEFERRED_Run() {
+	while (_deferred_head != _deferred_tail) {
+		DeferredItem item = _deferred_queue[_deferred_head & (DEFERRED_QUEUE_SIZE - 1)];
+		_deferred_head++;
+
+		item.function(item.argument);
+	}
+}
+
+/**
+ * Get deferred work statistics (for debug or telemetry).
+ *
+ * @return Pointer to statistics
+ */
+const DeferredStats *DEFERRED_GetStats() {
+	return &_deferred_stats;
+}
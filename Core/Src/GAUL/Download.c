@@ -0,0 +1,728 @@
+/*
+ * Download.c
+ *
+ * Post-flight download of the recorder log (GAUL/Recorder.h) over the telemetry
+ * UART, protocol in GAUL/DownloadProtocol.h (host side in
+ * Tools/download_receiver.c). The UART receives one byte per interrupt into an
+ * RX ring at all times, host packets are parsed by the download task.
+ *
+ * On HELLO (out of flight only), telemetry is paused, INFO is sent at the
+ * telemetry baud rate, then the UART is reconfigured to the requested baud rate
+ * if the divisor of its clock is close enough. Blocks are read from flash
+ * straight into a packet, COBS encoded into one of two frame buffers and sent
+ * by DMA: the TX complete interrupt starts the next built frame, so the UART
+ * never waits for the task. The recorder must not run meanwhile (the log would
+ * move), see DOWNLOAD_IsActive().
+ *
+ * At most DOWNLOAD_WINDOW_BLOCKS blocks are sent ahead of the acknowledged
+ * offset (go-back-N): a NACK, or no new ACK for the window transfer time plus
+ * DOWNLOAD_ACK_TIMEOUT_MS, drops the frames not sent yet and sends again from
+ * the first missing block. Once DONE was sent, the host may have the log erased
+ * (ERASE with the size and CRC-32 of DONE), the only operator path to
+ * RECORDER_Erase(). The default 921600 baud is 39/16 of the 36 MHz APB1 clock (0.16% error), higher
+ * rates are accepted up to APB1 / 16 when the host adapter supports them.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Download.h"
+#include "GAUL/Recorder.h"
+#include "GAUL/Telemetry.h"
+#include "GAUL/FlightState.h"
+#include "GAUL/Crc.h"
+
+#include "string.h" // for memcpy()
+
+// Packets, word aligned for the CRC unit
+typedef union {
+	DownloadHeader header;
+	DownloadHello hello;
+	DownloadAck ack;
+	DownloadBye bye;
+	DownloadErase erase;
+	uint32_t words[DOWNLOAD_MAX_RX_FRAME / 4];
+} DownloadHostPacket;
+
+typedef union {
+	DownloadHeader header;
+	DownloadInfo info;
+	DownloadData data;
+	DownloadDone done;
+	DownloadErased erased;
+	uint32_t words[DOWNLOAD_MAX_PACKET / 4];
+} DownloadBoardPacket;
+
+// Pointer to UART handler
+UART_HandleTypeDef *DOWNLOAD_huart = NULL;
+
+DownloadState _download_state = DOWNLOAD_STATE_IDLE;
+DownloadStats _download_stats;
+
+// RX ring, filled by the RX complete interrupt
+uint8_t _download_rx_byte;
+uint8_t _download_rx_ring[DOWNLOAD_RX_RING_SIZE];
+volatile uint32_t _download_rx_head;
+volatile uint32_t _download_rx_tail;
+
+// Frame being received (main loop)
+uint8_t _download_rx_frame[DOWNLOAD_MAX_RX_FRAME];
+uint8_t _download_rx_length;	// Above DOWNLOAD_MAX_RX_FRAME: too long, dropped at the next delimiter
+
+// TX frame buffers, built and sent in order
+DownloadTxBuffer _download_tx[DOWNLOAD_TX_BUFFERS];
+uint8_t _download_tx_fill;			// Next buffer built (main loop)
+volatile uint8_t _download_tx_send;	// Next buffer sent (TX interrupt)
+volatile int8_t _download_tx_sending = -1;	// Buffer of the current DMA transfer, -1 if idle
+
+DownloadBoardPacket _download_packet;
+
+// Session
+uint32_t _download_telemetry_baud_rate;	// Restored when leaving
+uint32_t _download_baud_rate;			// Used after INFO
+uint32_t _download_size;
+uint8_t _download_started;		// 1 after the first NACK
+uint8_t _download_done;			// 1: DONE to send
+uint8_t _download_completed;	// 1: every byte acknowledged once
+uint8_t _download_done_sent;	// 1: DONE sent for the whole log, ERASE accepted
+uint32_t _download_log_crc;		// CRC-32 of the whole log sent in DONE
+uint8_t _download_erase;		// 1: ERASE accepted, log to erase
+uint8_t _download_erased;		// 1: log erased in this session
+uint8_t _download_erase_reply;	// 1: ERASED to send
+int8_t _download_erase_status;	// DOWNLOAD_ERASE_*
+uint32_t _download_offset;		// Next block sent
+uint32_t _download_sent_end;	// End of the highest block sent (resent blocks are below)
+uint32_t _download_acked;		// Every byte below was received by the host
+uint32_t _download_acked_bytes;	// Bytes acknowledged in this session (throughput)
+uint32_t _download_progress_ms;	// Last ACK or NACK
+uint32_t _download_ack_timeout_ms;	// Window transfer time + DOWNLOAD_ACK_TIMEOUT_MS
+uint32_t _download_rx_ms;		// Last valid host packet
+uint32_t _download_start_ms;	// INFO sent
+
+/**
+ * Start the DMA transfer of the next built frame if the UART is idle. Call with
+ * interrupts disabled, or from the TX complete callback.
+ */
+static void DOWNLOAD_StartTx() {
+	if (_download_tx_sending >= 0) {
+		return; // Busy
+	}
+
+	uint8_t index = _download_tx_send;
+	DownloadTxBuffer *buffer = &_download_tx[index];
+	if (buffer->state != DOWNLOAD_TX_READY) {
+		return; // Nothing to send
+	}
+
+	buffer->state = DOWNLOAD_TX_SENDING;
+	_download_tx_sending = index;
+	_download_tx_send = (index + 1) % DOWNLOAD_TX_BUFFERS;
+	if (HAL_UART_Transmit_DMA(DOWNLOAD_huart, buffer->frame, buffer->length) != HAL_OK) {
+		buffer->state = DOWNLOAD_TX_FREE; // Lost, the host sends a NACK
+		_download_tx_sending = -1;
+		_download_stats.tx_errors++;
+	}
+}
+
+/**
+ * Check if every frame was sent.
+ *
+ * @retval 1 idle
+ * @retval 0 frames built or being sent
+ */
+static uint8_t DOWNLOAD_TxIdle() {
+	for (uint8_t i = 0; i < DOWNLOAD_TX_BUFFERS; i++) {
+		if (_download_tx[i].state != DOWNLOAD_TX_FREE) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Drop the frames built but not sent yet (go back), the current transfer ends
+ * normally.
+ */
+static void DOWNLOAD_DropPending() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	for (uint8_t i = 0; i < DOWNLOAD_TX_BUFFERS; i++) {
+		if (_download_tx[i].state == DOWNLOAD_TX_READY) {
+			_download_tx[i].state = DOWNLOAD_TX_FREE;
+		}
+	}
+	_download_tx_fill = _download_tx_send;
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Finish the packet being built (header, CRC after the body), encode it in the
+ * next frame buffer and start sending.
+ *
+ * @param type: DOWNLOAD_PACKET_*.
+ * @param length: body length (multiple of 4), already in the packet.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no free frame buffer
+ */
+static int8_t DOWNLOAD_Queue(uint8_t type, uint16_t length) {
+	DownloadTxBuffer *buffer = &_download_tx[_download_tx_fill];
+	if (buffer->state != DOWNLOAD_TX_FREE) {
+		return -1; // Error, no free frame buffer
+	}
+
+	_download_packet.header = (DownloadHeader){ .type = type, .version = DOWNLOAD_PROTOCOL_VERSION, .length = length };
+	uint32_t crc = CRC32_Compute(_download_packet.words, (sizeof(DownloadHeader) + length) / 4);
+	memcpy((uint8_t *)&_download_packet + sizeof(DownloadHeader) + length, &crc, sizeof(crc));
+
+	buffer->length = COBS_Encode((const uint8_t *)&_download_packet, sizeof(DownloadHeader) + length + sizeof(crc),
+			buffer->frame);
+	buffer->state = DOWNLOAD_TX_READY;
+	_download_tx_fill = (_download_tx_fill + 1) % DOWNLOAD_TX_BUFFERS;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	DOWNLOAD_StartTx();
+	__set_PRIMASK(primask);
+
+	return 0; // OK
+}
+
+/**
+ * Check a baud rate against the UART clock: the divisor has 1/16 steps.
+ *
+ * @param baud_rate: requested baud rate.
+ *
+ * @retval 1 accepted
+ * @retval 0 out of range or divisor error above DOWNLOAD_MAX_BAUD_ERROR_PERMILLE
+ */
+static uint8_t DOWNLOAD_CheckBaudRate(uint32_t baud_rate) {
+	// USART1 on APB2, other UARTs on APB1 (same as the HAL)
+	uint32_t pclk = DOWNLOAD_huart->Instance == USART1 ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+
+	if (baud_rate == 0 || baud_rate > pclk / 16) {
+		return 0;
+	}
+	uint32_t divisor = (pclk + baud_rate / 2) / baud_rate; // In 1/16 of the 16x oversampling divisor
+	uint32_t actual = pclk / divisor;
+	uint32_t error = actual > baud_rate ? actual - baud_rate : baud_rate - actual;
+
+	return error * 1000 / baud_rate <= DOWNLOAD_MAX_BAUD_ERROR_PERMILLE;
+}
+
+/**
+ * Reconfigure the UART baud rate (no transfer in progress), then receive again.
+ * Partial frames received at the old baud rate are dropped.
+ *
+ * @param baud_rate: new baud rate.
+ */
+static void DOWNLOAD_SetBaudRate(uint32_t baud_rate) {
+	HAL_UART_AbortReceive(DOWNLOAD_huart);
+	DOWNLOAD_huart->Init.BaudRate = baud_rate;
+	if (HAL_UART_Init(DOWNLOAD_huart) != HAL_OK) {
+		_download_stats.tx_errors++;
+	}
+
+	_download_rx_tail = _download_rx_head;
+	_download_rx_length = 0;
+	HAL_UART_Receive_IT(DOWNLOAD_huart, &_download_rx_byte, 1);
+}
+
+/**
+ * Move the acknowledged offset forward: the host received every byte below.
+ *
+ * @param offset: new acknowledged offset.
+ * @param now_ms: current tick.
+ */
+static void DOWNLOAD_Acknowledge(uint32_t offset, uint32_t now_ms) {
+	if (offset > _download_acked) {
+		_download_acked_bytes += offset - _download_acked;
+	}
+	_download_acked = offset;
+	if (_download_offset < offset) {
+		_download_offset = offset;
+	}
+	_download_progress_ms = now_ms;
+
+	if (_download_acked == _download_size) {
+		_download_done = 1;
+		if (!_download_completed) {
+			_download_completed = 1;
+			_download_stats.completed++;
+			_download_stats.duration_ms = now_ms - _download_start_ms;
+			_download_stats.bytes_per_s = (uint64_t)_download_acked_bytes * 1000
+					/ (_download_stats.duration_ms != 0 ? _download_stats.duration_ms : 1);
+		}
+	}
+}
+
+/**
+ * Handle a valid host packet.
+ *
+ * @param packet: decoded packet (CRC checked).
+ * @param now_ms: current tick.
+ */
+static void DOWNLOAD_HandlePacket(const DownloadHostPacket *packet, uint32_t now_ms) {
+	uint8_t type = packet->header.type;
+	uint16_t length = packet->header.length;
+	FlightState flight_state = FLIGHT_GetState();
+
+	if (type == DOWNLOAD_PACKET_HELLO && length == DOWNLOAD_BODY_LENGTH(DownloadHello)) {
+		if (flight_state == FLIGHT_STATE_ASCENT || flight_state == FLIGHT_STATE_DESCENT) {
+			_download_stats.refused++;
+			return; // Never in flight
+		}
+		if (_download_state == DOWNLOAD_STATE_IDLE) {
+			_download_telemetry_baud_rate = DOWNLOAD_huart->Init.BaudRate;
+			TELEMETRY_Pause(1);
+		} else if (_download_state != DOWNLOAD_STATE_ACTIVE) {
+			return; // INFO already coming, or leaving
+		}
+		// INFO at the current baud rate (again if the host restarted during a download)
+		DOWNLOAD_DropPending();
+		_download_baud_rate = DOWNLOAD_CheckBaudRate(packet->hello.baud_rate) ? packet->hello.baud_rate
+				: DOWNLOAD_huart->Init.BaudRate;
+		_download_state = DOWNLOAD_STATE_INFO;
+		_download_rx_ms = now_ms;
+		return;
+	}
+	if (_download_state != DOWNLOAD_STATE_ACTIVE) {
+		return; // Only HELLO out of a download
+	}
+	_download_rx_ms = now_ms;
+
+	switch (type) {
+	case DOWNLOAD_PACKET_NACK:
+		if (length != DOWNLOAD_BODY_LENGTH(DownloadAck) || packet->ack.offset > _download_size
+				|| packet->ack.offset % DOWNLOAD_BLOCK_SIZE != 0) {
+			_download_stats.rx_errors++;
+			return; // Error, invalid offset
+		}
+		if (_download_started) {
+			_download_stats.nacks++;
+		} else {
+			_download_acked = packet->ack.offset; // Start, or resume: bytes below were received before
+			_download_started = 1;
+		}
+		DOWNLOAD_DropPending();
+		_download_offset = packet->ack.offset;
+		DOWNLOAD_Acknowledge(packet->ack.offset, now_ms);
+		break;
+
+	case DOWNLOAD_PACKET_ACK:
+		if (length != DOWNLOAD_BODY_LENGTH(DownloadAck)) {
+			_download_stats.rx_errors++;
+			return; // Error, invalid packet
+		}
+		// Late or duplicate ACKs are ignored, an ACK past a go back skips the blocks received
+		if (_download_started && packet->ack.offset > _download_acked && packet->ack.offset <= _download_sent_end) {
+			DOWNLOAD_Acknowledge(packet->ack.offset, now_ms);
+		}
+		break;
+
+	case DOWNLOAD_PACKET_ERASE:
+		if (length != DOWNLOAD_BODY_LENGTH(DownloadErase)) {
+			_download_stats.rx_errors++;
+			return; // Error, invalid packet
+		}
+		// A repeated ERASE only gets ERASED again
+		if (!_download_erased && !_download_erase) {
+			if (_download_done_sent && packet->erase.size == _download_size
+					&& packet->erase.log_crc == _download_log_crc) {
+				_download_erase = 1;
+			} else {
+				_download_erase_status = DOWNLOAD_ERASE_REFUSED;
+				_download_stats.refused++;
+			}
+		}
+		_download_erase_reply = 1;
+		break;
+
+	case DOWNLOAD_PACKET_BYE:
+		_download_state = DOWNLOAD_STATE_LEAVE;
+		break;
+
+	default:
+		_download_stats.rx_errors++;
+		break;
+	}
+}
+
+/**
+ * Parse host frames from the RX ring.
+ *
+ * @param now_ms: current tick.
+ */
+static void DOWNLOAD_Receive(uint32_t now_ms) {
+	DownloadHostPacket packet;
+
+	while (_download_rx_tail != _download_rx_head) {
+		uint8_t byte = _download_rx_ring[_download_rx_tail & (DOWNLOAD_RX_RING_SIZE - 1)];
+		_download_rx_tail++;
+
+		if (byte != 0x00) {
+			if (_download_rx_length < DOWNLOAD_MAX_RX_FRAME) {
+				_download_rx_frame[_download_rx_length] = byte;
+			}
+			if (_download_rx_length <= DOWNLOAD_MAX_RX_FRAME) {
+				_download_rx_length++;
+			}
+			continue;
+		}
+
+		// End of frame
+		uint8_t frame_length = _download_rx_length;
+		_download_rx_length = 0;
+		if (frame_length == 0) {
+			continue; // Empty frame (delimiter after noise)
+		}
+		uint16_t length = 0;
+		if (frame_length <= DOWNLOAD_MAX_RX_FRAME) {
+			length = COBS_Decode(_download_rx_frame, frame_length, (uint8_t *)&packet);
+		}
+		if (length < sizeof(DownloadHeader) + sizeof(uint32_t) || length % 4 != 0
+				|| packet.header.version != DOWNLOAD_PROTOCOL_VERSION
+				|| packet.header.length != length - sizeof(DownloadHeader) - sizeof(uint32_t)
+				|| packet.words[length / 4 - 1] != CRC32_Compute(packet.words, length / 4 - 1)) {
+			_download_stats.rx_errors++;
+			continue; // Error, invalid frame
+		}
+		DOWNLOAD_HandlePacket(&packet, now_ms);
+	}
+}
+
+/**
+ * Send INFO at the current baud rate, and start a session.
+ *
+ * @param now_ms: current tick.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no free frame buffer
+ */
+static int8_t DOWNLOAD_SendInfo(uint32_t now_ms) {
+	uint32_t log_id = 0; // Empty log
+
+	_download_size = RECORDER_GetLogSize();
+	if (_download_size >= DOWNLOAD_LOG_ID_SIZE && RECORDER_ReadLog(0, _download_packet.data.data, DOWNLOAD_LOG_ID_SIZE) == 0) {
+		log_id = CRC32_Compute((const uint32_t *)_download_packet.data.data, DOWNLOAD_LOG_ID_SIZE / 4);
+	}
+
+	_download_packet.info.size = _download_size;
+	_download_packet.info.log_id = log_id;
+	_download_packet.info.baud_rate = _download_baud_rate;
+	_download_packet.info.block_size = DOWNLOAD_BLOCK_SIZE;
+	_download_packet.info.window_blocks = DOWNLOAD_WINDOW_BLOCKS;
+	if (DOWNLOAD_Queue(DOWNLOAD_PACKET_INFO, DOWNLOAD_BODY_LENGTH(DownloadInfo)) != 0) {
+		return -1; // Error, no free frame buffer
+	}
+
+	_download_started = 0; // Nothing sent before the first NACK
+	_download_done = 0;
+	_download_completed = 0;
+	_download_done_sent = 0;
+	_download_erase = 0;
+	_download_erased = 0;
+	_download_erase_reply = 0;
+	_download_offset = 0;
+	_download_sent_end = 0;
+	_download_acked = 0;
+	_download_acked_bytes = 0;
+	_download_start_ms = now_ms;
+	// Frames: block, offset, header, CRC, COBS and delimiter. 8N1: 10 bits per byte
+	uint32_t window_bytes = DOWNLOAD_WINDOW_BLOCKS * DOWNLOAD_MAX_FRAME;
+	_download_ack_timeout_ms = DOWNLOAD_ACK_TIMEOUT_MS + window_bytes * 10 * 1000 / _download_baud_rate;
+	_download_stats.sessions++;
+	_download_stats.baud_rate = _download_baud_rate;
+
+	return 0; // OK
+}
+
+/**
+ * Send DONE with the CRC-32 of the whole log.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no free frame buffer
+ */
+static int8_t DOWNLOAD_SendDone() {
+	uint32_t log_crc = 0xFFFFFFFF; // Empty log
+
+	// Block by block through the packet buffer (the log may wrap around the region)
+	for (uint32_t offset = 0; offset < _download_size; offset += DOWNLOAD_BLOCK_SIZE) {
+		RECORDER_ReadLog(offset, _download_packet.data.data, DOWNLOAD_BLOCK_SIZE);
+		const uint32_t *words = (const uint32_t *)_download_packet.data.data;
+		log_crc = offset == 0 ? CRC32_Compute(words, DOWNLOAD_BLOCK_SIZE / 4)
+				: CRC32_Accumulate(words, DOWNLOAD_BLOCK_SIZE / 4);
+	}
+
+	_download_packet.done.size = _download_size;
+	_download_packet.done.log_crc = log_crc;
+	if (DOWNLOAD_Queue(DOWNLOAD_PACKET_DONE, DOWNLOAD_BODY_LENGTH(DownloadDone)) != 0) {
+		return -1; // Error, no free frame buffer
+	}
+
+	_download_log_crc = log_crc;
+	_download_done_sent = 1;
+	return 0; // OK
+}
+
+/**
+ * Erase the log if ERASE was accepted, then send ERASED. The recorder does not
+ * run during a download, the erase blocks the task (~20-40 ms per page).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no free frame buffer
+ */
+static int8_t DOWNLOAD_SendErased() {
+	if (_download_erase) {
+		_download_erase = 0;
+		int8_t status = RECORDER_Erase();
+		if (status == -1) {
+			_download_erase_status = DOWNLOAD_ERASE_REFUSED; // In flight, nothing erased
+			_download_stats.refused++;
+		} else {
+			_download_erase_status = status == 0 ? DOWNLOAD_ERASE_OK : DOWNLOAD_ERASE_FAILED;
+			_download_erased = status == 0;
+			_download_stats.erases += status == 0;
+			// Nothing left to send from the old log
+			DOWNLOAD_DropPending();
+			_download_started = 0;
+			_download_done = 0;
+		}
+		_download_rx_ms = HAL_GetTick(); // The erase time is not host idle time
+	}
+
+	_download_packet.erased.status = _download_erase_status;
+	return DOWNLOAD_Queue(DOWNLOAD_PACKET_ERASED, DOWNLOAD_BODY_LENGTH(DownloadErased));
+}
+
+/**
+ * Send blocks up to the window while frame buffers are free, go back to the
+ * acknowledged offset without progress.
+ *
+ * @param now_ms: current tick.
+ */
+static void DOWNLOAD_SendBlocks(uint32_t now_ms) {
+	if (_download_erase_reply) {
+		if (DOWNLOAD_SendErased() == 0) {
+			_download_erase_reply = 0;
+		}
+		return;
+	}
+
+	if (!_download_started) {
+		return; // Waiting for the first NACK
+	}
+
+	if (_download_offset > _download_acked && now_ms - _download_progress_ms >= _download_ack_timeout_ms) {
+		DOWNLOAD_DropPending();
+		_download_offset = _download_acked;
+		_download_progress_ms = now_ms;
+		_download_stats.ack_timeouts++;
+	}
+
+	if (_download_done) {
+		if (DOWNLOAD_SendDone() == 0) {
+			_download_done = 0;
+		}
+		return;
+	}
+
+	while (_download_offset < _download_size
+			&& _download_offset < _download_acked + DOWNLOAD_WINDOW_BLOCKS * DOWNLOAD_BLOCK_SIZE) {
+		uint32_t offset = _download_offset;
+		uint16_t length = _download_size - offset < DOWNLOAD_BLOCK_SIZE ? _download_size - offset : DOWNLOAD_BLOCK_SIZE;
+
+		_download_packet.data.offset = offset;
+		RECORDER_ReadLog(offset, _download_packet.data.data, length);
+		if (DOWNLOAD_Queue(DOWNLOAD_PACKET_DATA, sizeof(uint32_t) + length) != 0) {
+			return; // Frame buffers full
+		}
+
+		_download_offset = offset + length;
+		_download_stats.blocks_sent++;
+		if (offset < _download_sent_end) {
+			_download_stats.blocks_resent++;
+		} else {
+			_download_sent_end = _download_offset;
+		}
+	}
+}
+
+/**
+ * Initialize the download mode and start receiving on the UART. The UART TX DMA
+ * channel must be configured (CubeMX), shared with telemetry (GAUL/Telemetry.h).
+ *
+ * @param huart: pointer to a HAL UART handler.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no TX DMA channel
+ * @retval -2 ERROR receive not started
+ */
+int8_t DOWNLOAD_Init(UART_HandleTypeDef *huart) {
+	DOWNLOAD_huart = huart;
+
+	_download_state = DOWNLOAD_STATE_IDLE;
+	_download_stats = (DownloadStats){0};
+	_download_rx_head = _download_rx_tail = 0;
+	_download_rx_length = 0;
+	for (uint8_t i = 0; i < DOWNLOAD_TX_BUFFERS; i++) {
+		_download_tx[i].state = DOWNLOAD_TX_FREE;
+	}
+	_download_tx_fill = 0;
+	_download_tx_send = 0;
+	_download_tx_sending = -1;
+
+	if (huart->hdmatx == NULL) {
+		return -1; // Error, no TX DMA channel linked to the UART
+	}
+
+	if (HAL_UART_Receive_IT(huart, &_download_rx_byte, 1) != HAL_OK) {
+		return -2; // Error, receive not started
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Parse host packets and run the download: INFO, baud rate switch, blocks,
+ * then telemetry again. Call this function every DOWNLOAD_GetPeriod_ms().
+ */
+void DOWNLOAD_Update() {
+	uint32_t now_ms = HAL_GetTick();
+
+	if (DOWNLOAD_huart == NULL) {
+		return; // Not initialized
+	}
+
+	DOWNLOAD_Receive(now_ms);
+
+	FlightState flight_state = FLIGHT_GetState();
+	if (_download_state != DOWNLOAD_STATE_IDLE && (flight_state == FLIGHT_STATE_ASCENT
+			|| flight_state == FLIGHT_STATE_DESCENT || now_ms - _download_rx_ms >= DOWNLOAD_IDLE_TIMEOUT_MS)) {
+		_download_state = DOWNLOAD_STATE_LEAVE; // Launch, or host gone
+	}
+
+	switch (_download_state) {
+	case DOWNLOAD_STATE_INFO:
+		if (TELEMETRY_IsIdle() && DOWNLOAD_TxIdle() && DOWNLOAD_SendInfo(now_ms) == 0) {
+			_download_state = DOWNLOAD_STATE_SWITCH;
+		}
+		break;
+
+	case DOWNLOAD_STATE_SWITCH:
+		if (DOWNLOAD_TxIdle()) {
+			if (_download_baud_rate != DOWNLOAD_huart->Init.BaudRate) {
+				DOWNLOAD_SetBaudRate(_download_baud_rate);
+			}
+			_download_progress_ms = now_ms;
+			_download_state = DOWNLOAD_STATE_ACTIVE;
+		}
+		break;
+
+	case DOWNLOAD_STATE_ACTIVE:
+		DOWNLOAD_SendBlocks(now_ms);
+		break;
+
+	case DOWNLOAD_STATE_LEAVE:
+		DOWNLOAD_DropPending();
+		if (DOWNLOAD_TxIdle()) {
+			if (_download_telemetry_baud_rate != DOWNLOAD_huart->Init.BaudRate) {
+				DOWNLOAD_SetBaudRate(_download_telemetry_baud_rate);
+			}
+			TELEMETRY_Pause(0);
+			_download_state = DOWNLOAD_STATE_IDLE;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * Check if a download owns the UART: telemetry is paused and the recorder must
+ * not run.
+ *
+ * @retval 1 download in progress
+ * @retval 0 idle
+ */
+uint8_t DOWNLOAD_IsActive() {
+	return _download_state != DOWNLOAD_STATE_IDLE;
+}
+
+/**
+ * Get the download task period, short while a download is in progress.
+ *
+ * @return Period in milliseconds
+ */
+uint32_t DOWNLOAD_GetPeriod_ms() {
+	return _download_state == DOWNLOAD_STATE_IDLE ? DOWNLOAD_IDLE_PERIOD_MS : DOWNLOAD_ACTIVE_PERIOD_MS;
+}
+
+/**
+ * Callback called on incoming UART data. It is called when
+ * HAL_UART_RxCpltCallback is called. Add the received byte to the RX ring.
+ *
+ * @param huart: pointer to a HAL UART handler triggering the callback
+ */
+void DOWNLOAD_RxCpltCallback(UART_HandleTypeDef *huart) {
+	if (DOWNLOAD_huart != NULL && huart->Instance == DOWNLOAD_huart->Instance) {
+		if (_download_rx_head - _download_rx_tail < DOWNLOAD_RX_RING_SIZE) {
+			_download_rx_ring[_download_rx_head & (DOWNLOAD_RX_RING_SIZE - 1)] = _download_rx_byte;
+			_download_rx_head++;
+		} else {
+			_download_stats.rx_overruns++;
+		}
+		// Receive UART data with interrupts
+		HAL_UART_Receive_IT(DOWNLOAD_huart, &_download_rx_byte, 1);
+	}
+}
+
+/**
+ * Callback called when a DMA transfer is complete. It is called when
+ * HAL_UART_TxCpltCallback is called.
+ *
+ * @param huart: pointer to a HAL UART handler triggering the callback
+ */
+void DOWNLOAD_TxCpltCallback(UART_HandleTypeDef *huart) {
+	if (DOWNLOAD_huart != NULL && huart->Instance == DOWNLOAD_huart->Instance && _download_tx_sending >= 0) {
+		_download_tx[_download_tx_sending].state = DOWNLOAD_TX_FREE;
+		_download_tx_sending = -1;
+
+		DOWNLOAD_StartTx();
+	}
+}
+
+/**
+ * Callback called on UART errors. It is called when HAL_UART_ErrorCallback is
+ * called. A failed frame is skipped (the host sends a NACK), and receiving
+ * starts again if the error stopped it (overrun).
+ *
+ * @param huart: pointer to a HAL UART handler triggering the callback
+ */
+void DOWNLOAD_ErrorCallback(UART_HandleTypeDef *huart) {
+	if (DOWNLOAD_huart == NULL || huart->Instance != DOWNLOAD_huart->Instance) {
+		return;
+	}
+
+	if (_download_tx_sending >= 0 && huart->gState == HAL_UART_STATE_READY) {
+		_download_tx[_download_tx_sending].state = DOWNLOAD_TX_FREE;
+		_download_tx_sending = -1;
+		_download_stats.tx_errors++;
+
+		DOWNLOAD_StartTx();
+	}
+	if (huart->RxState == HAL_UART_STATE_READY) {
+		_download_stats.rx_errors++;
+		HAL_UART_Receive_IT(DOWNLOAD_huart, &_download_rx_byte, 1);
+	}
+}
+
+/**
+ * Get download statistics (for debug or telemetry).
+ *
+ * @return Pointer to statistics
+ */
+const DownloadStats *DOWNLOAD_GetStats() {
+	return &_download_stats;
+}
@@ -0,0 +1,277 @@
+/*
+ * Fault.c
+ *
+ * Post-mortem fault capture. The fault handlers (and Error_Handler) save the
+ * stacked registers, the fault status registers, the running task and the
+ * trace ring into a .noinit RAM record, then reset so sampling resumes within
+ * a few milliseconds. The record survives the reset (RAM is not cleared by the
+ * startup code), it is checked and reported on the next boot.
+ *
+ * The record also keeps the flight context (flight state, launch tick, ground
+ * reference pressure): after a fault reset in flight, the flight resumes from
+ * it instead of starting over on the pad (see FAULT_GetFlight()).
+ *
+ * The fault handlers are not generated by CubeMX (.ioc NVIC settings) since
+ * they must be naked to find the stacked registers.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Fault.h"
+#include "GAUL/Log.h"
+#include "GAUL/Scheduler.h"
+
+#include "stddef.h" // for offsetof()
+#include "string.h" // for memcpy(), memset()
+
+// Top of the stack (linker script)
+extern uint32_t _estack;
+
+// Survives the reset, not initialized by the startup code
+FaultRecord _fault_record __attribute__((section(".noinit")));
+
+// Record of the previous boot, if any
+FaultRecord _fault_last;
+uint8_t _fault_last_valid = 0;
+
+// Flight context to resume, from the record of the previous boot
+uint8_t _fault_flight_valid = 0;
+
+/**
+ * Checksum of a record (everything before the checksum).
+ *
+ * @param record: pointer to a FaultRecord.
+ *
+ * @return Checksum
+ */
+static uint32_t FAULT_Checksum(const FaultRecord *record) {
+	const uint32_t *words = (const uint32_t *)record;
+	uint32_t checksum = 0x811C9DC5;
+
+	for (uint32_t i = 0; i < offsetof(FaultRecord, checksum) / 4; i++) {
+		checksum = (checksum ^ words[i]) * 0x01000193; // FNV-1a on words
+	}
+
+	return checksum;
+}
+
+/**
+ * Check the record of the previous boot, then start a new record. Enable
+ * MemManage, BusFault and UsageFault handlers (divide by zero is trapped).
+ * Call this function early in main.
+ */
+void FAULT_Init() {
+	uint16_t resets = 0;
+
+	if (_fault_record.magic == FAULT_RECORD_MAGIC && _fault_record.checksum == FAULT_Checksum(&_fault_record)) {
+		memcpy(&_fault_last, &_fault_record, sizeof(FaultRecord));
+		_fault_last_valid = 1;
+		resets = _fault_record.resets;
+	}
+
+	// A power on reset clears the fault count
+	if (RCC->CSR & RCC_CSR_PORRSTF) {
+		resets = 0;
+	}
+
+	memset(&_fault_record, 0, sizeof(FaultRecord));
+	_fault_record.resets = resets;
+
+	// Fault reset out of the pad: resume the flight, and again after the next fault
+	if (_fault_last_valid && resets > 0 && _fault_last.flight.state != 0) {
+		_fault_record.flight = _fault_last.flight;
+		_fault_flight_valid = 1;
+	}
+	FAULT_Trace(FAULT_TRACE_BOOT, RCC->CSR >> 16);
+	RCC->CSR |= RCC_CSR_RMVF; // Clear reset flags
+
+	SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_USGFAULTENA_Msk;
+	SCB->CCR |= SCB_CCR_DIV_0_TRP_Msk;
+}
+
+/**
+ * Add an event to the trace ring.
+ *
+ * @param event: FAULT_TRACE_*.
+ * @param data: event data.
+ */
+void FAULT_Trace(uint16_t event, uint16_t data) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	FaultTraceEntry *entry = &_fault_record.trace[_fault_record.trace_index % FAULT_TRACE_SIZE];
+	entry->tick_ms = SCHEDULER_GetTick_ms();
+	entry->event = event;
+	entry->data = data;
+	_fault_record.trace_index = (_fault_record.trace_index + 1) % FAULT_TRACE_SIZE;
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Keep the flight state in the record, call it on each state change.
+ *
+ * @param state: new flight state (FlightState).
+ * @param launch_ms: HAL tick of the launch.
+ */
+void FAULT_SaveFlight(uint8_t state, uint32_t launch_ms) {
+	_fault_record.flight.state = state;
+	_fault_record.flight.launch_ms = launch_ms;
+}
+
+/**
+ * Keep the barometer ground reference in the record.
+ *
+ * @param press_ref_Pa: BMP280 ground reference pressure.
+ */
+void FAULT_SaveReference(float press_ref_Pa) {
+	_fault_record.flight.press_ref_Pa = press_ref_Pa;
+}
+
+/**
+ * Seal the record: rebase the launch tick on the tick of the next boot (the
+ * HAL tick starts again from 0, the reset only takes a few milliseconds), then
+ * checksum. Called by FAULT_Capture() and FAULT_Error() before the reset.
+ */
+static void FAULT_Seal() {
+	_fault_record.flight.launch_ms -= HAL_GetTick();
+	_fault_record.resets++;
+
+	_fault_record.magic = FAULT_RECORD_MAGIC;
+	_fault_record.checksum = FAULT_Checksum(&_fault_record);
+}
+
+/**
+ * Save the fault context and reset. Called by the fault handlers.
+ *
+ * @param frame: stacked registers (r0, r1, r2, r3, r12, lr, pc, xpsr).
+ * @param exc_return: LR on exception entry.
+ * @param reason: FAULT_REASON_*.
+ */
+void FAULT_Capture(uint32_t *frame, uint32_t exc_return, uint32_t reason) {
+	_fault_record.reason = reason;
+	_fault_record.exc_return = exc_return;
+
+	// Stacked registers, if the stack pointer is valid (not a stack overflow)
+	if ((uint32_t)frame >= SRAM_BASE && (uint32_t)(frame + 8) <= (uint32_t)&_estack) {
+		_fault_record.r0 = frame[0];
+		_fault_record.r1 = frame[1];
+		_fault_record.r2 = frame[2];
+		_fault_record.r3 = frame[3];
+		_fault_record.r12 = frame[4];
+		_fault_record.lr = frame[5];
+		_fault_record.pc = frame[6];
+		_fault_record.xpsr = frame[7];
+	}
+	_fault_record.sp = (uint32_t)(frame + 8);
+
+	_fault_record.cfsr = SCB->CFSR;
+	_fault_record.hfsr = SCB->HFSR;
+	_fault_record.bfar = SCB->BFAR;
+	_fault_record.mmfar = SCB->MMFAR;
+	_fault_record.tick_ms = SCHEDULER_GetTick_ms();
+	_fault_record.task_id = SCHEDULER_GetCurrentTask();
+	FAULT_Seal();
+
+	NVIC_SystemReset();
+}
+
+/**
+ * Save the context of a HAL error and reset. Called by Error_Handler().
+ *
+ * @param caller: return address of Error_Handler() (where the error was found).
+ */
+void FAULT_Error(uint32_t caller) {
+	__disable_irq();
+
+	// No exception frame, use the caller as faulting address
+	_fault_record.reason = FAULT_REASON_ERROR_HANDLER;
+	_fault_record.pc = caller;
+	_fault_record.sp = __get_MSP();
+	_fault_record.tick_ms = SCHEDULER_GetTick_ms();
+	_fault_record.task_id = SCHEDULER_GetCurrentTask();
+	FAULT_Seal();
+
+	NVIC_SystemReset();
+}
+
+/**
+ * Get the fault record of the previous boot (for telemetry).
+ *
+ * @return Pointer to the record, NULL if the previous boot didn't fault
+ */
+const FaultRecord *FAULT_GetLast() {
+	return _fault_last_valid ? &_fault_last : NULL;
+}
+
+/**
+ * Get the flight context to resume after a fault reset out of the pad. The
+ * launch tick is rebased on the HAL tick of this boot.
+ *
+ * @return Pointer to the flight context, NULL if the flight starts on the pad
+ */
+const FaultFlight *FAULT_GetFlight() {
+	return _fault_flight_valid ? &_fault_record.flight : NULL;
+}
+
+/**
+ * Log the fault record of the previous boot, if any.
+ */
+void FAULT_Report() {
+	if (!_fault_last_valid) {
+		return;
+	}
+
+	const FaultRecord *record = &_fault_last;
+	LOG("Fault %lu (reset %u) at %lu ms, task %d", record->reason, record->resets, record->tick_ms, record->task_id);
+	LOG("PC %08lX LR %08lX SP %08lX xPSR %08lX EXC_RETURN %08lX", record->pc, record->lr, record->sp, record->xpsr, record->exc_return);
+	LOG("R0 %08lX R1 %08lX R2 %08lX R3 %08lX R12 %08lX", record->r0, record->r1, record->r2, record->r3, record->r12);
+	LOG("CFSR %08lX HFSR %08lX BFAR %08lX MMFAR %08lX", record->cfsr, record->hfsr, record->bfar, record->mmfar);
+	LOG("Flight state %u, launch at %ld ms", record->flight.state, (int32_t)record->flight.launch_ms);
+
+	// Trace, oldest first
+	for (uint8_t i = 0; i < FAULT_TRACE_SIZE; i++) {
+		const FaultTraceEntry *entry = &record->trace[(record->trace_index + i) % FAULT_TRACE_SIZE];
+		if (entry->event != 0) {
+			LOG("Trace %lu ms event %u data %u", entry->tick_ms, entry->event, entry->data);
+		}
+	}
+}
+
+/*
+ * Fault handlers: find the stacked registers (main or process stack, from
+ * EXC_RETURN), reset the main stack pointer to the top of the stack (a stack
+ * overflow fault would fault again while stacking, then lock up), then capture.
+ * Naked, only basic asm (the reason is stringized). FAULT_Capture() reads the
+ * frame before calling anything, its few stacked words only overwrite the
+ * frames of main() at the top of the stack, above the exception frame.
+ */
+#define FAULT_STRINGIZE(x) #x
+#define FAULT_STRING(x) FAULT_STRINGIZE(x)
+#define FAULT_HANDLER(reason) __ASM volatile( \
+	"tst lr, #4 \n" \
+	"ite eq \n" \
+	"mrseq r0, msp \n" \
+	"mrsne r0, psp \n" \
+	"mov r1, lr \n" \
+	"movs r2, #" FAULT_STRING(reason) " \n" \
+	"ldr r3, =_estack \n" \
+	"msr msp, r3 \n" \
+	"b FAULT_Capture \n")
+
+__attribute__((naked)) void HardFault_Handler(void) {
+	FAULT_HANDLER(FAULT_REASON_HARDFAULT);
+}
+
+__attribute__((naked)) void MemManage_Handler(void) {
+	FAULT_HANDLER(FAULT_REASON_MEMMANAGE);
+}
+
+__attribute__((naked)) void BusFault_Handler(void) {
+	FAULT_HANDLER(FAULT_REASON_BUSFAULT);
+}
+
+__attribute__((naked)) void UsageFault_Handler(void) {
+	FAULT_HANDLER(FAULT_REASON_USAGEFAULT);
+}
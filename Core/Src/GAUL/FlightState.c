@@ -0,0 +1,280 @@
+/*
+ * FlightState.c
+ *
+ * Flight state machine. On the pad, the BMP280 runs in low power mode, the GNSS
+ * module in periodic standby mode and the sampling period is longer. Launch is
+ * detected within FLIGHT_LAUNCH_DETECT_MAX_MS, then everything switches to full rate.
+ * Ahead of apogee (predicted during coast), telemetry rates are raised until
+ * shortly after apogee, see FLIGHT_ApogeeArmed().
+ * Once landed, the BMP280 sleeps and the GNSS module is duty cycled by the beacon.
+ *
+ * The flight state and the launch tick are kept in the fault record: after a
+ * fault reset out of the pad, the flight resumes in its state at full rate
+ * (launch could not be detected again in flight).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/FlightState.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/Fault.h"
+#include "GAUL/Log.h"
+
+#include "math.h" // for fabsf()
+
+#include "GAUL_Drivers/BMP280.h"
+#include "GAUL_Drivers/L76LM33.h"
+
+FlightState _flight_state = FLIGHT_STATE_PAD_IDLE;
+
+// Consecutive samples meeting the next state condition
+uint8_t _flight_counter = 0;
+
+// Timestamp of the launch (HAL tick)
+uint32_t _flight_launch_ms = 0;
+
+// Timestamp since the landing condition is met
+uint32_t _flight_landed_ms = 0;
+
+// 1 from the apogee prediction until FLIGHT_APOGEE_HOLD_MS after apogee
+uint8_t _flight_apogee_armed = 0;
+uint32_t _flight_apogee_ms = 0;
+
+// Barometer samples read from the bus
+uint32_t _flight_baro_count = 0;
+
+// Sensor mode changes failed (SPI or UART), full rate is retried on each update until it succeeds
+uint32_t _flight_mode_errors = 0;
+uint8_t _flight_full_rate_pending = 0;
+
+// GNSS full power requested at launch, switched by FLIGHT_UpdateGNSS() (GNSS task)
+uint8_t _flight_gnss_pending = 0;
+
+/**
+ * Change flight state and publish the event on the bus.
+ *
+ * @param state: new flight state.
+ * @param barometer: barometer sample triggering the change.
+ */
+static void FLIGHT_SetState(FlightState state, const Barometer *barometer) {
+	FlightEvent event = { barometer->timestamp_ms, barometer->timestamp_us, state };
+
+	_flight_state = state;
+	_flight_counter = 0;
+	BUS_Publish(BUS_TOPIC_EVENT, &event);
+	FAULT_Trace(FAULT_TRACE_STATE, state);
+	FAULT_SaveFlight(state, _flight_launch_ms);
+}
+
+/**
+ * Switch the BMP280 to full rate, count and log a failure (retried on the next
+ * update). The GNSS module is switched by the GNSS task: its UART command takes
+ * ~20 ms at 9600 baud and would stall barometer sampling at launch.
+ */
+static void FLIGHT_TryFullRate() {
+	if (BMP280_SetMode(BMP280_MODE_NORMAL_POWER) != 0) {
+		_flight_mode_errors++;
+		_flight_full_rate_pending = 1;
+		LOG("Full rate mode error (%lu)", _flight_mode_errors);
+	} else {
+		_flight_full_rate_pending = 0;
+	}
+}
+
+/**
+ * Resume the flight after a fault reset out of the pad: sensors at the rate of
+ * the flight state, landing detection and the apogee window start over.
+ *
+ * @param flight: flight context of the fault record.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+static int8_t FLIGHT_Resume(const FaultFlight *flight) {
+	_flight_state = flight->state;
+	_flight_launch_ms = flight->launch_ms;
+	_flight_landed_ms = HAL_GetTick();
+	_flight_apogee_ms = HAL_GetTick() - FLIGHT_APOGEE_HOLD_MS;
+	FAULT_SaveFlight(_flight_state, _flight_launch_ms);
+	LOG("Flight resumed in state %u, %lu ms after launch", _flight_state, HAL_GetTick() - _flight_launch_ms);
+
+	// Once landed, the beacon drives the GNSS module (expected in full power mode)
+	uint8_t bmp_mode = _flight_state == FLIGHT_STATE_LANDED ? BMP280_MODE_SLEEP : BMP280_MODE_NORMAL_POWER;
+	if (BMP280_SetMode(bmp_mode) != 0) {
+		_flight_full_rate_pending = _flight_state != FLIGHT_STATE_LANDED;
+		return -1; // SPI Error
+	}
+	if (L76LM33_SetMode(L76LM33_MODE_FULL_POWER) != 0) {
+		_flight_gnss_pending = _flight_state != FLIGHT_STATE_LANDED;
+		return -1; // UART Error
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Enter pad idle state: BMP280 in low power mode, GNSS in periodic mode. After
+ * a fault reset out of the pad, resume the flight state instead (see
+ * FAULT_GetFlight()).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t FLIGHT_Init() {
+	const FaultFlight *flight = FAULT_GetFlight();
+
+	_flight_counter = 0;
+	_flight_apogee_armed = 0;
+	_flight_gnss_pending = 0;
+	_flight_full_rate_pending = 0;
+
+	if (flight != NULL) {
+		return FLIGHT_Resume(flight);
+	}
+
+	_flight_state = FLIGHT_STATE_PAD_IDLE;
+	_flight_launch_ms = 0;
+
+	if (BMP280_SetMode(BMP280_MODE_LOW_POWER) != 0) {
+		return -1; // SPI Error
+	}
+	if (L76LM33_SetMode(L76LM33_MODE_PERIODIC) != 0) {
+		return -1; // UART Error
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Update flight state with the latest barometer sample from the bus.
+ * Call this function every FLIGHT_GetPeriod_ms().
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no new barometer sample
+ */
+int8_t FLIGHT_Update() {
+	Barometer sample;
+	const Barometer *barometer = &sample;
+
+	if (BUS_Read(BUS_TOPIC_BARO, &sample, &_flight_baro_count) != 0) {
+		return -1; // No new barometer sample
+	}
+
+	if (_flight_full_rate_pending && _flight_state != FLIGHT_STATE_LANDED) {
+		FLIGHT_TryFullRate();
+	}
+
+	switch (_flight_state) {
+		case FLIGHT_STATE_PAD_IDLE: {
+			if (barometer->altitude_m > FLIGHT_LAUNCH_ALT_M || barometer->speed_mps > FLIGHT_LAUNCH_SPD_MPS) {
+				_flight_counter++;
+			} else {
+				_flight_counter = 0;
+			}
+			if (_flight_counter >= FLIGHT_LAUNCH_SAMPLES) {
+				_flight_launch_ms = barometer->timestamp_ms;
+				FLIGHT_SetState(FLIGHT_STATE_ASCENT, barometer);
+				FLIGHT_TryFullRate();
+				_flight_gnss_pending = 1;
+			}
+		} break;
+
+		case FLIGHT_STATE_ASCENT: {
+			if (BAROMETER_ApogeeImminent(barometer)) {
+				_flight_apogee_armed = 1;
+			}
+			if (barometer->speed_mps < FLIGHT_APOGEE_SPD_MPS) {
+				_flight_counter++;
+			} else {
+				_flight_counter = 0;
+			}
+			if (_flight_counter >= FLIGHT_APOGEE_SAMPLES) {
+				FLIGHT_SetState(FLIGHT_STATE_DESCENT, barometer);
+				_flight_landed_ms = barometer->timestamp_ms;
+				_flight_apogee_armed = 1; // Also if apogee was not predicted
+				_flight_apogee_ms = barometer->timestamp_ms;
+			}
+		} break;
+
+		case FLIGHT_STATE_DESCENT: {
+			if (barometer->timestamp_ms - _flight_apogee_ms >= FLIGHT_APOGEE_HOLD_MS) {
+				_flight_apogee_armed = 0;
+			}
+			if (fabsf(barometer->speed_mps) > FLIGHT_LANDED_SPD_MPS) {
+				_flight_landed_ms = barometer->timestamp_ms;
+			}
+			if (barometer->timestamp_ms - _flight_landed_ms >= FLIGHT_LANDED_TIME_MS) {
+				FLIGHT_SetState(FLIGHT_STATE_LANDED, barometer);
+				_flight_full_rate_pending = 0;
+				_flight_gnss_pending = 0; // The beacon drives the GNSS module
+				if (BMP280_SetMode(BMP280_MODE_SLEEP) != 0) {
+					_flight_mode_errors++;
+					LOG("Sleep mode error (%lu)", _flight_mode_errors);
+				}
+			}
+		} break;
+
+		case FLIGHT_STATE_LANDED: {
+		} break;
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Switch the GNSS module to full power once launch is declared, retried on
+ * each call until it succeeds. Call this function from the GNSS task.
+ *
+ * @retval 0 OK (or nothing to do)
+ * @retval -1 ERROR UART, retried on the next call
+ */
+int8_t FLIGHT_UpdateGNSS() {
+	if (!_flight_gnss_pending) {
+		return 0; // OK, nothing to do
+	}
+
+	if (L76LM33_SetMode(L76LM33_MODE_FULL_POWER) != 0) {
+		_flight_mode_errors++;
+		LOG("GNSS full power mode error (%lu)", _flight_mode_errors);
+		return -1; // UART Error
+	}
+	_flight_gnss_pending = 0;
+
+	return 0; // OK
+}
+
+/**
+ * Get current flight state.
+ *
+ * @return Current flight state
+ */
+FlightState FLIGHT_GetState() {
+	return _flight_state;
+}
+
+/**
+ * Get sampling period of the current flight state.
+ *
+ * @return Sampling period in ms
+ */
+uint32_t FLIGHT_GetPeriod_ms() {
+	if (_flight_state == FLIGHT_STATE_PAD_IDLE) {
+		return FLIGHT_PAD_PERIOD_MS;
+	}
+	if (_flight_state == FLIGHT_STATE_LANDED) {
+		return FLIGHT_LANDED_PERIOD_MS;
+	}
+	return FLIGHT_FULL_RATE_PERIOD_MS;
+}
+
+/**
+ * Check if rates are raised around apogee: from the apogee prediction during
+ * coast until FLIGHT_APOGEE_HOLD_MS after apogee.
+ *
+ * @retval 1 around apogee
+ * @retval 0 otherwise
+ */
+uint8_t FLIGHT_ApogeeArmed() {
+	return _flight_apogee_armed;
+}
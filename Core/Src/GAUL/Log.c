@@ -0,0 +1,79 @@
+/*
+ * Log.c
+ *
+ * Tokenized binary logging over SWO (ITM stimulus port LOG_ITM_PORT). Instead
+ * of formatting text on target (newlib float formatting takes thousands of
+ * cycles), a message is sent as 32-bit ITM writes:
+ *
+ * <LOG_FRAME_MARKER | format address> <argument words...>
+ *
+ * The format strings are only in the ELF, the host decoder (Tools/log_decoder.c)
+ * finds them in the .log_fmt section and formats the arguments.
+ *
+ * Enable stimulus ports 0 (printf) and 1 (logs) in the debugger SWV settings.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Log.h"
+
+#include "string.h" // for strnlen(), memcpy()
+
+/**
+ * Write a word on the log stimulus port. Waits while the ITM FIFO is full.
+ *
+ * @param word: word to write.
+ */
+static void LOG_WriteWord(uint32_t word) {
+	while (ITM->PORT[LOG_ITM_PORT].u32 == 0) {
+		__NOP();
+	}
+	ITM->PORT[LOG_ITM_PORT].u32 = word;
+}
+
+/**
+ * Write a log frame. Use the LOG() macro instead.
+ *
+ * The frame is written with interrupts masked so frames from different
+ * contexts don't interleave. Nothing is written if no debugger enabled the
+ * stimulus port.
+ *
+ * @param token: format string address (.log_fmt section).
+ * @param args: arguments, terminated by LOG_TYPE_END.
+ */
+void LOG_Write(uint32_t token, const LogArg args[]) {
+	if ((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0 || (ITM->TER & (1UL << LOG_ITM_PORT)) == 0) {
+		return; // No trace
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	LOG_WriteWord(LOG_FRAME_MARKER | (token & LOG_TOKEN_MASK));
+
+	for (const LogArg *arg = args; arg->type != LOG_TYPE_END; arg++) {
+		switch (arg->type) {
+			case LOG_TYPE_INT64: {
+				LOG_WriteWord((uint32_t)arg->u64);
+				LOG_WriteWord((uint32_t)(arg->u64 >> 32));
+			} break;
+
+			case LOG_TYPE_STRING: {
+				uint32_t length = arg->str != NULL ? strnlen(arg->str, LOG_MAX_STRING_LENGTH) : 0;
+				LOG_WriteWord(length);
+				for (uint32_t i = 0; i < length; i += 4) {
+					uint32_t word = 0;
+					memcpy(&word, &arg->str[i], length - i < 4 ? length - i : 4);
+					LOG_WriteWord(word);
+				}
+			} break;
+
+			default: {
+				LOG_WriteWord(arg->u32); // Integer or float bits
+			} break;
+		}
+	}
+
+	__set_PRIMASK(primask);
+}
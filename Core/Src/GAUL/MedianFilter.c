@@ -0,0 +1,95 @@
+/*
+ * MedianFilter.c
+ *
+ * Running median over the last N samples. The window is kept twice: in arrival
+ * order to know which sample leaves, and sorted to read the median directly.
+ * Each update finds the leaving and the new sample positions with a binary
+ * search, then shifts the samples in between (N is small, a few words at most).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/MedianFilter.h"
+
+/**
+ * Find position of a value in the sorted window using a binary search.
+ *
+ * @param sorted: sorted array.
+ * @param count: number of values in the array.
+ * @param value: value to find.
+ *
+ * @return index of the first element greater or equal to value
+ */
+static uint8_t MEDIANFILTER_Search(const float sorted[], uint8_t count, float value) {
+	uint8_t low = 0;
+	uint8_t high = count;
+	while (low < high) {
+		uint8_t mid = (low + high) / 2;
+		if (sorted[mid] < value) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/**
+ * Initialize median filter.
+ *
+ * @param filter: pointer to a MedianFilter structure.
+ * @param size: Window size, odd number up to MEDIANFILTER_MAX_SIZE.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t MEDIANFILTER_Init(MedianFilter *filter, uint8_t size) {
+	if (size == 0 || size > MEDIANFILTER_MAX_SIZE || size % 2 == 0) {
+		return -1; // Error, invalid window size
+	}
+
+	filter->size = size;
+	filter->count = 0;
+	filter->index = 0;
+
+	return 0; // OK
+}
+
+/**
+ * Add a sample to the window and get the median of the window.
+ *
+ * @param filter: pointer to a MedianFilter structure.
+ * @param sample: New sample.
+ *
+ * @return Median of the last samples (up to window size)
+ */
+float MEDIANFILTER_Update(MedianFilter *filter, float sample) {
+	uint8_t i;
+
+	if (filter->count < filter->size) {
+		// Window not full, only insert
+		filter->window[(filter->index + filter->count) % filter->size] = sample;
+		i = filter->count;
+		filter->count++;
+	} else {
+		// Remove oldest sample from sorted window
+		float oldest = filter->window[filter->index];
+		filter->window[filter->index] = sample;
+		filter->index = (filter->index + 1) % filter->size;
+
+		i = MEDIANFILTER_Search(filter->sorted, filter->count, oldest);
+		for (; i < filter->count - 1; i++) {
+			filter->sorted[i] = filter->sorted[i + 1];
+		}
+	}
+
+	// Insert new sample in sorted window (i is the last free position)
+	uint8_t position = MEDIANFILTER_Search(filter->sorted, filter->count - 1, sample);
+	for (; i > position; i--) {
+		filter->sorted[i] = filter->sorted[i - 1];
+	}
+	filter->sorted[position] = sample;
+
+	return filter->sorted[(filter->count - 1) / 2];
+}
@@ -0,0 +1,72 @@
+/*
+ * Profile.c
+ *
+ * Named profiling zones measured with the DWT cycle counter. Each zone keeps
+ * its count, min, max, mean and a log2 histogram of its durations, readable
+ * from the debugger (_profile_zones) or printed with PROFILE_Report().
+ *
+ * Replaces the DEBUG pin and logic analyzer measurements: wrap the code with
+ * PROFILE_BEGIN(name) and PROFILE_END(name) (zones listed in GAUL/Profile.h).
+ * Everything compiles to nothing when PROFILE_ENABLED is 0.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Profile.h"
+
+#if PROFILE_ENABLED
+
+#include "stdio.h" // for printf()
+
+ProfileZone _profile_zones[PROFILE_ZONE_COUNT];
+
+#define PROFILE_ZONE_NAME(name) #name,
+const char *_profile_zone_names[PROFILE_ZONE_COUNT] = {
+	PROFILE_ZONES(PROFILE_ZONE_NAME)
+};
+#undef PROFILE_ZONE_NAME
+
+/**
+ * Start the DWT cycle counter (if not already started) and clear zones.
+ */
+void PROFILE_Init() {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	PROFILE_Reset();
+}
+
+/**
+ * Clear all zones.
+ */
+void PROFILE_Reset() {
+	for (uint8_t i = 0; i < PROFILE_ZONE_COUNT; i++) {
+		_profile_zones[i] = (ProfileZone){ 0 };
+		_profile_zones[i].min_cycles = UINT32_MAX;
+	}
+}
+
+/**
+ * Print zones statistics (printf, SWO): count, min, max and mean in cycles,
+ * then the non empty histogram bins as <upper bound>:<count>.
+ */
+void PROFILE_Report() {
+	for (uint8_t i = 0; i < PROFILE_ZONE_COUNT; i++) {
+		ProfileZone *profile = &_profile_zones[i];
+		if (profile->count == 0) {
+			continue;
+		}
+
+		printf("%s n=%lu min=%lu max=%lu mean=%lu", _profile_zone_names[i], profile->count,
+				profile->min_cycles, profile->max_cycles, (uint32_t)(profile->total_cycles / profile->count));
+		for (uint8_t bin = 0; bin < PROFILE_HISTOGRAM_BINS; bin++) {
+			if (profile->histogram[bin] != 0) {
+				printf(" <%lu:%lu", bin < 32 ? 1UL << bin : UINT32_MAX, profile->histogram[bin]);
+			}
+		}
+		printf("\r\n");
+	}
+}
+
+#endif /* PROFILE_ENABLED */
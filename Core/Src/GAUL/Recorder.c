@@ -0,0 +1,964 @@
+/*
+ * Recorder.c
+ *
+ * Flight data recorder in the upper internal flash pages (RECORDER region of
+ * the linker script). New samples are read from the sample bus, packed like
+ * telemetry messages (GAUL/TelemetrySchema.h) and appended to fixed-size
+ * records. Compressed streams hold several delta/varint samples per record,
+ * each record starts with a keyframe so it decodes on its own.
+ *
+ * Sealed records go to a RAM double buffer: one buffer is filled by the
+ * sampling side while the other one is programmed, RECORDER_PROGRAM_RECORDS
+ * per RECORDER_Update() call. Programming runs from RAM (.RamFunc) and polls
+ * the flash directly, an interrupt only waits for the current halfword. The
+ * STM32F103 has a single flash bank: any fetch from flash stalls while the
+ * flash is busy, so the stall is bounded per call instead of per buffer.
+ *
+ * On the pad, every barometer sample goes through a RAM pre-launch ring, and
+ * samples leaving the ring are only logged once per pad period. Launch
+ * detection lags ignition, so the whole ring is logged when the launch is
+ * declared: the log holds the whole boost phase without the pad wait at full
+ * rate, in time order.
+ *
+ * Pages are used as a ring. A page erase stalls the CPU for tens of
+ * milliseconds, so pages are only erased on the pad, ahead of the flight. Once
+ * the log holds a flight, nothing is erased until RECORDER_Erase(). Nothing is
+ * erased either in a boot after a fault reset (GAUL/Fault.h), which may have
+ * cut a flight.
+ *
+ * A reset can cut a record or an erase at any time. Records end with a
+ * hardware CRC-32 programmed last, so a cut record fails its CRC (readers of
+ * the downloaded log check it) and its slot is not reused. Page headers hold a
+ * sequence number incremented for each page opened, so from the first written
+ * page up to the head the sequence follows the page index. At boot, the head
+ * is found by a binary search over page headers, then the first free slot and
+ * the erased pages ahead by binary searches too: a few tens of reads instead
+ * of the whole region. A page is only checked blank when it is opened. A page
+ * to open that is programmed (header or erase cut by a reset) is skipped: its
+ * header is marked invalid and its sequence number is used, so the next page
+ * still follows the index. A page header holds the flight state when the page
+ * was opened, so the records of the head page are also read for a launch
+ * event (reset in the first page after launch). Tools/recorder_test.c mounts
+ * flash images with cut records, headers and erases.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Recorder.h"
+#include "GAUL/Telemetry.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/Clock.h"
+#include "GAUL/Scheduler.h"
+#include "GAUL/Fault.h"
+
+#include "string.h" // for memcpy(), memcmp(), memset()
+
+// Recorder region (linker script)
+extern uint8_t _recorder_start[];
+extern uint8_t _recorder_end[];
+
+RecorderStats _recorder_stats;
+RecorderStream _recorder_streams[RECORDER_STREAM_COUNT];
+
+// RAM double buffer
+RecorderBuffer _recorder_buffers[2];
+uint8_t _recorder_fill;			// Buffer filled by the sampling side, the other one is programmed
+uint8_t _recorder_programmed;	// Records of the programmed buffer already written
+
+// Head: next free record slot
+uint16_t _recorder_page;
+uint8_t _recorder_slot;			// 0: page not opened (no page header yet)
+uint32_t _recorder_sequence;	// Sequence of the next page opened
+
+uint32_t _recorder_erase_ms;
+
+// Pre-launch ring
+TelemetryBaro _recorder_prelaunch[RECORDER_PRELAUNCH_SAMPLES];
+uint32_t _recorder_prelaunch_count;	// Samples kept since boot
+uint8_t _recorder_launched;			// 1: out of the pad state, every sample is logged
+
+// The ring must cover the launch detection latency
+_Static_assert(RECORDER_PRELAUNCH_MS > FLIGHT_LAUNCH_DETECT_MAX_MS, "Pre-launch ring shorter than launch detection");
+_Static_assert(sizeof(RecorderRecord) == RECORDER_RECORD_SIZE, "Record layout");
+
+// A record always holds one keyframe (longest encoded sample), copied without bounds check
+#define RECORDER_CHECK_KEYFRAME(name, compressed, pad_period_ms) \
+	_Static_assert(!(compressed) || CODEC_SAMPLE_SIZE(TELEMETRY_FIELD_COUNT_##name) <= RECORDER_RECORD_DATA, \
+			#name " keyframe longer than a record");
+RECORDER_STREAMS(RECORDER_CHECK_KEYFRAME)
+
+// Bus samples already recorded
+uint32_t _recorder_baro_count;
+uint32_t _recorder_gnss_count;
+uint32_t _recorder_altitude_count;
+uint32_t _recorder_event_count;
+
+/**
+ * Get a record slot in flash.
+ *
+ * @param page: page index in the recorder region.
+ * @param slot: record index in the page.
+ *
+ * @return Pointer to the record
+ */
+static const RecorderRecord *RECORDER_Slot(uint16_t page, uint8_t slot) {
+	return (const RecorderRecord *)&_recorder_start[page * RECORDER_PAGE_SIZE + slot * RECORDER_RECORD_SIZE];
+}
+
+/**
+ * CRC-32 of a record (every word but the CRC), by the CRC unit.
+ *
+ * @param record: pointer to a RecorderRecord (word aligned).
+ *
+ * @return CRC-32
+ */
+static uint32_t RECORDER_Crc(const RecorderRecord *record) {
+	return CRC32_Compute((const uint32_t *)record, (RECORDER_RECORD_SIZE - sizeof(record->crc)) / 4);
+}
+
+/**
+ * Check if a flash page is erased.
+ *
+ * @param page: page index in the recorder region.
+ *
+ * @retval 1 erased
+ * @retval 0 programmed
+ */
+static uint8_t RECORDER_Blank(uint16_t page) {
+	const uint32_t *words = (const uint32_t *)&_recorder_start[page * RECORDER_PAGE_SIZE];
+
+	for (uint16_t i = 0; i < RECORDER_PAGE_SIZE / 4; i++) {
+		if (words[i] != 0xFFFFFFFF) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Program halfwords. Runs from RAM: the polling loop does not fetch from
+ * flash while it is busy. The flash must be unlocked. Erased halfwords (0xFFFF)
+ * are skipped.
+ *
+ * @param address: flash address (halfword aligned, erased).
+ * @param data: halfwords to program.
+ * @param count: number of halfwords.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR programming error (not erased or write protected)
+ */
+static __RAM_FUNC __attribute__((noinline)) int8_t RECORDER_ProgramHalfwords(volatile uint16_t *address,
+		const uint16_t *data, uint16_t count) {
+	int8_t status = 0;
+
+	FLASH->CR |= FLASH_CR_PG;
+	for (uint16_t i = 0; i < count; i++) {
+		if (data[i] == 0xFFFF) {
+			continue;
+		}
+		address[i] = data[i];
+		while (FLASH->SR & FLASH_SR_BSY) {
+		}
+		if (FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) {
+			status = -1; // Error
+			break;
+		}
+	}
+	FLASH->CR &= ~FLASH_CR_PG;
+	FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR; // Clear flags (write 1)
+
+	return status;
+}
+
+/**
+ * Program a record in the head slot and move the head. A failed slot is
+ * skipped.
+ *
+ * @param record: pointer to a sealed RecorderRecord.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR programming or verification failed
+ */
+static int8_t RECORDER_Program(const RecorderRecord *record) {
+	const RecorderRecord *slot = RECORDER_Slot(_recorder_page, _recorder_slot);
+
+	uint64_t start_us = CLOCK_GetTime_us();
+	HAL_FLASH_Unlock();
+	int8_t status = RECORDER_ProgramHalfwords((volatile uint16_t *)slot, (const uint16_t *)record,
+			RECORDER_RECORD_SIZE / 2);
+	HAL_FLASH_Lock();
+	uint32_t elapsed_us = CLOCK_GetTime_us() - start_us;
+	if (elapsed_us > _recorder_stats.program_max_us) {
+		_recorder_stats.program_max_us = elapsed_us;
+	}
+
+	if (++_recorder_slot == RECORDER_RECORDS_PER_PAGE) {
+		_recorder_page = (_recorder_page + 1) % _recorder_stats.pages;
+		_recorder_slot = 0;
+	}
+
+	if (status != 0 || memcmp(slot, record, RECORDER_RECORD_SIZE) != 0) {
+		_recorder_stats.program_errors++;
+		return -1; // Error, programming failed
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Skip the head page: programmed but not opened (page header or erase cut by
+ * a reset). Its first slot is marked RECORDER_ID_SKIPPED (invalid header), and
+ * its sequence number is used so the next page opened follows the index.
+ */
+static void RECORDER_SkipPage() {
+	const uint16_t marker = RECORDER_ID_SKIPPED; // ID and length
+
+	HAL_FLASH_Unlock();
+	RECORDER_ProgramHalfwords((volatile uint16_t *)RECORDER_Slot(_recorder_page, 0), &marker, 1);
+	HAL_FLASH_Lock();
+
+	_recorder_page = (_recorder_page + 1) % _recorder_stats.pages;
+	_recorder_sequence++;
+	_recorder_stats.pages_skipped++;
+}
+
+/**
+ * Write a record at the head, opening a page (page header) if needed.
+ *
+ * @param record: pointer to a sealed RecorderRecord.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR programming failed
+ * @retval -2 ERROR no erased page
+ */
+static int8_t RECORDER_Write(const RecorderRecord *record) {
+	if (_recorder_slot == 0) {
+		// Erase cut by a reset (first slot erased): skipped, also in flight
+		while (_recorder_stats.pages_ready > 0 && !RECORDER_Blank(_recorder_page)) {
+			RECORDER_SkipPage();
+			_recorder_stats.pages_ready--;
+		}
+		if (_recorder_stats.pages_ready == 0) {
+			_recorder_stats.dropped++;
+			return -2; // Error, no erased page
+		}
+
+		RecorderPageHeader header = {
+			.sequence = _recorder_sequence++, // Also used if programming fails, the next page follows the index
+			.state = FLIGHT_GetState(),
+			.version = RECORDER_VERSION,
+			.schema = TELEMETRY_SCHEMA_VERSION,
+			.flags = _recorder_stats.flight_logged ? RECORDER_PAGE_FLIGHT : 0
+		};
+		RecorderRecord page;
+		memset(&page, 0xFF, sizeof(page));
+		page.id = RECORDER_ID_PAGE;
+		page.length = sizeof(header);
+		memcpy(page.data, &header, sizeof(header));
+		page.crc = RECORDER_Crc(&page);
+
+		_recorder_stats.pages_ready--;
+		if (RECORDER_Program(&page) != 0) {
+			return -1; // Error, programming failed
+		}
+	}
+
+	if (RECORDER_Program(record) != 0) {
+		return -1; // Error, programming failed
+	}
+	_recorder_stats.records++;
+
+	return 0; // OK
+}
+
+/**
+ * Seal the record of a stream (CRC, unused bytes erased) and append it
+ * to the buffer being filled.
+ *
+ * @param stream: pointer to a RecorderStream with a non-empty record.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR buffer full, record dropped
+ */
+static int8_t RECORDER_Seal(RecorderStream *stream) {
+	RecorderRecord *record = &stream->record;
+	RecorderBuffer *buffer = &_recorder_buffers[_recorder_fill];
+
+	memset(&record->data[record->length], 0xFF, RECORDER_RECORD_DATA - record->length);
+	record->crc = RECORDER_Crc(record);
+
+	int8_t status = 0;
+	if (buffer->count < RECORDER_BUFFER_RECORDS) {
+		memcpy(&buffer->records[buffer->count++], record, sizeof(RecorderRecord));
+	} else {
+		_recorder_stats.dropped++;
+		status = -1; // Error, buffer full
+	}
+	record->length = 0;
+
+	return status;
+}
+
+/**
+ * Add a sample to the record of a stream: as is (one sample per record), or
+ * delta encoded for compressed streams. A full record is sealed.
+ *
+ * @param stream_id: stream ID.
+ * @param body: message body.
+ * @param size: body size.
+ * @param values: scaled fields of the body (TELEMETRY_<type>ToValues()).
+ */
+static void RECORDER_AddSample(RecorderStreamId stream_id, const void *body, uint8_t size, const int32_t *values) {
+	RecorderStream *stream = &_recorder_streams[stream_id];
+	RecorderRecord *record = &stream->record;
+	uint8_t sample[CODEC_MAX_SAMPLE_SIZE];
+	uint8_t length = 0;
+
+	stream->samples++;
+
+	if (!stream->compressed) {
+		record->id = stream->id;
+		record->length = size;
+		memcpy(record->data, body, size);
+		RECORDER_Seal(stream);
+		return;
+	}
+
+	if (record->length != 0) {
+		length = CODEC_Encode(&stream->codec, values, sample);
+		if (record->length + length > RECORDER_RECORD_DATA) {
+			RECORDER_Seal(stream);
+		}
+	}
+	if (record->length == 0) {
+		// Every record starts with a keyframe
+		CODEC_Reset(&stream->codec);
+		length = CODEC_Encode(&stream->codec, values, sample);
+		record->id = stream->id | TELEMETRY_ID_COMPRESSED | TELEMETRY_ID_KEYFRAME;
+		stream->record_ms = HAL_GetTick();
+	}
+
+	memcpy(&record->data[record->length], sample, length);
+	record->length += length;
+}
+
+/**
+ * Check if a sample is logged: always in flight, once per pad period on the pad.
+ *
+ * @param stream_id: stream ID.
+ * @param timestamp_ms: sample timestamp.
+ *
+ * @retval 1 log the sample
+ * @retval 0 skip it
+ */
+static uint8_t RECORDER_Due(RecorderStreamId stream_id, uint32_t timestamp_ms) {
+	RecorderStream *stream = &_recorder_streams[stream_id];
+
+	if (_recorder_launched || stream->pad_period_ms == 0) {
+		return 1;
+	}
+	if (timestamp_ms - stream->last_ms < stream->pad_period_ms) {
+		return 0; // Pad
+	}
+	stream->last_ms = timestamp_ms;
+
+	return 1;
+}
+
+/**
+ * Log one barometer sample.
+ *
+ * @param body: packed barometer sample.
+ */
+static void RECORDER_AddBarometer(const TelemetryBaro *body) {
+	int32_t values[TELEMETRY_FIELD_COUNT_BARO];
+
+	TELEMETRY_BaroToValues(body, values);
+	RECORDER_AddSample(RECORDER_STREAM_BARO, body, sizeof(TelemetryBaro), values);
+}
+
+/**
+ * Keep a pad barometer sample in the pre-launch ring. The oldest sample leaves
+ * the ring, it is logged at the pad period.
+ *
+ * @param body: packed barometer sample.
+ */
+static void RECORDER_KeepPrelaunch(const TelemetryBaro *body) {
+	TelemetryBaro *slot = &_recorder_prelaunch[_recorder_prelaunch_count & (RECORDER_PRELAUNCH_SAMPLES - 1)];
+
+	if (_recorder_prelaunch_count >= RECORDER_PRELAUNCH_SAMPLES && RECORDER_Due(RECORDER_STREAM_BARO, slot->timestamp_ms)) {
+		RECORDER_AddBarometer(slot);
+	}
+	*slot = *body;
+	_recorder_prelaunch_count++;
+}
+
+/**
+ * Log the whole pre-launch ring, oldest first.
+ */
+static void RECORDER_FlushPrelaunch() {
+	uint32_t first = _recorder_prelaunch_count > RECORDER_PRELAUNCH_SAMPLES
+			? _recorder_prelaunch_count - RECORDER_PRELAUNCH_SAMPLES : 0;
+
+	for (uint32_t i = first; i < _recorder_prelaunch_count; i++) {
+		RECORDER_AddBarometer(&_recorder_prelaunch[i & (RECORDER_PRELAUNCH_SAMPLES - 1)]);
+		_recorder_stats.prelaunch_flushed++;
+	}
+	_recorder_prelaunch_count = 0;
+}
+
+/**
+ * Program records of the RAM double buffer, swap buffers when the programmed
+ * one is done.
+ */
+static void RECORDER_ProgramBuffers() {
+	RecorderBuffer *buffer = &_recorder_buffers[_recorder_fill ^ 1];
+
+	if (_recorder_programmed == buffer->count) {
+		buffer->count = 0;
+		_recorder_programmed = 0;
+		if (_recorder_buffers[_recorder_fill].count == 0) {
+			return; // Nothing to program
+		}
+		_recorder_fill ^= 1;
+		buffer = &_recorder_buffers[_recorder_fill ^ 1];
+	}
+
+	for (uint8_t i = 0; i < RECORDER_PROGRAM_RECORDS && _recorder_programmed < buffer->count; i++) {
+		RECORDER_Write(&buffer->records[_recorder_programmed++]);
+	}
+}
+
+/**
+ * Erase flash pages and count the scheduler ticks lost: the vector table is in
+ * flash, so interrupts wait for the end of the erase and pending ticks merge.
+ * The UART overrun of the GNSS reception is handled by its error callback.
+ *
+ * @param erase: pointer to a FLASH_EraseInitTypeDef.
+ * @param status: pointer to the HAL status of the erase, filled.
+ *
+ * @return Erase duration in us
+ */
+static uint32_t RECORDER_FlashErase(FLASH_EraseInitTypeDef *erase, HAL_StatusTypeDef *status) {
+	uint32_t page_error;
+
+	uint32_t start_tick_ms = SCHEDULER_GetTick_ms();
+	uint64_t start_us = CLOCK_GetTime_us();
+	HAL_FLASH_Unlock();
+	*status = HAL_FLASHEx_Erase(erase, &page_error);
+	HAL_FLASH_Lock();
+	uint32_t elapsed_us = CLOCK_GetTime_us() - start_us;
+	uint32_t ticks_ms = SCHEDULER_GetTick_ms() - start_tick_ms;
+
+	if (elapsed_us / 1000 > ticks_ms) {
+		_recorder_stats.lost_ticks += elapsed_us / 1000 - ticks_ms;
+	}
+
+	return elapsed_us;
+}
+
+/**
+ * Erase one page ahead of the head, on the pad only.
+ *
+ * @param now_ms: current tick.
+ */
+static void RECORDER_EraseAhead(uint32_t now_ms) {
+	if (_recorder_stats.flight_logged || FLIGHT_GetState() != FLIGHT_STATE_PAD_IDLE || FAULT_GetLast() != NULL
+			|| now_ms - _recorder_erase_ms < RECORDER_ERASE_PERIOD_MS) {
+		return;
+	}
+
+	uint16_t opened = _recorder_slot != 0 ? 1 : 0;
+	if (_recorder_stats.pages_ready + opened + RECORDER_PAD_HISTORY_PAGES >= _recorder_stats.pages) {
+		return; // Enough pages erased for a flight
+	}
+	uint16_t page = (_recorder_page + opened + _recorder_stats.pages_ready) % _recorder_stats.pages;
+
+	FLASH_EraseInitTypeDef erase = {
+		.TypeErase = FLASH_TYPEERASE_PAGES,
+		.PageAddress = (uint32_t)&_recorder_start[page * RECORDER_PAGE_SIZE],
+		.NbPages = 1
+	};
+	HAL_StatusTypeDef status;
+
+	uint32_t elapsed_us = RECORDER_FlashErase(&erase, &status);
+	if (elapsed_us > _recorder_stats.erase_max_us) {
+		_recorder_stats.erase_max_us = elapsed_us;
+	}
+
+	_recorder_erase_ms = now_ms;
+	_recorder_stats.erases++;
+	if (status == HAL_OK && RECORDER_Blank(page)) {
+		_recorder_stats.pages_ready++;
+	} else {
+		_recorder_stats.program_errors++; // Retried on the next period
+	}
+}
+
+/**
+ * Read the header of a page.
+ *
+ * @param page: page index in the recorder region.
+ * @param header: pointer to a RecorderPageHeader, filled if valid.
+ *
+ * @retval 1 valid header
+ * @retval 0 erased, page not opened
+ * @retval -1 programmed but invalid (cut by a reset or not a page header)
+ */
+static int8_t RECORDER_ReadHeader(uint16_t page, RecorderPageHeader *header) {
+	const RecorderRecord *record = RECORDER_Slot(page, 0);
+
+	_recorder_stats.mount_reads++;
+	if (record->id == RECORDER_ID_ERASED) {
+		return 0; // Erased
+	}
+	if (record->id != RECORDER_ID_PAGE || record->length != sizeof(RecorderPageHeader) || record->crc != RECORDER_Crc(record)) {
+		return -1; // Invalid
+	}
+	memcpy(header, record->data, sizeof(RecorderPageHeader));
+
+	return 1; // Valid
+}
+
+/**
+ * Check if a page follows the first written page in the sequence: the pages
+ * from the first one to the head, opened one after the other.
+ *
+ * @param first: first written page.
+ * @param sequence: sequence of the first written page.
+ * @param distance: pages from the first one, in ring order.
+ *
+ * @retval 1 in the sequence
+ * @retval 0 erased, older or invalid
+ */
+static uint8_t RECORDER_InSequence(uint16_t first, uint32_t sequence, uint16_t distance) {
+	RecorderPageHeader header;
+
+	return RECORDER_ReadHeader((first + distance) % _recorder_stats.pages, &header) == 1
+			&& header.sequence == sequence + distance;
+}
+
+/**
+ * Find the head page by reading every page header (highest sequence). Used
+ * when the sequence is broken, e.g. a page header cut by a reset.
+ *
+ * @param head: pointer to the header of the head page, filled if found.
+ *
+ * @retval 1 found
+ * @retval 0 no valid page header
+ */
+static uint8_t RECORDER_ScanHeaders(RecorderPageHeader *head) {
+	RecorderPageHeader header;
+	uint8_t found = 0;
+
+	_recorder_stats.mount_scan = 1;
+	for (uint16_t page = 0; page < _recorder_stats.pages; page++) {
+		if (RECORDER_ReadHeader(page, &header) != 1) {
+			continue; // Erased or invalid
+		}
+		if ((header.flags & RECORDER_PAGE_FLIGHT) != 0 || header.state != FLIGHT_STATE_PAD_IDLE) {
+			_recorder_stats.flight_logged = 1;
+		}
+		if (!found || (int32_t)(header.sequence - head->sequence) > 0) {
+			found = 1;
+			*head = header;
+			_recorder_page = page;
+		}
+	}
+
+	return found;
+}
+
+/**
+ * Find the head page by binary search: page headers follow the sequence of
+ * the first written page up to the head, then are erased or older. The first
+ * written page is page 0, unless erased ahead of the head on the pad (then the
+ * first page after the erased ones).
+ *
+ * @param head: pointer to the header of the head page, filled if found.
+ *
+ * @retval 1 found
+ * @retval 0 log empty
+ * @retval -1 ERROR broken sequence, scan every header
+ */
+static int8_t RECORDER_SearchHead(RecorderPageHeader *head) {
+	uint16_t pages = _recorder_stats.pages;
+	RecorderPageHeader header;
+	int8_t status;
+
+	// First written page
+	uint16_t first = 0;
+	while ((status = RECORDER_ReadHeader(first, head)) == 0) {
+		if (++first == pages) {
+			return 0; // Log empty
+		}
+	}
+	if (status != 1) {
+		return -1; // Error, invalid page header
+	}
+
+	// Last page of the sequence: first + low in it, first + high not (or back to the first page)
+	uint16_t low = 0;
+	uint16_t high = pages;
+	while (high - low > 1) {
+		uint16_t middle = (low + high) / 2;
+		if (RECORDER_InSequence(first, head->sequence, middle)) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	_recorder_page = (first + low) % pages;
+	RECORDER_ReadHeader(_recorder_page, head);
+
+	// The page after the head must be erased or older, not a newer or invalid page
+	if (low + 1 < pages) {
+		status = RECORDER_ReadHeader((_recorder_page + 1) % pages, &header);
+		if (status == -1 || (status == 1 && (int32_t)(header.sequence - head->sequence) > 0)) {
+			return -1; // Error, broken sequence
+		}
+	}
+
+	if ((head->flags & RECORDER_PAGE_FLIGHT) != 0 || head->state != FLIGHT_STATE_PAD_IDLE) {
+		_recorder_stats.flight_logged = 1;
+	}
+
+	return 1; // Found
+}
+
+/**
+ * Check the records of the head page for a flight state change out of the pad:
+ * the page header only holds the state when the page was opened.
+ *
+ * @param page: head page.
+ * @param slots: programmed slots of the page (page header included).
+ *
+ * @retval 1 launched in the page
+ * @retval 0 no launch event
+ */
+static uint8_t RECORDER_SearchLaunch(uint16_t page, uint8_t slots) {
+	TelemetryEvent event;
+
+	for (uint8_t slot = 1; slot < slots; slot++) {
+		const RecorderRecord *record = RECORDER_Slot(page, slot);
+		_recorder_stats.mount_reads++;
+		if (record->id != TELEMETRY_MSG_EVENT || record->length != sizeof(TelemetryEvent)
+				|| record->crc != RECORDER_Crc(record)) {
+			continue; // Other stream, or cut by a reset
+		}
+		memcpy(&event, record->data, sizeof(event));
+		if (event.state != FLIGHT_STATE_PAD_IDLE) {
+			return 1; // Launched
+		}
+	}
+
+	return 0; // No launch event
+}
+
+/**
+ * Find the head: the page with the highest sequence, then its first free slot
+ * (records are programmed in order). Skip the next page if its header was cut,
+ * count erased pages ahead, and check if the log holds a flight (page headers,
+ * then events of the head page).
+ */
+static void RECORDER_Mount() {
+	uint64_t start_us = CLOCK_GetTime_us();
+	RecorderPageHeader head;
+	RecorderPageHeader header;
+	int8_t found;
+
+	_recorder_page = 0;
+	_recorder_slot = 0;
+	_recorder_sequence = 0;
+	_recorder_stats.flight_logged = 0;
+	_recorder_stats.mount_scan = 0;
+	_recorder_stats.mount_reads = 0;
+
+	found = RECORDER_SearchHead(&head);
+	if (found == -1) {
+		_recorder_stats.flight_logged = 0;
+		found = RECORDER_ScanHeaders(&head);
+	}
+
+	if (found) {
+		_recorder_sequence = head.sequence + 1;
+
+		// First free slot: slot low programmed, slot high erased (or past the page)
+		uint8_t low = 0;
+		uint8_t high = RECORDER_RECORDS_PER_PAGE;
+		while (high - low > 1) {
+			uint8_t middle = (low + high) / 2;
+			_recorder_stats.mount_reads++;
+			if (RECORDER_Slot(_recorder_page, middle)->id != RECORDER_ID_ERASED) {
+				low = middle;
+			} else {
+				high = middle;
+			}
+		}
+		_recorder_slot = high;
+
+		// Flight at the head (state when the page was opened, or a launch event in it
+		// if reset in the first page after launch): kept, samples logged at full rate
+		if (head.state != FLIGHT_STATE_PAD_IDLE || RECORDER_SearchLaunch(_recorder_page, _recorder_slot)) {
+			_recorder_stats.flight_logged = 1;
+			_recorder_launched = 1;
+		}
+
+		if (_recorder_slot == RECORDER_RECORDS_PER_PAGE) {
+			_recorder_page = (_recorder_page + 1) % _recorder_stats.pages;
+			_recorder_slot = 0;
+		}
+	}
+
+	// Next page to open programmed but invalid (page header cut by a reset): skipped.
+	// Older pages with a valid header are kept, erased ahead on the pad
+	for (uint16_t i = 0; i < _recorder_stats.pages && _recorder_slot == 0; i++) {
+		if (RECORDER_ReadHeader(_recorder_page, &header) != -1) {
+			break;
+		}
+		RECORDER_SkipPage();
+	}
+
+	// Erased pages from the head (or the next page if the head page is opened), then older pages.
+	// None if the first one is programmed (older page, erased on the pad)
+	uint16_t opened = _recorder_slot != 0 ? 1 : 0;
+	uint16_t low = 0;
+	uint16_t high = _recorder_stats.pages - opened;
+	_recorder_stats.mount_reads++;
+	if (RECORDER_Slot((_recorder_page + opened) % _recorder_stats.pages, 0)->id != RECORDER_ID_ERASED) {
+		high = 0;
+	}
+	while (low < high) {
+		uint16_t middle = (low + high) / 2;
+		_recorder_stats.mount_reads++;
+		if (RECORDER_Slot((_recorder_page + opened + middle) % _recorder_stats.pages, 0)->id == RECORDER_ID_ERASED) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	_recorder_stats.pages_ready = low;
+
+	_recorder_stats.mount_us = CLOCK_GetTime_us() - start_us;
+}
+
+/**
+ * Initialize the recorder: find the head of the log, then record samples
+ * published from now on.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no recorder region or not page aligned
+ */
+int8_t RECORDER_Init() {
+	_recorder_stats = (RecorderStats){0};
+	if (((uint32_t)_recorder_start % RECORDER_PAGE_SIZE) != 0) {
+		return -1; // Error, recorder region not page aligned
+	}
+	_recorder_stats.pages = (_recorder_end - _recorder_start) / RECORDER_PAGE_SIZE;
+	if (_recorder_stats.pages == 0) {
+		return -1; // Error, no recorder region in the linker script
+	}
+
+#define RECORDER_STREAM_INIT(name, compressed_, pad_period) \
+	_recorder_streams[RECORDER_STREAM_##name] = (RecorderStream){ \
+		.id = TELEMETRY_MSG_##name, .compressed = compressed_, .pad_period_ms = pad_period }; \
+	CODEC_Init(&_recorder_streams[RECORDER_STREAM_##name].codec, TELEMETRY_FIELD_COUNT_##name, UINT16_MAX);
+	RECORDER_STREAMS(RECORDER_STREAM_INIT)
+
+	_recorder_buffers[0].count = 0;
+	_recorder_buffers[1].count = 0;
+	_recorder_fill = 0;
+	_recorder_programmed = 0;
+	_recorder_prelaunch_count = 0;
+	_recorder_launched = 0;
+
+	RECORDER_Mount();
+	_recorder_erase_ms = HAL_GetTick();
+
+	// Only record samples published from now on
+	_recorder_baro_count = BUS_GetCount(BUS_TOPIC_BARO);
+	_recorder_gnss_count = BUS_GetCount(BUS_TOPIC_GNSS);
+	_recorder_altitude_count = BUS_GetCount(BUS_TOPIC_ALTITUDE);
+	_recorder_event_count = BUS_GetCount(BUS_TOPIC_EVENT);
+
+	return 0; // OK
+}
+
+/**
+ * Record new samples from the bus (pre-launch ring flushed at launch), program
+ * buffered records and erase pages ahead on the pad. Call this function periodically (scheduler task), at
+ * least every BUS_BARO_HISTORY barometer samples.
+ */
+void RECORDER_Update() {
+	uint32_t now_ms = HAL_GetTick();
+	FlightEvent event;
+	Barometer barometer;
+	AltitudeFusion fusion;
+	L76LM33 gnss;
+
+	if (_recorder_stats.pages == 0) {
+		return; // Not initialized
+	}
+
+	// Launch declared: pad samples of the ring go ahead of live samples
+	if (!_recorder_launched && FLIGHT_GetState() != FLIGHT_STATE_PAD_IDLE) {
+		_recorder_launched = 1;
+		_recorder_stats.flight_logged = 1;
+		RECORDER_FlushPrelaunch();
+	}
+
+	// Every state change and barometer sample, oldest first (kept in the bus history)
+	uint32_t events = BUS_GetCount(BUS_TOPIC_EVENT);
+	while (_recorder_event_count != events) {
+		uint32_t age = events - _recorder_event_count - 1;
+		_recorder_event_count++;
+		if (age < BUS_EVENT_HISTORY && BUS_ReadHistory(BUS_TOPIC_EVENT, age, &event) == 0) {
+			TelemetryEvent body;
+			int32_t values[TELEMETRY_FIELD_COUNT_EVENT];
+			TELEMETRY_PackEvent(&event, &body);
+			TELEMETRY_EventToValues(&body, values);
+			RECORDER_AddSample(RECORDER_STREAM_EVENT, &body, sizeof(body), values);
+		}
+	}
+	uint32_t samples = BUS_GetCount(BUS_TOPIC_BARO);
+	while (_recorder_baro_count != samples) {
+		uint32_t age = samples - _recorder_baro_count - 1;
+		_recorder_baro_count++;
+		if (age < BUS_BARO_HISTORY && BUS_ReadHistory(BUS_TOPIC_BARO, age, &barometer) == 0) {
+			TelemetryBaro body;
+			TELEMETRY_PackBarometer(&barometer, &body);
+			if (_recorder_launched) {
+				RECORDER_AddBarometer(&body);
+			} else {
+				RECORDER_KeepPrelaunch(&body);
+			}
+		}
+	}
+	if (BUS_Read(BUS_TOPIC_ALTITUDE, &fusion, &_recorder_altitude_count) == 0
+			&& RECORDER_Due(RECORDER_STREAM_ALTITUDE, fusion.timestamp_ms)) {
+		TelemetryAltitude body;
+		int32_t values[TELEMETRY_FIELD_COUNT_ALTITUDE];
+		TELEMETRY_PackAltitude(&fusion, &body);
+		TELEMETRY_AltitudeToValues(&body, values);
+		RECORDER_AddSample(RECORDER_STREAM_ALTITUDE, &body, sizeof(body), values);
+	}
+	if (BUS_Read(BUS_TOPIC_GNSS, &gnss, &_recorder_gnss_count) == 0) {
+		TelemetryGNSS body;
+		int32_t values[TELEMETRY_FIELD_COUNT_GNSS];
+		TELEMETRY_PackGNSS(&gnss, &body);
+		TELEMETRY_GNSSToValues(&body, values);
+		RECORDER_AddSample(RECORDER_STREAM_GNSS, &body, sizeof(body), values);
+	}
+
+	// Partially filled records wait at most RECORDER_FLUSH_MS
+	for (uint8_t i = 0; i < RECORDER_STREAM_COUNT; i++) {
+		RecorderStream *stream = &_recorder_streams[i];
+		if (stream->record.length != 0 && now_ms - stream->record_ms >= RECORDER_FLUSH_MS) {
+			RECORDER_Seal(stream);
+		}
+	}
+
+	RECORDER_ProgramBuffers();
+	RECORDER_EraseAhead(now_ms);
+}
+
+/**
+ * Erase the whole log (ERASE after a download, GAUL/Download.h). Blocks ~20-40
+ * ms per page, refused in flight.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR not initialized or in flight
+ * @retval -2 ERROR erase failed
+ */
+int8_t RECORDER_Erase() {
+	FlightState state = FLIGHT_GetState();
+	if (_recorder_stats.pages == 0 || state == FLIGHT_STATE_ASCENT || state == FLIGHT_STATE_DESCENT) {
+		return -1; // Error, not initialized or in flight
+	}
+
+	FLASH_EraseInitTypeDef erase = {
+		.TypeErase = FLASH_TYPEERASE_PAGES,
+		.PageAddress = (uint32_t)_recorder_start,
+		.NbPages = _recorder_stats.pages
+	};
+	HAL_StatusTypeDef status;
+
+	RECORDER_FlashErase(&erase, &status);
+	_recorder_stats.erases += _recorder_stats.pages;
+
+	// Pending records are kept, the next page opened continues the sequence
+	uint32_t sequence = _recorder_sequence;
+	RECORDER_Mount();
+	_recorder_sequence = sequence;
+	_recorder_stats.flight_logged = state != FLIGHT_STATE_PAD_IDLE;
+
+	if (status != HAL_OK) {
+		return -2; // Error, erase failed
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Get the first (oldest) page of the log: the page after the erased pages
+ * ahead of the head.
+ *
+ * @return Page index in the recorder region
+ */
+static uint16_t RECORDER_FirstLogPage() {
+	uint16_t opened = _recorder_slot != 0 ? 1 : 0;
+	return (_recorder_page + opened + _recorder_stats.pages_ready) % _recorder_stats.pages;
+}
+
+/**
+ * Get the log size for a download: every page but the erased pages ahead of the
+ * head, oldest first. Unused slots of the head page are erased (0xFF).
+ *
+ * @return Log size in bytes (multiple of RECORDER_PAGE_SIZE), 0 if empty
+ */
+uint32_t RECORDER_GetLogSize() {
+	if (_recorder_stats.pages == 0) {
+		return 0; // Not initialized
+	}
+	return (uint32_t)(_recorder_stats.pages - _recorder_stats.pages_ready) * RECORDER_PAGE_SIZE;
+}
+
+/**
+ * Read log bytes, offset 0 is the start of the oldest page. Do not call
+ * RECORDER_Update() during a download: the log would move.
+ *
+ * @param offset: log offset.
+ * @param data: output buffer.
+ * @param size: number of bytes.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR past the end of the log
+ */
+int8_t RECORDER_ReadLog(uint32_t offset, uint8_t *data, uint16_t size) {
+	if (offset + size > RECORDER_GetLogSize()) {
+		return -1; // Error, past the end of the log
+	}
+
+	uint16_t first = RECORDER_FirstLogPage();
+	while (size != 0) {
+		uint16_t page = (first + offset / RECORDER_PAGE_SIZE) % _recorder_stats.pages;
+		uint16_t start = offset % RECORDER_PAGE_SIZE;
+		uint16_t length = RECORDER_PAGE_SIZE - start < size ? RECORDER_PAGE_SIZE - start : size;
+		memcpy(data, &_recorder_start[page * RECORDER_PAGE_SIZE + start], length);
+		data += length;
+		offset += length;
+		size -= length;
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Get recorder statistics (for debug or telemetry).
+ *
+ * @return Pointer to statistics
+ */
+const RecorderStats *RECORDER_GetStats() {
+	return &_recorder_stats;
+}
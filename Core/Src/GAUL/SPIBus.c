@@ -0,0 +1,317 @@
+/*
+ * SPIBus.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/SPIBus.h"
+
+#include "GAUL/Clock.h"
+
+#include "string.h" // for memset()
+
+// Pointer to SPI handler
+SPI_HandleTypeDef *SPIBUS_hspi = NULL;
+
+typedef struct {
+	GPIO_TypeDef *port;
+	uint16_t pin;
+} SPIBusChipSelect;
+
+static SPIBusChipSelect _spibus_cs[SPIBUS_DEVICE_COUNT] = { 0 };
+
+// Transactions queue: the tail is written by the main loop (SPIBUS_Submit()),
+// the head by the DMA interrupt, or by the main loop with interrupts masked
+static SPIBusTransaction *_spibus_queue[SPIBUS_QUEUE_SIZE];
+static volatile uint8_t _spibus_head = 0;
+static volatile uint8_t _spibus_tail = 0;
+
+// Transaction in progress (NULL: bus idle) and its phase (0: TX bytes, 1: RX bytes)
+static SPIBusTransaction *volatile _spibus_active = NULL;
+static volatile uint8_t _spibus_rx_phase = 0;
+
+static SPIBusStats _spibus_stats = { 0 };
+
+/**
+ * Initialize the SPI bus manager.
+ *
+ * @param hspi: pointer to a HAL SPI handler (owned by the manager), with TX and RX DMA channels.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no DMA channel
+ */
+int8_t SPIBUS_Init(SPI_HandleTypeDef *hspi) {
+	if (hspi == NULL || hspi->hdmatx == NULL || hspi->hdmarx == NULL) {
+		return -1; // Error, DMA channels not linked (see the .ioc)
+	}
+
+	SPIBUS_hspi = hspi;
+	_spibus_head = _spibus_tail = 0;
+	_spibus_active = NULL;
+	_spibus_stats.window_us = CLOCK_GetTime_us();
+
+	return 0; // OK
+}
+
+/**
+ * Set the chip select of a device (GPIO output, high when idle). Called by the
+ * device driver initialization.
+ *
+ * @param device: SPIBUS_DEVICE_*.
+ * @param port: GPIO port of the chip select.
+ * @param pin: GPIO pin of the chip select.
+ */
+void SPIBUS_SetChipSelect(SPIBusDevice device, GPIO_TypeDef *port, uint16_t pin) {
+	if (device < SPIBUS_DEVICE_COUNT) {
+		_spibus_cs[device].port = port;
+		_spibus_cs[device].pin = pin;
+		HAL_GPIO_WritePin(port, pin, GPIO_PIN_SET);
+	}
+}
+
+/**
+ * Start the DMA transfer of the current phase of the active transaction.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR HAL
+ */
+static int8_t SPIBUS_StartPhase() {
+	SPIBusTransaction *transaction = _spibus_active;
+
+	if (!_spibus_rx_phase && transaction->tx_size > 0) {
+		if (HAL_SPI_Transmit_DMA(SPIBUS_hspi, (uint8_t *)transaction->tx, transaction->tx_size) != HAL_OK) {
+			return -1; // Error, HAL
+		}
+		return 0; // OK
+	}
+
+	// The RX buffer is also sent (full duplex), dummy bytes
+	_spibus_rx_phase = 1;
+	memset(transaction->rx, 0xFF, transaction->rx_size);
+	if (HAL_SPI_Receive_DMA(SPIBUS_hspi, transaction->rx, transaction->rx_size) != HAL_OK) {
+		return -1; // Error, HAL
+	}
+
+	return 0; // OK
+}
+
+/**
+ * End the active transaction: raise its chip select, then call its callback.
+ */
+static void SPIBUS_End(int8_t status) {
+	SPIBusTransaction *transaction = _spibus_active;
+	SPIBusChipSelect *cs = &_spibus_cs[transaction->device];
+	HAL_GPIO_WritePin(cs->port, cs->pin, GPIO_PIN_SET);
+
+	SPIBusDeviceStats *stats = &_spibus_stats.device[transaction->device];
+	stats->transactions++;
+	if (status == 0) {
+		stats->bytes += transaction->tx_size + transaction->rx_size;
+		stats->window_bytes += transaction->tx_size + transaction->rx_size;
+	} else {
+		stats->errors++;
+	}
+
+	_spibus_active = NULL;
+	transaction->status = status;
+	if (transaction->callback != NULL) {
+		transaction->callback(transaction);
+	}
+}
+
+/**
+ * Start queued transactions until one is in progress. Called from the DMA
+ * interrupt, or from the main loop with interrupts masked.
+ */
+static void SPIBUS_StartNext() {
+	while (_spibus_active == NULL && _spibus_head != _spibus_tail) {
+		_spibus_active = _spibus_queue[_spibus_head % SPIBUS_QUEUE_SIZE];
+		_spibus_head++;
+		_spibus_rx_phase = 0;
+
+		SPIBusChipSelect *cs = &_spibus_cs[_spibus_active->device];
+		HAL_GPIO_WritePin(cs->port, cs->pin, GPIO_PIN_RESET);
+		if (SPIBUS_StartPhase() != 0) {
+			SPIBUS_End(-1); // Chip select raised, next transaction
+		}
+	}
+}
+
+/**
+ * Queue a transaction, it starts right away if the bus is idle. Call from the
+ * main loop only.
+ *
+ * @param transaction: caller owned transaction, valid until its status is not SPIBUS_PENDING.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR queue full
+ * @retval -2 ERROR invalid transaction, device without chip select, or not initialized
+ */
+int8_t SPIBUS_Submit(SPIBusTransaction *transaction) {
+	if (SPIBUS_hspi == NULL || transaction->device >= SPIBUS_DEVICE_COUNT || _spibus_cs[transaction->device].port == NULL
+			|| (transaction->tx_size == 0 && transaction->rx_size == 0)) {
+		return -2; // Error, invalid transaction
+	}
+	if ((uint8_t)(_spibus_tail - _spibus_head) >= SPIBUS_QUEUE_SIZE) {
+		_spibus_stats.queue_full++;
+		return -1; // Error, queue full
+	}
+
+	transaction->status = SPIBUS_PENDING;
+	_spibus_queue[_spibus_tail % SPIBUS_QUEUE_SIZE] = transaction;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq(); // The DMA interrupt also starts transactions
+	_spibus_tail++;
+	uint8_t pending = SPIBUS_GetPending();
+	if (pending > _spibus_stats.queue_max) {
+		_spibus_stats.queue_max = pending;
+	}
+	SPIBUS_StartNext();
+	__set_PRIMASK(primask);
+
+	return 0; // OK
+}
+
+/**
+ * Run a transaction and wait for its end (blocking). Call from the main loop only.
+ * If the bus is stuck, it is reset (every queued transaction fails).
+ *
+ * @param device: SPIBUS_DEVICE_*.
+ * @param tx: bytes sent first.
+ * @param tx_size: TX bytes count.
+ * @param rx: bytes received after the TX bytes.
+ * @param rx_size: RX bytes count.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR SPI, queue full or timeout
+ */
+int8_t SPIBUS_Transfer(SPIBusDevice device, const uint8_t *tx, uint16_t tx_size, uint8_t *rx, uint16_t rx_size) {
+	SPIBusTransaction transaction = { device, tx, tx_size, rx, rx_size, NULL, NULL, 0 };
+	if (SPIBUS_Submit(&transaction) != 0) {
+		return -1; // Error, queue full
+	}
+
+	// Microsecond clock: runs with interrupts masked, unlike the HAL tick
+	uint32_t timeout_us = (SPIBUS_TIMEOUT_MS + (tx_size + rx_size) / SPIBUS_BYTES_PER_MS) * 1000;
+	uint64_t start_us = CLOCK_GetTime_us();
+	while (transaction.status == SPIBUS_PENDING) {
+		if (CLOCK_GetTime_us() - start_us > timeout_us) {
+			SPIBUS_Reset(); // Fails this transaction too
+		}
+	}
+
+	return transaction.status == 0 ? 0 : -1;
+}
+
+/**
+ * Abort the transfer in progress, raise every chip select and fail every queued
+ * transaction (callbacks called). Call from the main loop only.
+ */
+void SPIBUS_Reset() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	HAL_SPI_Abort(SPIBUS_hspi);
+	_spibus_stats.resets++;
+
+	for (uint8_t i = 0; i < SPIBUS_DEVICE_COUNT; i++) {
+		if (_spibus_cs[i].port != NULL) {
+			HAL_GPIO_WritePin(_spibus_cs[i].port, _spibus_cs[i].pin, GPIO_PIN_SET);
+		}
+	}
+
+	if (_spibus_active != NULL) {
+		SPIBUS_End(-1);
+	}
+	while (_spibus_head != _spibus_tail) {
+		_spibus_active = _spibus_queue[_spibus_head % SPIBUS_QUEUE_SIZE];
+		_spibus_head++;
+		SPIBUS_End(-1);
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Get the number of transactions queued or in progress.
+ *
+ * @return Transactions count
+ */
+uint8_t SPIBUS_GetPending() {
+	return (uint8_t)(_spibus_tail - _spibus_head) + (_spibus_active != NULL);
+}
+
+/**
+ * Callback called when a DMA transfer is complete. It is called when
+ * HAL_SPI_TxCpltCallback, HAL_SPI_RxCpltCallback or HAL_SPI_TxRxCpltCallback
+ * is called.
+ *
+ * @param hspi: pointer to a HAL SPI handler triggering the callback
+ */
+void SPIBUS_CpltCallback(SPI_HandleTypeDef *hspi) {
+	if (SPIBUS_hspi == NULL || hspi->Instance != SPIBUS_hspi->Instance || _spibus_active == NULL) {
+		return;
+	}
+
+	if (!_spibus_rx_phase && _spibus_active->rx_size > 0) {
+		// TX bytes sent, receive with the chip select still low
+		_spibus_rx_phase = 1;
+		if (SPIBUS_StartPhase() == 0) {
+			return; // RX phase started
+		}
+		SPIBUS_End(-1);
+	} else {
+		SPIBUS_End(0);
+	}
+
+	SPIBUS_StartNext();
+}
+
+/**
+ * Callback called on SPI or DMA errors. It is called when HAL_SPI_ErrorCallback
+ * is called. The transaction fails, the next one starts.
+ *
+ * @param hspi: pointer to a HAL SPI handler triggering the callback
+ */
+void SPIBUS_ErrorCallback(SPI_HandleTypeDef *hspi) {
+	if (SPIBUS_hspi == NULL || hspi->Instance != SPIBUS_hspi->Instance || _spibus_active == NULL) {
+		return;
+	}
+
+	SPIBUS_End(-1);
+	SPIBUS_StartNext();
+}
+
+/**
+ * Compute the devices throughput over the window since the last call, then
+ * start a new window. Call this function periodically.
+ */
+void SPIBUS_Update() {
+	uint64_t now_us = CLOCK_GetTime_us();
+	uint32_t window_us = now_us - _spibus_stats.window_us;
+	if (window_us == 0) {
+		return; // Empty window
+	}
+
+	for (uint8_t i = 0; i < SPIBUS_DEVICE_COUNT; i++) {
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		uint32_t bytes = _spibus_stats.device[i].window_bytes;
+		_spibus_stats.device[i].window_bytes = 0;
+		__set_PRIMASK(primask);
+		_spibus_stats.device[i].bytes_per_s = (uint64_t)bytes * 1000000 / window_us;
+	}
+
+	_spibus_stats.window_us = now_us;
+}
+
+/**
+ * Get SPI bus statistics (for debug or telemetry).
+ *
+ * @return Pointer to statistics
+ */
+const SPIBusStats *SPIBUS_GetStats() {
+	return &_spibus_stats;
+}
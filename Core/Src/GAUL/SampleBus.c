@@ -0,0 +1,165 @@
+/*
+ * SampleBus.c
+ *
+ * Publish/subscribe sample bus between drivers and consumers. Each topic is a
+ * latest-value slot protected by a sequence lock, with a small history ring.
+ * Producers publish without knowing the consumers, and consumers read a
+ * consistent sample (no torn reads) without locks.
+ *
+ * One writer per topic. A reader never blocks the writer: if the writer is
+ * updating the slot, the reader retries, then gives up (an interrupt reading
+ * a topic written by the main loop can't wait for the writer to finish).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/SampleBus.h"
+
+#include "GAUL/Barometer.h"
+#include "GAUL/AltitudeFusion.h"
+#include "GAUL/FlightState.h"
+#include "GAUL_Drivers/L76LM33.h"
+
+#include "string.h" // for memcpy(), NULL
+
+Barometer _bus_baro_samples[BUS_BARO_HISTORY];
+L76LM33 _bus_gnss_samples[BUS_GNSS_HISTORY];
+AltitudeFusion _bus_altitude_samples[BUS_ALTITUDE_HISTORY];
+FlightEvent _bus_event_samples[BUS_EVENT_HISTORY];
+
+BusTopicSlot _bus_topics[BUS_TOPIC_COUNT] = {
+	[BUS_TOPIC_BARO] = { 0, sizeof(Barometer), BUS_BARO_HISTORY, (uint8_t *)_bus_baro_samples },
+	[BUS_TOPIC_GNSS] = { 0, sizeof(L76LM33), BUS_GNSS_HISTORY, (uint8_t *)_bus_gnss_samples },
+	[BUS_TOPIC_ALTITUDE] = { 0, sizeof(AltitudeFusion), BUS_ALTITUDE_HISTORY, (uint8_t *)_bus_altitude_samples },
+	[BUS_TOPIC_EVENT] = { 0, sizeof(FlightEvent), BUS_EVENT_HISTORY, (uint8_t *)_bus_event_samples },
+};
+
+/**
+ * Publish a sample on a topic. Only one context may publish on a topic.
+ *
+ * @param topic: topic to publish on.
+ * @param sample: pointer to the sample (type of the topic).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t BUS_Publish(BusTopic topic, const void *sample) {
+	if (topic >= BUS_TOPIC_COUNT) {
+		return -1; // Error, unknown topic
+	}
+
+	BusTopicSlot *slot = &_bus_topics[topic];
+	uint32_t sequence = slot->sequence;
+	uint8_t index = (sequence / 2) % slot->history;
+
+	// Odd sequence: sample is being written
+	slot->sequence = sequence + 1;
+	__DMB();
+	memcpy(&slot->samples[index * slot->sample_size], sample, slot->sample_size);
+	__DMB();
+	slot->sequence = sequence + 2;
+
+	return 0; // OK
+}
+
+/**
+ * Copy a sample of a topic, retrying while the writer updates the slot.
+ *
+ * @param slot: pointer to the topic slot.
+ * @param age: 0 for the latest sample, 1 for the previous one, etc.
+ * @param sample: pointer to a sample (type of the topic) to update.
+ * @param published: pointer to store the number of samples published when the sample was read.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR not published yet or too old
+ * @retval -2 ERROR writer busy
+ */
+static int8_t BUS_ReadSlot(BusTopicSlot *slot, uint8_t age, void *sample, uint32_t *published) {
+	for (uint8_t retry = 0; retry < BUS_READ_RETRIES; retry++) {
+		uint32_t sequence = slot->sequence;
+		if (sequence & 1) {
+			continue; // Writer busy
+		}
+
+		*published = sequence / 2;
+		if (age >= *published || age >= slot->history) {
+			return -1; // Error, not published yet or too old
+		}
+
+		uint8_t index = (*published - 1 - age) % slot->history;
+		__DMB();
+		memcpy(sample, &slot->samples[index * slot->sample_size], slot->sample_size);
+		__DMB();
+
+		if (slot->sequence == sequence) {
+			return 0; // OK, not overwritten while reading
+		}
+	}
+
+	return -2; // Error, writer busy
+}
+
+/**
+ * Read the latest sample of a topic.
+ *
+ * @param topic: topic to read.
+ * @param sample: pointer to a sample (type of the topic) to update.
+ * @param count: pointer to the number of samples published at the last read, can be NULL.
+ *               If not NULL, only a new sample is read, and the count is updated.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR nothing new published
+ * @retval -2 ERROR writer busy
+ */
+int8_t BUS_Read(BusTopic topic, void *sample, uint32_t *count) {
+	if (topic >= BUS_TOPIC_COUNT) {
+		return -1; // Error, unknown topic
+	}
+	if (count != NULL && BUS_GetCount(topic) == *count) {
+		return -1; // Nothing new
+	}
+
+	uint32_t published;
+	int8_t status = BUS_ReadSlot(&_bus_topics[topic], 0, sample, &published);
+	if (status == 0 && count != NULL) {
+		*count = published;
+	}
+
+	return status;
+}
+
+/**
+ * Read a previous sample of a topic.
+ *
+ * @param topic: topic to read.
+ * @param age: 0 for the latest sample, 1 for the previous one, etc.
+ * @param sample: pointer to a sample (type of the topic) to update.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR not published yet or too old
+ * @retval -2 ERROR writer busy
+ */
+int8_t BUS_ReadHistory(BusTopic topic, uint8_t age, void *sample) {
+	if (topic >= BUS_TOPIC_COUNT) {
+		return -1; // Error, unknown topic
+	}
+
+	uint32_t published;
+	return BUS_ReadSlot(&_bus_topics[topic], age, sample, &published);
+}
+
+/**
+ * Get the number of samples published on a topic.
+ *
+ * @param topic: topic.
+ *
+ * @return Number of samples published
+ */
+uint32_t BUS_GetCount(BusTopic topic) {
+	if (topic >= BUS_TOPIC_COUNT) {
+		return 0;
+	}
+
+	return _bus_topics[topic].sequence / 2;
+}
@@ -0,0 +1,164 @@
+/*
+ * SampleCodec.c
+ *
+ * Streaming compressor for sample series (telemetry and logs). A sample is a
+ * set of scaled integer fields. Each field is sent as the difference with the
+ * same field of the previous sample, zigzag mapped (small negative values become
+ * small positive values), then as a varint (7 bits per byte, bit 7 set when
+ * more bytes follow). Slowly changing fields take 1 or 2 bytes instead of 4.
+ *
+ * A keyframe (absolute values, same encoding) is sent every keyframe_interval
+ * samples, and after CODEC_Reset() (e.g. a frame was dropped), so a decoder
+ * recovers from a lost frame.
+ *
+ * No HAL dependency: also built in host tools (Tools/codec_bench.c).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/SampleCodec.h"
+
+/**
+ * Initialize a codec (encoder or decoder). The first sample is a keyframe.
+ *
+ * @param codec: pointer to a SampleCodec structure.
+ * @param field_count: fields per sample, at most CODEC_MAX_FIELDS.
+ * @param keyframe_interval: samples between keyframes.
+ */
+void CODEC_Init(SampleCodec *codec, uint8_t field_count, uint16_t keyframe_interval) {
+	codec->field_count = field_count > CODEC_MAX_FIELDS ? CODEC_MAX_FIELDS : field_count;
+	codec->keyframe_interval = keyframe_interval;
+	CODEC_Reset(codec);
+}
+
+/**
+ * Force a keyframe on the next sample.
+ *
+ * @param codec: pointer to a SampleCodec structure.
+ */
+void CODEC_Reset(SampleCodec *codec) {
+	codec->since_keyframe = 0;
+	for (uint8_t i = 0; i < CODEC_MAX_FIELDS; i++) {
+		codec->previous[i] = 0;
+	}
+}
+
+/**
+ * Check if the next encoded sample is a keyframe.
+ *
+ * @param codec: pointer to a SampleCodec structure.
+ *
+ * @retval 1 keyframe
+ * @retval 0 delta
+ */
+uint8_t CODEC_KeyframeDue(const SampleCodec *codec) {
+	return codec->since_keyframe == 0 || codec->since_keyframe >= codec->keyframe_interval;
+}
+
+/**
+ * Encode one sample, as a keyframe if CODEC_KeyframeDue().
+ *
+ * @param codec: pointer to a SampleCodec structure.
+ * @param values: field_count values.
+ * @param out: output, at least CODEC_MAX_SAMPLE_SIZE bytes.
+ *
+ * @return Encoded length (in bytes)
+ */
+uint8_t CODEC_Encode(SampleCodec *codec, const int32_t *values, uint8_t *out) {
+	uint8_t length = 0;
+
+	if (CODEC_KeyframeDue(codec)) {
+		codec->since_keyframe = 0;
+		for (uint8_t i = 0; i < codec->field_count; i++) {
+			codec->previous[i] = 0; // Keyframe: delta against 0
+		}
+	}
+
+	for (uint8_t i = 0; i < codec->field_count; i++) {
+		// Wrapping difference, a 32-bit counter or timestamp stays small
+		int32_t delta = (int32_t)((uint32_t)values[i] - (uint32_t)codec->previous[i]);
+		uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+		length += CODEC_PutVarint(&out[length], zigzag);
+		codec->previous[i] = values[i];
+	}
+	codec->since_keyframe++;
+
+	return length;
+}
+
+/**
+ * Decode one sample.
+ *
+ * @param codec: pointer to a SampleCodec structure.
+ * @param in: encoded bytes.
+ * @param length: number of bytes available.
+ * @param keyframe: 1 if the sample is a keyframe.
+ * @param values: output, field_count values.
+ *
+ * @return Decoded length (in bytes)
+ * @retval -1 ERROR truncated sample
+ */
+int8_t CODEC_Decode(SampleCodec *codec, const uint8_t *in, uint8_t length, uint8_t keyframe, int32_t *values) {
+	uint8_t position = 0;
+
+	if (keyframe) {
+		for (uint8_t i = 0; i < codec->field_count; i++) {
+			codec->previous[i] = 0;
+		}
+	}
+
+	for (uint8_t i = 0; i < codec->field_count; i++) {
+		uint32_t zigzag;
+		int8_t size = CODEC_GetVarint(&in[position], length - position, &zigzag);
+		if (size < 0) {
+			return -1; // Error, truncated sample
+		}
+		position += size;
+
+		int32_t delta = (int32_t)((zigzag >> 1) ^ -(zigzag & 1));
+		values[i] = (int32_t)((uint32_t)codec->previous[i] + (uint32_t)delta);
+		codec->previous[i] = values[i];
+	}
+
+	return position;
+}
+
+/**
+ * Write an unsigned varint (7 bits per byte, least significant first).
+ *
+ * @param out: output, at least 5 bytes.
+ * @param value: value to write.
+ *
+ * @return Written length (1 to 5 bytes)
+ */
+uint8_t CODEC_PutVarint(uint8_t *out, uint32_t value) {
+	uint8_t length = 0;
+	while (value >= 0x80) {
+		out[length++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	out[length++] = value;
+	return length;
+}
+
+/**
+ * Read an unsigned varint.
+ *
+ * @param in: encoded bytes.
+ * @param length: number of bytes available.
+ * @param value: output value.
+ *
+ * @return Read length (1 to 5 bytes)
+ * @retval -1 ERROR truncated or too long
+ */
+int8_t CODEC_GetVarint(const uint8_t *in, uint8_t length, uint32_t *value) {
+	*value = 0;
+	for (uint8_t i = 0; i < length && i < 5; i++) {
+		*value |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+		if ((in[i] & 0x80) == 0) {
+			return i + 1;
+		}
+	}
+	return -1; // Error, truncated or too long
+}
@@ -0,0 +1,222 @@
+/*
+ * Scheduler.c
+ *
+ * Static rate monotonic task scheduler. A hardware timer (1 MHz counter,
+ * 1 kHz update interrupt) gives the tick. Tasks run to completion in the main
+ * loop, the shortest period ready task first. The core sleeps (WFI) when no
+ * task is ready.
+ *
+ * Each task records its worst case execution time (from the timer counter,
+ * 1 us resolution) and its overruns (a release missed because the task
+ * didn't complete before its next release). Task and sleep cycles are also
+ * accounted by the CPU load meter (GAUL/CpuLoad.h).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Scheduler.h"
+#include "GAUL/CpuLoad.h"
+#include "GAUL/Fault.h"
+
+// Pointer to TIM handler
+TIM_HandleTypeDef *SCHEDULER_htim;
+
+SchedulerTask _scheduler_tasks[SCHEDULER_MAX_TASKS];
+uint8_t _scheduler_task_count = 0;
+
+// Incremented every 1 ms by the timer update interrupt
+volatile uint32_t _scheduler_tick_ms = 0;
+
+// Running task, -1 if none
+int8_t _scheduler_current = -1;
+
+/**
+ * Initialize scheduler and start its timer. The timer must count at 1 MHz
+ * and overflow every 1 ms.
+ *
+ * @param htim: pointer to a HAL TIM handler.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t SCHEDULER_Init(TIM_HandleTypeDef *htim) {
+	SCHEDULER_htim = htim;
+	_scheduler_task_count = 0;
+	_scheduler_tick_ms = 0;
+
+	if (HAL_TIM_Base_Start_IT(SCHEDULER_htim) != HAL_OK) {
+		return -1; // Error with TIM
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Register a periodic task. The first release is immediate.
+ *
+ * @param name: task name (for debug).
+ * @param function: task function, must run to completion.
+ * @param period_ms: task period in ms.
+ *
+ * @return Task ID, or -1 if there are too many tasks
+ */
+int8_t SCHEDULER_AddTask(const char *name, SchedulerFunction function, uint32_t period_ms) {
+	if (_scheduler_task_count >= SCHEDULER_MAX_TASKS || function == NULL || period_ms == 0) {
+		return -1; // Error
+	}
+
+	SchedulerTask *task = &_scheduler_tasks[_scheduler_task_count];
+	task->name = name;
+	task->function = function;
+	task->period_ms = period_ms;
+	task->release_ms = _scheduler_tick_ms;
+	task->runs = 0;
+	task->overruns = 0;
+	task->last_us = 0;
+	task->wcet_us = 0;
+
+	return _scheduler_task_count++;
+}
+
+/**
+ * Change period of a task. Takes effect from its next release.
+ *
+ * @param task_id: ID returned by SCHEDULER_AddTask.
+ * @param period_ms: new task period in ms.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t SCHEDULER_SetPeriod(int8_t task_id, uint32_t period_ms) {
+	if (task_id < 0 || task_id >= _scheduler_task_count || period_ms == 0) {
+		return -1; // Error
+	}
+
+	_scheduler_tasks[task_id].period_ms = period_ms;
+
+	return 0; // OK
+}
+
+/**
+ * Callback called on timer update. It is called when HAL_TIM_PeriodElapsedCallback is called.
+ *
+ * @param htim: pointer to a HAL TIM handler triggering the callback
+ */
+void SCHEDULER_TickCallback(TIM_HandleTypeDef *htim) {
+	if (htim->Instance == SCHEDULER_htim->Instance) {
+		_scheduler_tick_ms++;
+	}
+}
+
+/**
+ * Run the highest priority (shortest period) ready task, or sleep until the
+ * next interrupt if no task is ready. Call this function in the main loop.
+ */
+void SCHEDULER_Dispatch() {
+	uint32_t now_ms = _scheduler_tick_ms;
+	SchedulerTask *ready = NULL;
+
+	// Rate monotonic priority: shortest period first
+	for (uint8_t i = 0; i < _scheduler_task_count; i++) {
+		SchedulerTask *task = &_scheduler_tasks[i];
+		if ((int32_t)(now_ms - task->release_ms) >= 0 && (ready == NULL || task->period_ms < ready->period_ms)) {
+			ready = task;
+		}
+	}
+
+	if (ready == NULL) {
+		// Nothing to do until next tick or interrupt. Only the tick releases
+		// tasks: check it again with interrupts masked, so a tick after the
+		// scan is not slept through. A pending interrupt still ends WFI with
+		// PRIMASK set, and runs once interrupts are enabled again.
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		if (_scheduler_tick_ms == now_ms) {
+			CPULOAD_Sleep();
+		}
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	_scheduler_current = ready - _scheduler_tasks;
+	FAULT_Trace(FAULT_TRACE_TASK, _scheduler_current);
+
+	uint32_t start_us = SCHEDULER_GetTime_us();
+	uint32_t start_cycles = CPULOAD_GetThreadCycles();
+	ready->function();
+	CPULOAD_AddTask(_scheduler_current, CPULOAD_GetThreadCycles() - start_cycles);
+	uint32_t end_us = SCHEDULER_GetTime_us();
+
+	_scheduler_current = -1;
+
+	ready->runs++;
+	ready->last_us = end_us - start_us;
+	if (ready->last_us > ready->wcet_us) {
+		ready->wcet_us = ready->last_us;
+	}
+
+	// Next release, skip (and count) the releases already missed
+	ready->release_ms += ready->period_ms;
+	while ((int32_t)(_scheduler_tick_ms - ready->release_ms) >= 0) {
+		ready->release_ms += ready->period_ms;
+		ready->overruns++;
+	}
+}
+
+/**
+ * Get scheduler tick.
+ *
+ * @return Tick in ms
+ */
+uint32_t SCHEDULER_GetTick_ms() {
+	return _scheduler_tick_ms;
+}
+
+/**
+ * Get scheduler time with 1 us resolution (wraps every ~71 minutes,
+ * only use it for differences).
+ *
+ * @return Time in us
+ */
+uint32_t SCHEDULER_GetTime_us() {
+	uint32_t tick_ms;
+	uint32_t counter;
+
+	// Read again if the tick changed while reading the counter
+	do {
+		tick_ms = _scheduler_tick_ms;
+		counter = __HAL_TIM_GET_COUNTER(SCHEDULER_htim);
+	} while (tick_ms != _scheduler_tick_ms);
+
+	// Counter overflowed, but the update interrupt is not serviced yet (interrupts masked)
+	if (__HAL_TIM_GET_FLAG(SCHEDULER_htim, TIM_FLAG_UPDATE) && counter < 500) {
+		tick_ms++;
+	}
+
+	return tick_ms * 1000 + counter;
+}
+
+/**
+ * Get the running task (for fault capture).
+ *
+ * @return Task ID, -1 if no task is running
+ */
+int8_t SCHEDULER_GetCurrentTask() {
+	return _scheduler_current;
+}
+
+/**
+ * Get task statistics (for debug or telemetry).
+ *
+ * @param task_id: ID returned by SCHEDULER_AddTask.
+ *
+ * @return Pointer to the task, NULL if not found
+ */
+const SchedulerTask *SCHEDULER_GetTask(int8_t task_id) {
+	if (task_id < 0 || task_id >= _scheduler_task_count) {
+		return NULL;
+	}
+
+	return &_scheduler_tasks[task_id];
+}
@@ -0,0 +1,707 @@
+/*
+ * Telemetry.c
+ *
+ * Binary telemetry downlink over UART. New samples are read from the sample bus,
+ * packed in compact little endian messages with scaled integer fields (layout in
+ * GAUL/TelemetrySchema.h, shared with the host decoder), framed, then queued in
+ * a TX ring. The ring is sent by DMA: the main loop never waits
+ * for the UART, and a frame is dropped when the ring is full.
+ *
+ * Frame format:
+ * COBS(<message ID> <stream sequence> <body> <CRC16 low> <CRC16 high>) 0x00
+ *
+ * CRC16 is CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) over ID,
+ * sequence and body. COBS (GAUL/Cobs.h) removes every 0x00 from the frame, so
+ * 0x00 only marks the end of a frame and a receiver resynchronizes on the next
+ * one.
+ *
+ * Only the main loop (tasks) queues data, only the TX complete interrupt moves
+ * the ring tails. The next DMA transfer is started from the TX complete callback.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/Telemetry.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/CpuLoad.h"
+#include "GAUL/TimeSync.h"
+#include "GAUL/Fault.h"
+
+// Pointer to UART handler
+UART_HandleTypeDef *TELEMETRY_huart;
+
+uint8_t _telemetry_ring_data[TELEMETRY_RING_SIZE];
+uint8_t _telemetry_priority_ring_data[TELEMETRY_PRIORITY_RING_SIZE];
+TelemetryRing _telemetry_ring = { _telemetry_ring_data, TELEMETRY_RING_SIZE, 0, 0 };
+TelemetryRing _telemetry_priority_ring = { _telemetry_priority_ring_data, TELEMETRY_PRIORITY_RING_SIZE, 0, 0 };
+
+// Current DMA transfer
+TelemetryRing *volatile _telemetry_tx_ring = NULL;	// NULL if idle
+volatile uint16_t _telemetry_tx_length = 0;
+TelemetryRing *_telemetry_tx_continue = NULL;		// Ring of an unfinished frame (wrapped or chunked)
+volatile uint8_t _telemetry_paused = 0;				// 1: no new transfer, the UART is lent (GAUL/Download.h)
+
+TelemetryStats _telemetry_stats;
+TelemetryStream _telemetry_streams[TELEMETRY_STREAM_COUNT];
+
+// Decimation threshold of each priority (permille of the TX ring)
+const uint16_t _telemetry_backpressure_permille[] = {
+	1000, // Critical, never decimated
+	TELEMETRY_BACKPRESSURE_HIGH_PERMILLE,
+	TELEMETRY_BACKPRESSURE_NORMAL_PERMILLE,
+	TELEMETRY_BACKPRESSURE_LOW_PERMILLE
+};
+
+// Bus samples already sent
+uint32_t _telemetry_baro_count;
+uint32_t _telemetry_gnss_count;
+uint32_t _telemetry_altitude_count;
+uint32_t _telemetry_event_count;
+
+uint32_t _telemetry_rate_ms;
+
+// Accounting window
+uint32_t _telemetry_window_ms;
+uint32_t _telemetry_window_frames;
+uint32_t _telemetry_window_bytes;
+
+/**
+ * Start a DMA transfer if the UART is idle: the end of an unfinished frame
+ * first, then the priority ring, then the TX ring. Call with interrupts
+ * disabled, or from the TX complete callback.
+ */
+static void TELEMETRY_StartTx() {
+	if (_telemetry_tx_ring != NULL || _telemetry_paused) {
+		return; // Busy or paused
+	}
+
+	TelemetryRing *ring = _telemetry_tx_continue;
+	if (ring == NULL) {
+		ring = _telemetry_priority_ring.head != _telemetry_priority_ring.tail ? &_telemetry_priority_ring : &_telemetry_ring;
+	}
+	if (ring->head == ring->tail) {
+		return; // Nothing to send
+	}
+
+	uint32_t start = ring->tail & (ring->size - 1);
+	uint32_t length = ring->head - ring->tail;
+	if (start + length > ring->size) {
+		length = ring->size - start; // Wrapped part goes in the next transfer
+	}
+	if (length > TELEMETRY_MAX_TX_CHUNK) {
+		// End on the last frame delimiter of the chunk (0x00 only ends frames)
+		length = TELEMETRY_MAX_TX_CHUNK;
+		while (length > 1 && ring->data[start + length - 1] != 0x00) {
+			length--;
+		}
+		if (ring->data[start + length - 1] != 0x00) {
+			length = TELEMETRY_MAX_TX_CHUNK; // No delimiter, continue the frame next time
+		}
+	}
+	_telemetry_tx_continue = ring->data[start + length - 1] != 0x00 ? ring : NULL;
+
+	_telemetry_tx_ring = ring;
+	_telemetry_tx_length = length;
+	if (HAL_UART_Transmit_DMA(TELEMETRY_huart, &ring->data[start], length) != HAL_OK) {
+		_telemetry_tx_ring = NULL; // Retried on the next queued frame
+		_telemetry_stats.tx_errors++;
+	}
+}
+
+/**
+ * Copy a whole frame to a ring and start sending. Bytes are queued all
+ * together or not at all.
+ *
+ * @param ring: TX ring or priority ring.
+ * @param data: bytes to queue.
+ * @param length: number of bytes.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR ring full
+ */
+static int8_t TELEMETRY_Queue(TelemetryRing *ring, const uint8_t *data, uint16_t length) {
+	uint32_t used = ring->head - ring->tail;
+	if (used + length > ring->size) {
+		return -1; // Error, ring full
+	}
+
+	uint32_t head = ring->head;
+	for (uint16_t i = 0; i < length; i++) {
+		ring->data[(head + i) & (ring->size - 1)] = data[i];
+	}
+	// Publish bytes before moving the head
+	ring->head = head + length;
+
+	used += length;
+	if (ring == &_telemetry_ring && used > _telemetry_stats.max_used) {
+		_telemetry_stats.max_used = used;
+	}
+	_telemetry_stats.bytes_queued += length;
+	_telemetry_window_bytes += length;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	TELEMETRY_StartTx();
+	__set_PRIMASK(primask);
+
+	return 0; // OK
+}
+
+/**
+ * Check if a stream sample is due: target period elapsed and not decimated.
+ *
+ * @param stream: stream ID.
+ * @param now_ms: current tick.
+ *
+ * @retval 1 send the sample
+ * @retval 0 skip it
+ */
+static uint8_t TELEMETRY_Due(TelemetryStreamId stream_id, uint32_t now_ms) {
+	TelemetryStream *stream = &_telemetry_streams[stream_id];
+	uint16_t period_ms = stream->period_ms;
+
+	if (stream_id == TELEMETRY_STREAM_ALTITUDE && FLIGHT_ApogeeArmed()) {
+		period_ms = 0; // Raised ahead of apogee
+	}
+	if (period_ms != 0 && now_ms - stream->last_ms < period_ms) {
+		return 0; // Above target rate
+	}
+	stream->last_ms = now_ms;
+
+	if (++stream->skipped < stream->decimation) {
+		stream->decimated++;
+		_telemetry_stats.decimated++;
+		return 0; // Backpressure
+	}
+	stream->skipped = 0;
+	stream->sent++;
+
+	return 1;
+}
+
+/**
+ * Adapt stream decimation to the TX ring occupancy.
+ */
+static void TELEMETRY_UpdateRate() {
+	uint32_t used_permille = (_telemetry_ring.head - _telemetry_ring.tail) * 1000 / TELEMETRY_RING_SIZE;
+	_telemetry_stats.used_permille = used_permille;
+
+	for (uint8_t i = 0; i < TELEMETRY_STREAM_COUNT; i++) {
+		TelemetryStream *stream = &_telemetry_streams[i];
+		if (stream->priority == TELEMETRY_PRIORITY_CRITICAL) {
+			continue;
+		}
+
+		uint16_t threshold = _telemetry_backpressure_permille[stream->priority];
+		if (used_permille > threshold && stream->decimation < TELEMETRY_MAX_DECIMATION) {
+			stream->decimation *= 2;
+		} else if (used_permille < threshold / 2 && stream->decimation > 1) {
+			stream->decimation /= 2;
+		}
+	}
+}
+
+/**
+ * CRC-16/CCITT-FALSE, bitwise (frames are short).
+ *
+ * @param crc: CRC of the previous bytes (0xFFFF to start).
+ * @param data: bytes.
+ * @param length: number of bytes.
+ *
+ * @return Updated CRC
+ */
+static uint16_t TELEMETRY_CRC16(uint16_t crc, const uint8_t *data, uint16_t length) {
+	for (uint16_t i = 0; i < length; i++) {
+		crc ^= (uint16_t)data[i] << 8;
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+/**
+ * Send the batch of a compressed stream as one frame. A dropped frame breaks
+ * the delta chain: the next sample is a keyframe.
+ *
+ * @param stream: pointer to a compressed stream.
+ *
+ * @retval 0 OK (or empty batch)
+ * @retval -2 ERROR ring full, batch dropped
+ */
+static int8_t TELEMETRY_Flush(TelemetryStream *stream) {
+	if (stream->batch_length == 0) {
+		return 0; // OK, nothing to send
+	}
+
+	uint8_t id = stream->id | TELEMETRY_ID_COMPRESSED | (stream->batch_keyframe ? TELEMETRY_ID_KEYFRAME : 0);
+	int8_t status = TELEMETRY_Send(id, stream->batch, stream->batch_length);
+	if (status != 0) {
+		CODEC_Reset(&stream->codec);
+	}
+	stream->encoded_bytes += stream->batch_length;
+	stream->batch_length = 0;
+
+	return status;
+}
+
+/**
+ * Send a sample of a stream: as is, or delta encoded and batched for
+ * compressed streams (sent by TELEMETRY_Flush()).
+ *
+ * @param stream_id: stream ID.
+ * @param body: message body.
+ * @param size: body size.
+ * @param values: scaled fields of the body (TELEMETRY_<type>ToValues()).
+ *
+ * @retval 0 OK
+ * @retval -2 ERROR ring full, sample dropped
+ */
+static int8_t TELEMETRY_SendSample(TelemetryStreamId stream_id, const void *body, uint8_t size, const int32_t *values) {
+	TelemetryStream *stream = &_telemetry_streams[stream_id];
+	uint8_t sample[CODEC_MAX_SAMPLE_SIZE];
+
+	stream->raw_bytes += size;
+	if (!stream->compressed) {
+		stream->encoded_bytes += size;
+		return TELEMETRY_Send(stream->id, body, size);
+	}
+
+	// A keyframe starts a frame, so a receiver can resynchronize on it
+	uint8_t keyframe = CODEC_KeyframeDue(&stream->codec);
+	if (keyframe) {
+		TELEMETRY_Flush(stream);
+	}
+	uint8_t length = CODEC_Encode(&stream->codec, values, sample);
+
+	if (stream->batch_length + length > TELEMETRY_MAX_BODY && TELEMETRY_Flush(stream) != 0) {
+		// Previous samples dropped, encode this one again as a keyframe
+		keyframe = 1;
+		length = CODEC_Encode(&stream->codec, values, sample);
+	}
+
+	if (stream->batch_length == 0) {
+		stream->batch_keyframe = keyframe;
+		stream->batch_ms = HAL_GetTick();
+	}
+	for (uint8_t i = 0; i < length; i++) {
+		stream->batch[stream->batch_length++] = sample[i];
+	}
+
+	return 0; // OK
+}
+
+// Every message body must fit in a frame
+#define TELEMETRY_CHECK_SIZE(name, id, type) \
+	_Static_assert(sizeof(Telemetry##type) <= TELEMETRY_MAX_BODY, #name " body too long");
+TELEMETRY_MESSAGES(TELEMETRY_CHECK_SIZE)
+
+// A batch always holds one keyframe (longest encoded sample), copied without bounds check
+#define TELEMETRY_CHECK_KEYFRAME(name, priority, period_ms, compressed) \
+	_Static_assert(!(compressed) || CODEC_SAMPLE_SIZE(TELEMETRY_FIELD_COUNT_##name) <= TELEMETRY_MAX_BODY, \
+			#name " keyframe longer than a frame body");
+TELEMETRY_STREAMS(TELEMETRY_CHECK_KEYFRAME)
+
+/**
+ * Pack a barometer sample in a message body (also used by GAUL/Recorder.h).
+ *
+ * @param barometer: pointer to a Barometer sample.
+ * @param body: output message body.
+ */
+void TELEMETRY_PackBarometer(const Barometer *barometer, TelemetryBaro *body) {
+	TELEMETRY_SET(BARO, *body, timestamp_ms, barometer->timestamp_ms);
+	TELEMETRY_SET(BARO, *body, altitude_m, barometer->altitude_m);
+	TELEMETRY_SET(BARO, *body, speed_mps, barometer->speed_mps);
+	TELEMETRY_SET(BARO, *body, acceleration_mps2, barometer->acceleration_mps2);
+	TELEMETRY_SET(BARO, *body, flags, (barometer->outlier ? 0x01 : 0) | (barometer->coasting ? 0x02 : 0));
+}
+
+/**
+ * Pack a GNSS epoch in a message body.
+ *
+ * @param gnss: pointer to a L76LM33 epoch.
+ * @param body: output message body.
+ */
+void TELEMETRY_PackGNSS(const L76LM33 *gnss, TelemetryGNSS *body) {
+	TELEMETRY_SET(GNSS, *body, timestamp_ms, gnss->timestamp_ms);
+	TELEMETRY_SET(GNSS, *body, latitude, gnss->latitude);
+	TELEMETRY_SET(GNSS, *body, longitude, gnss->longitude);
+	TELEMETRY_SET(GNSS, *body, altitude_m, gnss->altitude_m);
+	TELEMETRY_SET(GNSS, *body, hdop, gnss->hdop);
+	TELEMETRY_SET(GNSS, *body, fix_quality, gnss->fix_quality);
+	TELEMETRY_SET(GNSS, *body, satellites, gnss->satellites);
+}
+
+/**
+ * Pack a fused altitude in a message body.
+ *
+ * @param fusion: pointer to an AltitudeFusion state.
+ * @param body: output message body.
+ */
+void TELEMETRY_PackAltitude(const AltitudeFusion *fusion, TelemetryAltitude *body) {
+	TELEMETRY_SET(ALTITUDE, *body, timestamp_ms, fusion->timestamp_ms);
+	TELEMETRY_SET(ALTITUDE, *body, altitude_msl_m, fusion->altitude_msl_m);
+	TELEMETRY_SET(ALTITUDE, *body, altitude_agl_m, fusion->altitude_agl_m);
+}
+
+/**
+ * Pack a flight state change in a message body.
+ *
+ * @param event: pointer to a FlightEvent.
+ * @param body: output message body.
+ */
+void TELEMETRY_PackEvent(const FlightEvent *event, TelemetryEvent *body) {
+	TELEMETRY_SET(EVENT, *body, timestamp_ms, event->timestamp_ms);
+	TELEMETRY_SET(EVENT, *body, state, event->state);
+}
+
+/**
+ * Send one barometer sample.
+ */
+static int8_t TELEMETRY_SendBarometer(const Barometer *barometer) {
+	TelemetryBaro body;
+	TELEMETRY_PackBarometer(barometer, &body);
+
+	int32_t values[TELEMETRY_FIELD_COUNT_BARO];
+	TELEMETRY_BaroToValues(&body, values);
+
+	return TELEMETRY_SendSample(TELEMETRY_STREAM_BARO, &body, sizeof(body), values);
+}
+
+/**
+ * Send one GNSS epoch.
+ */
+static int8_t TELEMETRY_SendGNSS(const L76LM33 *gnss) {
+	TelemetryGNSS body;
+	TELEMETRY_PackGNSS(gnss, &body);
+
+	int32_t values[TELEMETRY_FIELD_COUNT_GNSS];
+	TELEMETRY_GNSSToValues(&body, values);
+
+	return TELEMETRY_SendSample(TELEMETRY_STREAM_GNSS, &body, sizeof(body), values);
+}
+
+/**
+ * Send one fused altitude.
+ */
+static int8_t TELEMETRY_SendAltitude(const AltitudeFusion *fusion) {
+	TelemetryAltitude body;
+	TELEMETRY_PackAltitude(fusion, &body);
+
+	int32_t values[TELEMETRY_FIELD_COUNT_ALTITUDE];
+	TELEMETRY_AltitudeToValues(&body, values);
+
+	return TELEMETRY_SendSample(TELEMETRY_STREAM_ALTITUDE, &body, sizeof(body), values);
+}
+
+/**
+ * Send one flight state change.
+ */
+static int8_t TELEMETRY_SendEvent(const FlightEvent *event) {
+	TelemetryEvent body;
+	TELEMETRY_PackEvent(event, &body);
+
+	int32_t values[TELEMETRY_FIELD_COUNT_EVENT];
+	TELEMETRY_EventToValues(&body, values);
+
+	return TELEMETRY_SendSample(TELEMETRY_STREAM_EVENT, &body, sizeof(body), values);
+}
+
+/**
+ * Send system health.
+ */
+static int8_t TELEMETRY_SendHealth() {
+	TelemetryHealth body;
+	const TimeSync *timesync = TIMESYNC_Get();
+	const FaultRecord *fault = FAULT_GetLast();
+	uint32_t dropped = _telemetry_stats.dropped;
+
+	TELEMETRY_SET(HEALTH, body, uptime_ms, HAL_GetTick());
+	TELEMETRY_SET(HEALTH, body, schema_version, TELEMETRY_SCHEMA_VERSION);
+	TELEMETRY_SET(HEALTH, body, idle_permille, CPULOAD_Get()->idle_permille);
+	TELEMETRY_SET(HEALTH, body, flight_state, FLIGHT_GetState());
+	TELEMETRY_SET(HEALTH, body, timesync_source, timesync->source);
+	TELEMETRY_SET(HEALTH, body, timesync_residual_us, timesync->residual_us);
+	TELEMETRY_SET(HEALTH, body, drift_ppm, timesync->drift_ppm);
+	TELEMETRY_SET(HEALTH, body, fault_reason, fault != NULL ? fault->reason : 0);
+	TELEMETRY_SET(HEALTH, body, fault_pc, fault != NULL ? fault->pc : 0);
+	TELEMETRY_SET(HEALTH, body, fault_resets, fault != NULL ? fault->resets : 0);
+	TELEMETRY_SET(HEALTH, body, dropped, dropped > 0xFFFF ? 0xFFFF : dropped);
+	TELEMETRY_SET(HEALTH, body, budget_permille, _telemetry_stats.budget_permille);
+
+	int32_t values[TELEMETRY_FIELD_COUNT_HEALTH];
+	TELEMETRY_HealthToValues(&body, values);
+
+	return TELEMETRY_SendSample(TELEMETRY_STREAM_HEALTH, &body, sizeof(body), values);
+}
+
+/**
+ * Initialize telemetry. The UART TX DMA channel must be configured (CubeMX).
+ *
+ * @param huart: pointer to a HAL UART handler.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no TX DMA channel
+ */
+int8_t TELEMETRY_Init(UART_HandleTypeDef *huart) {
+	TELEMETRY_huart = huart;
+
+	if (huart->hdmatx == NULL) {
+		return -1; // Error, no TX DMA channel linked to the UART
+	}
+
+	_telemetry_ring.head = _telemetry_ring.tail = 0;
+	_telemetry_priority_ring.head = _telemetry_priority_ring.tail = 0;
+	_telemetry_tx_ring = NULL;
+	_telemetry_tx_continue = NULL;
+	_telemetry_paused = 0;
+
+	_telemetry_stats = (TelemetryStats){0};
+
+#define TELEMETRY_STREAM_INIT(name, priority_, period, compressed_) \
+	_telemetry_streams[TELEMETRY_STREAM_##name] = (TelemetryStream){ \
+		.id = TELEMETRY_MSG_##name, .priority = priority_, .period_ms = period, .decimation = 1, \
+		.compressed = compressed_ }; \
+	CODEC_Init(&_telemetry_streams[TELEMETRY_STREAM_##name].codec, TELEMETRY_FIELD_COUNT_##name, CODEC_KEYFRAME_INTERVAL);
+	TELEMETRY_STREAMS(TELEMETRY_STREAM_INIT)
+
+	// Only send samples published from now on
+	_telemetry_baro_count = BUS_GetCount(BUS_TOPIC_BARO);
+	_telemetry_gnss_count = BUS_GetCount(BUS_TOPIC_GNSS);
+	_telemetry_altitude_count = BUS_GetCount(BUS_TOPIC_ALTITUDE);
+	_telemetry_event_count = BUS_GetCount(BUS_TOPIC_EVENT);
+
+	_telemetry_rate_ms = HAL_GetTick();
+	_telemetry_window_ms = HAL_GetTick();
+	_telemetry_window_frames = 0;
+	_telemetry_window_bytes = 0;
+
+	return 0; // OK
+}
+
+/**
+ * Send new samples from the bus and health at their target rate, highest
+ * priority first, adapt decimation to the TX ring occupancy, and update the
+ * frame rate and byte budget. Call this function at least at the barometer rate.
+ */
+void TELEMETRY_Update() {
+	uint32_t now_ms = HAL_GetTick();
+	FlightEvent event;
+	Barometer barometer;
+	AltitudeFusion fusion;
+	L76LM33 gnss;
+
+	if (_telemetry_paused) {
+		return; // Samples published meanwhile are not sent
+	}
+
+	if (now_ms - _telemetry_rate_ms >= TELEMETRY_RATE_PERIOD_MS) {
+		_telemetry_rate_ms = now_ms;
+		TELEMETRY_UpdateRate();
+	}
+
+	// Every state change is sent, oldest first (kept in the bus history)
+	uint32_t events = BUS_GetCount(BUS_TOPIC_EVENT);
+	while (_telemetry_event_count != events) {
+		uint32_t age = events - _telemetry_event_count - 1;
+		_telemetry_event_count++;
+		if (age < BUS_EVENT_HISTORY && BUS_ReadHistory(BUS_TOPIC_EVENT, age, &event) == 0
+				&& TELEMETRY_Due(TELEMETRY_STREAM_EVENT, now_ms)) {
+			TELEMETRY_SendEvent(&event);
+		}
+	}
+	if (TELEMETRY_Due(TELEMETRY_STREAM_HEALTH, now_ms)) {
+		TELEMETRY_SendHealth();
+	}
+	if (BUS_Read(BUS_TOPIC_GNSS, &gnss, &_telemetry_gnss_count) == 0 && TELEMETRY_Due(TELEMETRY_STREAM_GNSS, now_ms)) {
+		TELEMETRY_SendGNSS(&gnss);
+	}
+	if (BUS_Read(BUS_TOPIC_ALTITUDE, &fusion, &_telemetry_altitude_count) == 0
+			&& TELEMETRY_Due(TELEMETRY_STREAM_ALTITUDE, now_ms)) {
+		TELEMETRY_SendAltitude(&fusion);
+	}
+	if (BUS_Read(BUS_TOPIC_BARO, &barometer, &_telemetry_baro_count) == 0 && TELEMETRY_Due(TELEMETRY_STREAM_BARO, now_ms)) {
+		TELEMETRY_SendBarometer(&barometer);
+	}
+
+	// Batches of compressed streams wait at most TELEMETRY_BATCH_MS
+	for (uint8_t i = 0; i < TELEMETRY_STREAM_COUNT; i++) {
+		TelemetryStream *stream = &_telemetry_streams[i];
+		if (stream->batch_length != 0 && now_ms - stream->batch_ms >= TELEMETRY_BATCH_MS) {
+			TELEMETRY_Flush(stream);
+		}
+	}
+
+	// Frame rate and byte budget over the last window
+	uint32_t window_ms = now_ms - _telemetry_window_ms;
+	if (window_ms >= TELEMETRY_WINDOW_MS) {
+		uint32_t capacity = TELEMETRY_huart->Init.BaudRate / 10; // 8N1: 10 bits per byte
+		_telemetry_stats.frame_rate = _telemetry_window_frames * 1000 / window_ms;
+		_telemetry_stats.byte_rate = _telemetry_window_bytes * 1000 / window_ms;
+		_telemetry_stats.budget_permille = (uint64_t)_telemetry_stats.byte_rate * 1000 / capacity;
+
+		_telemetry_window_ms = now_ms;
+		_telemetry_window_frames = 0;
+		_telemetry_window_bytes = 0;
+	}
+}
+
+/**
+ * Frame and queue a message, critical streams in the priority ring. Call from
+ * the main loop (tasks) only.
+ *
+ * @param id: message ID (TELEMETRY_MSG_*, with TELEMETRY_ID_* flags).
+ * @param body: message body.
+ * @param length: body length, at most TELEMETRY_MAX_BODY.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR body too long or unknown message
+ * @retval -2 ERROR ring full, frame dropped
+ */
+int8_t TELEMETRY_Send(uint8_t id, const uint8_t *body, uint8_t length) {
+	uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+	uint8_t frame[TELEMETRY_MAX_FRAME];
+	TelemetryStream *stream = NULL;
+
+	for (uint8_t i = 0; i < TELEMETRY_STREAM_COUNT; i++) {
+		if (_telemetry_streams[i].id == (id & TELEMETRY_ID_MASK)) {
+			stream = &_telemetry_streams[i];
+		}
+	}
+	if (stream == NULL || length > TELEMETRY_MAX_BODY) {
+		return -1; // Error, unknown message or body too long
+	}
+	TelemetryRing *ring = stream->priority == TELEMETRY_PRIORITY_CRITICAL ? &_telemetry_priority_ring : &_telemetry_ring;
+
+	payload[0] = id;
+	payload[1] = stream->sequence++; // Receiver counts lost frames of each stream
+	for (uint8_t i = 0; i < length; i++) {
+		payload[2 + i] = body[i];
+	}
+	uint16_t crc = TELEMETRY_CRC16(0xFFFF, payload, 2 + length);
+	payload[2 + length] = crc;
+	payload[3 + length] = crc >> 8;
+
+	uint16_t frame_length = COBS_Encode(payload, 4 + length, frame);
+	if (TELEMETRY_Queue(ring, frame, frame_length) != 0) {
+		_telemetry_stats.dropped++;
+		return -2; // Error, ring full
+	}
+
+	_telemetry_stats.frames++;
+	_telemetry_window_frames++;
+
+	return 0; // OK
+}
+
+/**
+ * Queue raw text (recovery beacon) in the priority ring, between frames. A frame
+ * delimiter is added after the text, so a frame receiver drops it without losing
+ * the next frame. Call from the main loop (tasks) only.
+ *
+ * @param text: text without 0x00.
+ * @param length: text length, at most TELEMETRY_MAX_TEXT.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR text too long
+ * @retval -2 ERROR priority ring full
+ */
+int8_t TELEMETRY_Write(const char *text, uint16_t length) {
+	uint8_t buffer[TELEMETRY_MAX_TEXT + 1];
+
+	if (length > TELEMETRY_MAX_TEXT) {
+		return -1; // Error, text too long
+	}
+
+	for (uint16_t i = 0; i < length; i++) {
+		buffer[i] = text[i];
+	}
+	buffer[length] = 0x00; // Delimiter
+
+	if (TELEMETRY_Queue(&_telemetry_priority_ring, buffer, length + 1) != 0) {
+		return -2; // Error, priority ring full
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Pause or resume sending, while the UART is used for something else (log
+ * download). The current DMA transfer still completes, see TELEMETRY_IsIdle().
+ * Frames queued meanwhile wait in the rings and are sent on resume, new
+ * samples are not sent. Call from the main loop (tasks) only.
+ *
+ * @param paused: 1 to pause, 0 to resume.
+ */
+void TELEMETRY_Pause(uint8_t paused) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	_telemetry_paused = paused;
+	TELEMETRY_StartTx();
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Check if no DMA transfer is in progress (UART free once paused).
+ *
+ * @retval 1 idle
+ * @retval 0 transfer in progress
+ */
+uint8_t TELEMETRY_IsIdle() {
+	return _telemetry_tx_ring == NULL;
+}
+
+/**
+ * Callback called when a DMA transfer is complete. It is called when
+ * HAL_UART_TxCpltCallback is called.
+ *
+ * @param huart: pointer to a HAL UART handler triggering the callback
+ */
+void TELEMETRY_TxCpltCallback(UART_HandleTypeDef *huart) {
+	if (TELEMETRY_huart != NULL && huart->Instance == TELEMETRY_huart->Instance && _telemetry_tx_ring != NULL) {
+		_telemetry_tx_ring->tail += _telemetry_tx_length;
+		_telemetry_stats.bytes_sent += _telemetry_tx_length;
+		_telemetry_tx_ring = NULL;
+
+		TELEMETRY_StartTx();
+	}
+}
+
+/**
+ * Callback called on UART errors. It is called when HAL_UART_ErrorCallback is
+ * called. A failed transfer is skipped, the receiver resynchronizes on the
+ * next frame delimiter.
+ *
+ * @param huart: pointer to a HAL UART handler triggering the callback
+ */
+void TELEMETRY_ErrorCallback(UART_HandleTypeDef *huart) {
+	if (TELEMETRY_huart != NULL && huart->Instance == TELEMETRY_huart->Instance && _telemetry_tx_ring != NULL
+			&& huart->gState == HAL_UART_STATE_READY) {
+		_telemetry_tx_ring->tail += _telemetry_tx_length;
+		_telemetry_tx_ring = NULL;
+		_telemetry_stats.tx_errors++;
+
+		TELEMETRY_StartTx();
+	}
+}
+
+/**
+ * Get telemetry statistics (for debug or telemetry).
+ *
+ * @return Pointer to statistics
+ */
+const TelemetryStats *TELEMETRY_GetStats() {
+	return &_telemetry_stats;
+}
+
+/**
+ * Get a stream rate control state (for debug or telemetry).
+ *
+ * @param stream: stream ID.
+ *
+ * @return Pointer to the stream
+ */
+const TelemetryStream *TELEMETRY_GetStream(TelemetryStreamId stream) {
+	return &_telemetry_streams[stream];
+}
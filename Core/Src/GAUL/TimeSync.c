@@ -0,0 +1,185 @@
+/*
+ * TimeSync.c
+ *
+ * Link the local microsecond clock (GAUL/Clock.h) to UTC from the GNSS module,
+ * so logs and telemetry can be placed on absolute time.
+ *
+ * Each valid RMC epoch gives a measurement: its UTC time and the local time
+ * when the sentence started arriving (stamped by the UART interrupt). If the
+ * 1PPS output of the module is wired to an EXTI line, the PPS edge of the same
+ * second is used instead, the sentence start jitters with the module load.
+ * PPS measurements also give the delay from the epoch to its sentence start,
+ * subtracted from later NMEA measurements (PPS lost). Without any PPS edge,
+ * this delay is not compensated and UTC estimates lag by it.
+ *
+ * UTC = local + offset + drift * (local - reference)
+ *
+ * The offset and drift are corrected on each measurement, like the barometer
+ * drift in AltitudeFusion. Between measurements, the drift keeps the estimate
+ * consistent over a long flight or descent.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL/TimeSync.h"
+#include "GAUL/SampleBus.h"
+
+#include "GAUL_Drivers/L76LM33.h"
+
+TimeSync _timesync;
+
+// GNSS epochs read from the bus
+uint32_t _timesync_gnss_count = 0;
+
+/**
+ * Estimated UTC - local time offset at a local time.
+ *
+ * @param local_us: local time (microsecond clock).
+ *
+ * @return Offset in us
+ */
+static int64_t TIMESYNC_Offset_us(uint64_t local_us) {
+	int64_t elapsed_us = (int64_t)(local_us - _timesync.reference_us);
+	return _timesync.offset_us + (int64_t)(_timesync.drift_ppm * (elapsed_us / 1000000.0f));
+}
+
+/**
+ * Correct offset and drift with a new UTC measurement.
+ *
+ * @param utc_us: UTC time (us since 1970-01-01).
+ * @param local_us: local time of the same instant.
+ * @param source: TIMESYNC_SOURCE_NMEA or TIMESYNC_SOURCE_PPS.
+ *
+ * @retval 0 OK
+ * @retval -1 Measurement rejected
+ */
+static int8_t TIMESYNC_Measure(uint64_t utc_us, uint64_t local_us, uint8_t source) {
+	int64_t measured_us = (int64_t)(utc_us - local_us);
+
+	if (_timesync.source == TIMESYNC_SOURCE_NONE || _timesync.rejects >= TIMESYNC_MAX_REJECTS) {
+		// First measurement or estimate lost, restart
+		_timesync.offset_us = measured_us;
+		_timesync.reference_us = local_us;
+		_timesync.drift_ppm = 0;
+		_timesync.residual_us = 0;
+		_timesync.rejects = 0;
+		_timesync.source = source;
+		_timesync.utc_us = utc_us;
+		_timesync.updates++;
+		return 0; // OK
+	}
+
+	float dt_s = (local_us - _timesync.reference_us) / 1000000.0f;
+	int64_t residual_us = measured_us - TIMESYNC_Offset_us(local_us);
+	if (dt_s <= 0 || residual_us > TIMESYNC_MAX_RESIDUAL_US || residual_us < -TIMESYNC_MAX_RESIDUAL_US) {
+		_timesync.rejects++;
+		return -1; // Outlier or old measurement
+	}
+
+	// Move reference to this measurement, then correct offset and drift
+	_timesync.offset_us = TIMESYNC_Offset_us(local_us) + (int64_t)(TIMESYNC_OFFSET_GAIN * residual_us);
+	_timesync.reference_us = local_us;
+	_timesync.drift_ppm += TIMESYNC_DRIFT_GAIN * residual_us / dt_s;
+	if (_timesync.drift_ppm > TIMESYNC_MAX_DRIFT_PPM) {
+		_timesync.drift_ppm = TIMESYNC_MAX_DRIFT_PPM;
+	} else if (_timesync.drift_ppm < -TIMESYNC_MAX_DRIFT_PPM) {
+		_timesync.drift_ppm = -TIMESYNC_MAX_DRIFT_PPM;
+	}
+
+	_timesync.residual_us = (int32_t)residual_us;
+	_timesync.rejects = 0;
+	_timesync.source = source;
+	_timesync.utc_us = utc_us;
+	_timesync.updates++;
+
+	return 0; // OK
+}
+
+/**
+ * Initialize time synchronization (not synchronized).
+ */
+void TIMESYNC_Init() {
+	_timesync.offset_us = 0;
+	_timesync.reference_us = 0;
+	_timesync.drift_ppm = 0;
+	_timesync.residual_us = 0;
+	_timesync.updates = 0;
+	_timesync.rejects = 0;
+	_timesync.source = TIMESYNC_SOURCE_NONE;
+	_timesync.utc_us = 0;
+	_timesync.pps_us = 0;
+	_timesync.nmea_latency_us = 0;
+	_timesync_gnss_count = 0;
+}
+
+/**
+ * Update time synchronization with the latest GNSS epoch from the bus.
+ * Call this function after each GNSS publication.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR no new UTC measurement, or measurement rejected
+ */
+int8_t TIMESYNC_Update() {
+	L76LM33 gnss;
+
+	if (BUS_Read(BUS_TOPIC_GNSS, &gnss, &_timesync_gnss_count) != 0) {
+		return -1; // No new GNSS epoch
+	}
+	if (gnss.utc_us == 0 || gnss.utc_us == _timesync.utc_us) {
+		return -1; // No UTC time or already used
+	}
+
+	// Last PPS edge, 64-bit value written by the EXTI interrupt
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint64_t pps_us = _timesync.pps_us;
+	__set_PRIMASK(primask);
+
+	// PPS edge at the start of the same UTC second, sentence follows it
+	if (pps_us != 0 && gnss.utc_timestamp_us > pps_us && gnss.utc_timestamp_us - pps_us < TIMESYNC_PPS_MAX_AGE_US) {
+		int32_t latency_us = (int32_t)(gnss.utc_timestamp_us - pps_us);
+		if (_timesync.nmea_latency_us == 0) {
+			_timesync.nmea_latency_us = latency_us;
+		} else {
+			_timesync.nmea_latency_us += (int32_t)(TIMESYNC_LATENCY_GAIN * (latency_us - _timesync.nmea_latency_us));
+		}
+		return TIMESYNC_Measure(gnss.utc_us, pps_us, TIMESYNC_SOURCE_PPS);
+	}
+
+	return TIMESYNC_Measure(gnss.utc_us, gnss.utc_timestamp_us - _timesync.nmea_latency_us, TIMESYNC_SOURCE_NMEA);
+}
+
+/**
+ * Record a 1PPS edge. Call this function from the EXTI callback of the
+ * 1PPS line, if wired.
+ *
+ * @param local_us: microsecond clock at the edge.
+ */
+void TIMESYNC_PPSCallback(uint64_t local_us) {
+	_timesync.pps_us = local_us;
+}
+
+/**
+ * Convert a local time to UTC.
+ *
+ * @param local_us: local time (microsecond clock).
+ *
+ * @return UTC time in us since 1970-01-01, 0 if not synchronized
+ */
+uint64_t TIMESYNC_ToUTC_us(uint64_t local_us) {
+	if (_timesync.source == TIMESYNC_SOURCE_NONE) {
+		return 0; // Not synchronized
+	}
+
+	return local_us + TIMESYNC_Offset_us(local_us);
+}
+
+/**
+ * Get time synchronization state (for logs and telemetry).
+ *
+ * @return Pointer to the TimeSync state
+ */
+const TimeSync *TIMESYNC_Get() {
+	return &_timesync;
+}
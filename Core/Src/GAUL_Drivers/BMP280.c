@@ -14,31 +14,34 @@
 
 #include "GAUL_Drivers/BMP280.h"
 
-#include "math.h" // for pow()
+#include "GAUL/Profile.h"
+#include "GAUL/SPIBus.h"
 
-// Pointer to SPI handler
-SPI_HandleTypeDef *BMP_hspi;
+#include "math.h" // for pow()
 
-// Multi purpose receiving buffer
-uint8_t BMP_RX_Buffer[26];
+// Receiving buffers are local to each function (no shared state between callers).
+// BMP280 functions must only be called from the main loop (see interrupt priorities in main.h),
+// SPI2 transfers go through the bus manager (GAUL/SPIBus.h), shared with the NOR flash.
 
 /**
  * Initialize BMP280 sensor.
- * - Set BMP280 SPI handler
+ * - Set BMP280 chip select on the SPI2 bus manager (SPIBUS_Init() called first)
  * - Reset
  * - Validate SPI2 communication with device ID
  * - Read calibration data
  * - Set BMP280 configuration
+ * The ground reference is measured apart, see BMP280_MeasureReference().
  *
  * @param BMP_data: pointer to a BMP280 structure.
- * @param hspi: pointer to a HAL SPI handler.
  *
  * @retval 0 OK
  * @retval -1 ERROR
  */
-int8_t BMP280_Init(BMP280 *BMP_data, SPI_HandleTypeDef *hspi) {
-	// Set BMP280 SPI handler
-	BMP_hspi = hspi;
+int8_t BMP280_Init(BMP280 *BMP_data) {
+	// Set BMP280 chip select
+	SPIBUS_SetChipSelect(SPIBUS_DEVICE_BMP280, BMP_CS_GPIO_Port, BMP_CS_Pin);
+
+	uint8_t BMP_RX_Buffer[1];
 
     // Reset
     if (BMP280_SoftReset() != 0) {
@@ -63,51 +66,41 @@ int8_t BMP280_Init(BMP280 *BMP_data, SPI_HandleTypeDef *hspi) {
     	return -1; // SPI Error
     }
 
-    // Delay to get first measurement
-    HAL_Delay(200);
-
-    // Set reference
-    if (BMP280_MeasureReference(BMP_data, 40, 50) != 0 || BMP_data->press_ref_Pa < 90000.0 || BMP_data->press_ref_Pa > 110000.0) {
-    	BMP_data->press_ref_Pa = 101325.0; // Default value if error or extreme values
-    }
-
     return 0; // OK
 }
 
 /**
- * Choose BMP280 custom configuration.
+ * Choose BMP280 custom configuration, without reset (the sensor keeps its
+ * calibration and output registers). Measurements are stopped first: config
+ * writes may be ignored in normal mode (5.4.6 config - BMP280 Datasheet).
  *
- * @param mode: BMP280_MODE_LOW_POWER or BMP280_MODE_NORMAL_POWER
+ * @param mode: BMP280_MODE_LOW_POWER, BMP280_MODE_NORMAL_POWER or BMP280_MODE_SLEEP
  *
  * @retval 0 OK
  * @retval -1 SPI ERROR
  */
 int8_t BMP280_SetMode(uint8_t mode) {
-	if (BMP280_SoftReset() != 0) {
+	// Stop measurements
+	if (BMP280_Write(BMP280_REG_CTRL_MEAS, BMP280_SETTING_CTRL_MEAS_SLEEP) != 0) {
 		return -1; // SPI ERROR
 	}
+	if (mode == BMP280_MODE_SLEEP) {
+		return 0; // OK
+	}
 
-    if (mode == BMP280_MODE_LOW_POWER) {
-        // Set data acquisition options (temp/press oversampling and power mode)
-    	if (BMP280_Write(BMP280_REG_CTRL_MEAS, BMP280_SETTING_CTRL_MEAS_LOW) != 0) {
-    		return -1; // SPI ERROR
-    	}
-        // Set configuration (rate, filter and interface options)
-        if (BMP280_Write(BMP280_REG_CONFIG, BMP280_SETTING_CONFIG_LOW) != 0) {
-        	return -1; // SPI ERROR
-        }
-    } else {
-        // Set data acquisition options (temp/press oversampling and power mode)
-    	if (BMP280_Write(BMP280_REG_CTRL_MEAS, BMP280_SETTING_CTRL_MEAS_NORMAL) != 0) {
-    		return -1; // SPI ERROR
-    	}
-        // Set configuration (rate, filter and interface options)
-    	if (BMP280_Write(BMP280_REG_CONFIG, BMP280_SETTING_CONFIG_NORMAL) != 0) {
-    		return -1; // SPI ERROR
-    	}
-    }
+	uint8_t config = mode == BMP280_MODE_LOW_POWER ? BMP280_SETTING_CONFIG_LOW : BMP280_SETTING_CONFIG_NORMAL;
+	uint8_t ctrl_meas = mode == BMP280_MODE_LOW_POWER ? BMP280_SETTING_CTRL_MEAS_LOW : BMP280_SETTING_CTRL_MEAS_NORMAL;
+
+	// Set configuration (rate, filter and interface options) while in sleep mode
+	if (BMP280_Write(BMP280_REG_CONFIG, config) != 0) {
+		return -1; // SPI ERROR
+	}
+	// Set data acquisition options (temp/press oversampling and power mode)
+	if (BMP280_Write(BMP280_REG_CTRL_MEAS, ctrl_meas) != 0) {
+		return -1; // SPI ERROR
+	}
 
-    return 0; //OK
+	return 0; //OK
 }
 
 /**
@@ -119,6 +112,7 @@ int8_t BMP280_SetMode(uint8_t mode) {
  * @retval -1 SPI ERROR
  */
 int8_t BMP280_ReadCalibrationData(BMP280 *BMP_data) {
+    uint8_t BMP_RX_Buffer[26];
     if (BMP280_Read(BMP280_REG_CALIB_00, BMP_RX_Buffer, 26) != 0) {
     	return -1; // SPI ERROR
     }
@@ -178,6 +172,7 @@ int8_t BMP280_MeasureReference(BMP280 *BMP_data, uint16_t samples, uint8_t delay
  * @retval -1 ERROR
  */
 int8_t BMP280_ReadTemperature(BMP280 *BMP_data) {
+    uint8_t BMP_RX_Buffer[3];
     // Read BMP280 adc value
     if (BMP280_Read(BMP280_REG_TEMP_MSB, BMP_RX_Buffer, 3) != 0) {
     	return -1; // SPI Error
@@ -208,6 +203,7 @@ int8_t BMP280_ReadTemperature(BMP280 *BMP_data) {
  * @retval -1 ERROR
  */
 int8_t BMP280_ReadPressure(BMP280 *BMP_data) {
+    uint8_t BMP_RX_Buffer[3];
     // Read BMP280 adc value
 	if (BMP280_Read(BMP280_REG_PRESS_MSB, BMP_RX_Buffer, 3) != 0) {
 		return -1; // SPI Error
@@ -256,11 +252,15 @@ int8_t BMP280_ReadAltitude(BMP280 *BMP_data) {
 	if (BMP280_ReadTemperature(BMP_data) != 0) {
 		return -1; // Error
 	}
+	PROFILE_BEGIN(BMP280_READ_PRESSURE);
 	if (BMP280_ReadPressure(BMP_data) != 0) {
 		return -1; // Error
 	}
+	PROFILE_END(BMP280_READ_PRESSURE);
 
+	PROFILE_BEGIN(BMP280_PRESSURE_TO_ALTITUDE);
 	BMP_data->alt_m = BMP280_PressureToAltitude(BMP_data->press_Pa, BMP_data->press_ref_Pa);
+	PROFILE_END(BMP280_PRESSURE_TO_ALTITUDE);
 
 	return 0; // OK
 }
@@ -296,7 +296,7 @@ int8_t BMP280_SoftReset() {
 }
 
 /**
- * Read BMP280 register using GPIO and SPI2 HAL functions
+ * Read BMP280 registers (SPI2 bus manager, chip select raised on error)
  *
  * @param reg: u8bit register address to read.
  * @param RX_Buffer: u8bit array to store X bytes of data.
@@ -306,28 +306,17 @@ int8_t BMP280_SoftReset() {
  * @retval -1 SPI ERROR
  */
 int8_t BMP280_Read(uint8_t reg, uint8_t RX_Buffer[], uint8_t size) {
-    // BMP_CS LOW
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_RESET);
-
-    // Transmit Control byte (Read mode + Register address)
+    // Control byte (Read mode + Register address), then Data bytes
     reg |= 0x80; // Read mode
-    if (HAL_SPI_Transmit(BMP_hspi, &reg, 1, BMP280_SPI_TIMEOUT) != HAL_OK) {
-    	return -1; // SPI ERROR
-    }
-
-    // Receive Data byte
-    if (HAL_SPI_Receive(BMP_hspi, RX_Buffer, size, BMP280_SPI_TIMEOUT) != HAL_OK) {
+    if (SPIBUS_Transfer(SPIBUS_DEVICE_BMP280, &reg, 1, RX_Buffer, size) != 0) {
     	return -1; // SPI ERROR
     }
 
-    // BMP_CS HIGH
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_SET);
-
     return 0; // OK
 }
 
 /**
- * Write to a BMP280 register using GPIO and SPI2 HAL functions
+ * Write to a BMP280 register (SPI2 bus manager, chip select raised on error)
  *
  * @param reg: u8bit register address to write.
  * @param data: u8bit data to write.
@@ -336,20 +325,14 @@ int8_t BMP280_Read(uint8_t reg, uint8_t RX_Buffer[], uint8_t size) {
  * @retval -1 SPI ERROR
  */
 int8_t BMP280_Write(uint8_t reg, uint8_t data) {
-    // BMP_CS LOW
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_RESET);
-
     // Control byte (Write mode + Register address)
     reg &= ~0x80; // Write mode
 
     // Transmit Control byte and Data byte
     uint8_t TX_Buffer[2] = { reg, data };
-    if (HAL_SPI_Transmit(BMP_hspi, TX_Buffer, 2, BMP280_SPI_TIMEOUT) != HAL_OK) {
+    if (SPIBUS_Transfer(SPIBUS_DEVICE_BMP280, TX_Buffer, 2, NULL, 0) != 0) {
     	return -1; // SPI ERROR
     }
 
-    // BMP_CS HIGH
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_SET);
-
     return 0; // OK
 }
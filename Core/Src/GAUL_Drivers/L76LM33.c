@@ -12,9 +12,14 @@
 
 #include "GAUL_Drivers/L76LM33.h"
 
+#include "GAUL/Clock.h"
+#include "GAUL/DeferredWork.h"
+#include "GAUL/Profile.h"
+
 #include "circular_buffer.h"
+#include "minmea.h"
 
-#include "stdio.h" // Only for debug
+#include "GAUL/Log.h" // Only for debug
 
 // Pointer to UART handler
 UART_HandleTypeDef *L76_huart;
@@ -25,19 +30,47 @@ uint8_t L76_receivedByte;
 // Circular buffer to store UART data from GNSS module
 circularBuffer_t *L76_circularBuffer = NULL;
 
-// Buffer to store NMEA sentence
-uint8_t L76_NMEA_Buffer[128];
+// NMEA sentences read from the circular buffer (deferred work), waiting to be parsed (main loop)
+uint8_t L76_NMEA_Buffer[L76LM33_SENTENCE_QUEUE_SIZE][L76LM33_SENTENCE_SIZE];
+volatile uint8_t L76_NMEA_Head = 0; // Next sentence to parse
+volatile uint8_t L76_NMEA_Tail = 0; // Next sentence to read
+uint64_t L76_NMEA_Timestamp_us[L76LM33_SENTENCE_QUEUE_SIZE]; // Start of each queued sentence
+
+// Number of line endings received (UART interrupt) and sentences read (deferred work)
+volatile uint32_t L76_LinesReceived = 0;
+uint32_t L76_LinesRead = 0;
+
+// Bytes lost, circular buffer full
+volatile uint32_t L76_BytesDropped = 0;
+
+// UART errors stopping the reception (overrun), reception started again
+volatile uint32_t L76_RxErrors = 0;
+
+// Microsecond clock when the first byte ('$') of each line was received
+uint64_t L76_LineStart_us[L76LM33_SENTENCE_QUEUE_SIZE];
+
+static void L76LM33_SentenceWork(uint32_t argument);
 
 
 /*
  * Source:
  * LG76 Series GNSS Protocol Specification - Section 2.3. PMTK Messages
  *
- * Only output RMC (Recommended Minimum Specific GNSS Sentence) once every one position fix
- * NMEA_RMC[] = "$PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*35<CR><LF>"
+ * Only output RMC (Recommended Minimum Specific GNSS Sentence) and GGA (Global Positioning System Fix Data)
+ * once every one position fix
+ * NMEA_RMC_GGA[] = "$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*34<CR><LF>"
  *
  * Set the navigation mode to "Aviation Mode" (for large acceleration movement, altitude of 10'000m max)
  * NMEA_NAVMODE = "PMTK886,2*2A<CR><LF>"
+ *
+ * Section 2.3.10. Periodic power saving mode
+ * Periodic standby: run 3s, sleep 12s, then run 18s, sleep 72s once the fix is stable
+ * NMEA_PERIODIC[] = "$PMTK225,1,3000,12000,18000,72000*16<CR><LF>"
+ * Back to full power (normal mode)
+ * NMEA_FULL_POWER[] = "$PMTK225,0*2B<CR><LF>"
+ *
+ * Section 2.3.5. Standby mode, any byte sent on UART wakes up the module
+ * NMEA_STANDBY[] = "$PMTK161,0*28<CR><LF>"
  */
 
 /**
@@ -61,9 +94,9 @@ int8_t L76LM33_Init(UART_HandleTypeDef *huart) {
 		return -1; // Error with UART
 	}
 
-	// Only output GPRMC sentence
-    char NMEA_RMC[] = "$PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*35\r\n";
-    if (L76LM33_SendCommand(NMEA_RMC, sizeof(NMEA_RMC)) != 0) {
+	// Only output RMC and GGA sentences
+    char NMEA_RMC_GGA[] = "$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*34\r\n";
+    if (L76LM33_SendCommand(NMEA_RMC_GGA, sizeof(NMEA_RMC_GGA)) != 0) {
     	return -1; // Error with UART
     }
     // Set navigation mode
@@ -77,22 +110,68 @@ int8_t L76LM33_Init(UART_HandleTypeDef *huart) {
 
 /**
  * Callback called on incoming UART data. It is called when HAL_UART_RxCpltCallback is called.
- * Add received byte to UART circular buffer.
+ * Add received byte to UART circular buffer. The start of each sentence is
+ * stamped with the microsecond clock. At the end of a sentence, reading the
+ * sentence out of the circular buffer is deferred to PendSV.
  *
  * @param huart: pointer to a HAL UART handler triggering the callback
  */
 void L76LM33_RxCallback(UART_HandleTypeDef *huart) {
 	if (huart->Instance == L76_huart->Instance) {
-		// Add data to circular buffer
-		circular_buffer_push(L76_circularBuffer, &L76_receivedByte);
-		// Receive UART data with interrupts
+		// Add data to circular buffer, a line is only counted if its '\n' is in the buffer
+		if (!circular_buffer_push(L76_circularBuffer, &L76_receivedByte)) {
+			L76_BytesDropped++; // Circular buffer full
+		} else if (L76_receivedByte == '$') {
+			L76_LineStart_us[L76_LinesReceived % L76LM33_SENTENCE_QUEUE_SIZE] = CLOCK_GetTime_us();
+		} else if (L76_receivedByte == '\n') {
+			L76_LinesReceived++;
+			DEFERRED_Post(L76LM33_SentenceWork, 0);
+		}
+
+		// Receive UART data with interrupts (overwrites L76_receivedByte)
+		HAL_UART_Receive_IT(L76_huart, &L76_receivedByte, 1);
+	}
+}
+
+/**
+ * Callback called on UART errors. It is called when HAL_UART_ErrorCallback is
+ * called. An overrun (e.g. flash erase stalling the core) stops the reception,
+ * start it again. The sentence missing the byte fails its checksum.
+ *
+ * @param huart: pointer to a HAL UART handler triggering the callback
+ */
+void L76LM33_ErrorCallback(UART_HandleTypeDef *huart) {
+	if (huart->Instance == L76_huart->Instance && huart->RxState == HAL_UART_STATE_READY) {
+		L76_RxErrors++;
 		HAL_UART_Receive_IT(L76_huart, &L76_receivedByte, 1);
 	}
 }
 
 /**
- * Read and parse a NMEA GPRMC sentence into data structure. Call this function
- * frequently to have the latest GPS data available.
+ * Deferred work posted at the end of each sentence. Read every complete
+ * sentence from the circular buffer into the sentence queue.
+ *
+ * @param argument: unused
+ */
+static void L76LM33_SentenceWork(uint32_t argument) {
+	while (L76_LinesRead != L76_LinesReceived) {
+		// Stamp of the sentence, kept if the sentence is queued
+		L76_NMEA_Timestamp_us[L76_NMEA_Tail % L76LM33_SENTENCE_QUEUE_SIZE] = L76_LineStart_us[L76_LinesRead % L76LM33_SENTENCE_QUEUE_SIZE];
+		L76_LinesRead++;
+
+		PROFILE_BEGIN(L76LM33_READ_SENTENCE);
+		L76LM33_ReadSentence();
+		PROFILE_END(L76LM33_READ_SENTENCE);
+	}
+}
+
+/**
+ * Parse the oldest NMEA sentence (RMC or GGA) of the sentence queue into data structure.
+ * Call this function frequently to have the latest GPS data available.
+ *
+ * RMC updates the position and the UTC time, GGA updates the position, the altitude above mean
+ * sea level and the fix quality. The vertical speed is derived from two
+ * consecutive GGA altitudes.
  *
  * @param L76_data: pointer to a L76LM33 structure to update.
  *
@@ -100,53 +179,125 @@ void L76LM33_RxCallback(UART_HandleTypeDef *huart) {
  * @retval -1 ERROR
  *
  */
-//int8_t L76LM33_Read(GPS_Data *gps_data) {
 int8_t L76LM33_Read(L76LM33 *L76_Data) {
-	// Read sentence
-	if (L76LM33_ReadSentence() != 0) {
-		return -1; // Error, don't update
+	if (L76_NMEA_Head == L76_NMEA_Tail) {
+		return -1; // Error, no sentence to parse
+	}
+
+	// Parse sentence in place, the slot is released afterwards
+	uint8_t slot = L76_NMEA_Head % L76LM33_SENTENCE_QUEUE_SIZE;
+	PROFILE_BEGIN(L76LM33_PARSE_SENTENCE);
+	int8_t status = L76LM33_ParseSentence(L76_Data, (char *)L76_NMEA_Buffer[slot], L76_NMEA_Timestamp_us[slot]);
+	PROFILE_END(L76LM33_PARSE_SENTENCE);
+	L76_NMEA_Head++;
+
+	return status;
+}
+
+/**
+ * Convert a NMEA date and time (UTC) to Unix time. Days are counted from the
+ * civil date directly, newlib doesn't provide timegm().
+ *
+ * @param date: NMEA date (2 digits year, 2000-2099).
+ * @param time: NMEA time.
+ *
+ * @return UTC time in us since 1970-01-01, 0 if the date or time is empty
+ */
+static uint64_t L76LM33_ToUnixTime_us(const struct minmea_date *date, const struct minmea_time *time) {
+	if (date->year < 0 || date->month < 1 || date->day < 1 || time->hours < 0) {
+		return 0; // Empty date or time
 	}
 
+	// Days since 1970-01-01, years starting in March (leap day at the end)
+	int32_t year = 2000 + date->year - (date->month <= 2);
+	int32_t era = year / 400;
+	int32_t year_of_era = year - era * 400;
+	int32_t day_of_year = (153 * (date->month + (date->month > 2 ? -3 : 9)) + 2) / 5 + date->day - 1;
+	int32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	int32_t days = era * 146097 + day_of_era - 719468;
+
+	uint32_t seconds = time->hours * 3600 + time->minutes * 60 + time->seconds;
+
+	return ((uint64_t)days * 86400 + seconds) * 1000000 + time->microseconds;
+}
+
+/**
+ * Parse a NMEA sentence (RMC or GGA) into data structure.
+ *
+ * @param L76_data: pointer to a L76LM33 structure to update.
+ * @param sentence: NMEA sentence (null terminated).
+ * @param timestamp_us: microsecond clock when the sentence started arriving.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t L76LM33_ParseSentence(L76LM33 *L76_Data, const char *sentence, uint64_t timestamp_us) {
 	// Debug received NMEA sentence
-	printf("%s\r\n", L76_NMEA_Buffer);
+	LOG("%s", sentence);
 
 	// Parse sentence
-	/*switch (minmea_sentence_id(line, false)) {
+	switch (minmea_sentence_id(sentence, false)) {
 		case MINMEA_SENTENCE_RMC: {
 			struct minmea_sentence_rmc frame;
-			if (minmea_parse_rmc(&frame, line)) {
-				printf("$xxRMC floating point degree coordinates and speed: (%f,%f) %f\n",
-						minmea_tocoord(&frame.latitude),
-						minmea_tocoord(&frame.longitude),
-						minmea_tofloat(&frame.speed));
+			if (!minmea_parse_rmc(&frame, sentence)) {
+				return -1; // Cannot parse NMEA sentence
 			}
-			else {
-				printf("$xxRMC sentence is not parsed\n");
+			if (!frame.valid) {
+				return -1; // No fix, don't update
 			}
+			L76_Data->latitude = minmea_tocoord(&frame.latitude);
+			L76_Data->longitude = minmea_tocoord(&frame.longitude);
+			L76_Data->utc_us = L76LM33_ToUnixTime_us(&frame.date, &frame.time);
+			L76_Data->utc_timestamp_us = timestamp_us;
 		} break;
 
-		case MINMEA_INVALID: {
-			printf("$xxxxx sentence is not valid\n");
+		case MINMEA_SENTENCE_GGA: {
+			struct minmea_sentence_gga frame;
+			if (!minmea_parse_gga(&frame, sentence)) {
+				return -1; // Cannot parse NMEA sentence
+			}
+			L76_Data->fix_quality = frame.fix_quality;
+			L76_Data->satellites = frame.satellites_tracked;
+			if (frame.fix_quality == 0) {
+				return -1; // No fix, don't update position and altitude
+			}
+
+			uint32_t now_ms = HAL_GetTick();
+			float altitude_m = minmea_tofloat(&frame.altitude);
+
+			// Vertical speed from the previous GGA epoch, if recent enough
+			// (sentence start stamps, no parsing latency jitter)
+			uint64_t dt_us = timestamp_us - L76_Data->timestamp_us;
+			if (L76_Data->timestamp_ms != 0 && dt_us > 0 && dt_us < L76LM33_MAX_EPOCH_GAP_MS * 1000) {
+				L76_Data->vertical_speed_mps = (altitude_m - L76_Data->altitude_m) * 1000000.0f / (uint32_t)dt_us;
+			} else {
+				L76_Data->vertical_speed_mps = 0;
+			}
+
+			L76_Data->latitude = minmea_tocoord(&frame.latitude);
+			L76_Data->longitude = minmea_tocoord(&frame.longitude);
+			L76_Data->altitude_m = altitude_m;
+			L76_Data->hdop = minmea_tofloat(&frame.hdop);
+			L76_Data->timestamp_ms = now_ms;
+			L76_Data->timestamp_us = timestamp_us;
 		} break;
 
 		default: {
-			printf("$xxxxx sentence is not parsed\n");
+			return -1; // Sentence not valid or not parsed
 		} break;
-	}*/
-
-	/*if (NMEA_ValidTrame(L76_NMEA_Buffer) != 0 || NMEA_Decode_GPRMC(L76_NMEA_Buffer, gps_data) != 0) {
-		return -1; // Cannot parse NMEA sentence
-	}*/
+	}
 
 	return 0; // OK
 }
 
 /**
- * Read NMEA sentence from UART circular buffer into a NMEA buffer.
+ * Read NMEA sentence from UART circular buffer into the sentence queue.
+ * Called from deferred work (PendSV), once per line ending received.
  *
  * @retval 0 OK
  * @retval -1 ERROR
  * @retval -2 Error, cannot find starting or ending character.
+ * @retval -3 Error, sentence queue full, sentence dropped.
  *
  */
 int8_t L76LM33_ReadSentence() {
@@ -154,9 +305,12 @@ int8_t L76LM33_ReadSentence() {
 		return -1; // Error, empty UART circular buffer
 	}
 
+	// Tail slot is always free, the sentence is only queued if another slot is free
+	uint8_t *L76_Sentence = L76_NMEA_Buffer[L76_NMEA_Tail % L76LM33_SENTENCE_QUEUE_SIZE];
+
 	// Clear NMEA buffer
-	for (int16_t i = 0; i < sizeof(L76_NMEA_Buffer); i++) {
-		L76_NMEA_Buffer[i] = 0;
+	for (int16_t i = 0; i < L76LM33_SENTENCE_SIZE; i++) {
+		L76_Sentence[i] = 0;
 	}
 
 
@@ -173,7 +327,7 @@ int8_t L76LM33_ReadSentence() {
 
 		if (c == '$') {
 			// Set starting character in NMEA buffer
-			L76_NMEA_Buffer[0] = '$';
+			L76_Sentence[0] = '$';
 
 			break; // Found starting characters
 		}
@@ -185,14 +339,14 @@ int8_t L76LM33_ReadSentence() {
 
 
 	// Read into NMEA buffer until ending character is found
-	for (uint16_t i = 1; i < sizeof(L76_NMEA_Buffer); i++) {
+	for (uint16_t i = 1; i < L76LM33_SENTENCE_SIZE - 1; i++) {
 		// Read character from UART buffer
 		if (!circular_buffer_pop(L76_circularBuffer, &c)) {
 			return -1; // Error, empty buffer
 		}
 
 		// Add character to NMEA buffer
-		L76_NMEA_Buffer[i] = c;
+		L76_Sentence[i] = c;
 
 		if (c == '\n') {
 			break; // Found ending character
@@ -203,9 +357,45 @@ int8_t L76LM33_ReadSentence() {
 		return -2; // Error, cannot find '\n'
 	}
 
+	if ((uint8_t)(L76_NMEA_Tail - L76_NMEA_Head) >= L76LM33_SENTENCE_QUEUE_SIZE - 1) {
+		return -3; // Error, sentence queue full
+	}
+	L76_NMEA_Tail++;
+
 	return 0;
 }
 
+/**
+ * Choose L76LM33 power mode.
+ *
+ * @param mode: L76LM33_MODE_PERIODIC, L76LM33_MODE_FULL_POWER or L76LM33_MODE_STANDBY
+ *
+ * Sending any command wakes up the module from standby.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t L76LM33_SetMode(uint8_t mode) {
+	if (mode == L76LM33_MODE_PERIODIC) {
+		char NMEA_PERIODIC[] = "$PMTK225,1,3000,12000,18000,72000*16\r\n";
+		if (L76LM33_SendCommand(NMEA_PERIODIC, sizeof(NMEA_PERIODIC)) != 0) {
+			return -1; // Error with UART
+		}
+	} else if (mode == L76LM33_MODE_STANDBY) {
+		char NMEA_STANDBY[] = "$PMTK161,0*28\r\n";
+		if (L76LM33_SendCommand(NMEA_STANDBY, sizeof(NMEA_STANDBY)) != 0) {
+			return -1; // Error with UART
+		}
+	} else {
+		char NMEA_FULL_POWER[] = "$PMTK225,0*2B\r\n";
+		if (L76LM33_SendCommand(NMEA_FULL_POWER, sizeof(NMEA_FULL_POWER)) != 0) {
+			return -1; // Error with UART
+		}
+	}
+
+	return 0; // OK
+}
+
 /**
  * Send array of character to L76LM33 using UART HAL functions.
  *
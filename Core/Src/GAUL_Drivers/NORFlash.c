@@ -0,0 +1,403 @@
+/*
+ * NORFlash.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/NORFlash.h"
+
+#include "main.h" // for NOR_CS_Pin
+
+#include "GAUL/SPIBus.h"
+#include "GAUL/Clock.h"
+
+#include "string.h" // for memcpy(), memset()
+
+// Operations queue, run in order by NORFLASH_Update() (main loop)
+static NORFlashOp _norflash_queue[NORFLASH_QUEUE_SIZE];
+static uint8_t _norflash_queue_head = 0; // Operation in progress (or next one)
+static uint8_t _norflash_queue_tail = 0;
+
+// Page program command and data of queued programs, used in queue order
+static uint8_t _norflash_pages[NORFLASH_PAGE_BUFFERS][NORFLASH_COMMAND_SIZE + NORFLASH_PAGE_SIZE];
+static uint8_t _norflash_pages_head = 0;
+static uint8_t _norflash_pages_tail = 0;
+
+// Written by the main loop, and by the DMA interrupt while NORFLASH_STATE_DMA
+static volatile NORFlashState _norflash_state = NORFLASH_STATE_IDLE;
+static volatile int8_t _norflash_dma_status = 0;
+
+// Page program transaction (GAUL/SPIBus.h)
+static SPIBusTransaction _norflash_transaction;
+
+// Start of the operation in progress
+static uint32_t _norflash_start_ms = 0;
+static uint64_t _norflash_start_us = 0;
+
+static NORFlashInfo _norflash_info = { 0 };
+static NORFlashStats _norflash_stats = { 0 };
+
+static int8_t NORFLASH_ReadStatus(uint8_t *status) {
+	uint8_t command = NORFLASH_CMD_READ_STATUS;
+	return SPIBUS_Transfer(SPIBUS_DEVICE_NORFLASH, &command, 1, status, 1);
+}
+
+/**
+ * Set the write enable latch, needed before each program or erase.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR SPI or latch not set (write protected, no device)
+ */
+static int8_t NORFLASH_WriteEnable() {
+	uint8_t command = NORFLASH_CMD_WRITE_ENABLE;
+	uint8_t status;
+	if (SPIBUS_Transfer(SPIBUS_DEVICE_NORFLASH, &command, 1, NULL, 0) != 0 || NORFLASH_ReadStatus(&status) != 0) {
+		return -1; // SPI ERROR
+	}
+	if ((status & NORFLASH_STATUS_WEL) == 0) {
+		return -1; // Error, latch not set
+	}
+
+	return 0; // OK
+}
+
+static void NORFLASH_Address(uint8_t *command, uint8_t opcode, uint32_t address) {
+	command[0] = opcode;
+	command[1] = address >> 16;
+	command[2] = address >> 8;
+	command[3] = address;
+}
+
+/**
+ * Remove the operation in progress from the queue, free its page buffer.
+ */
+static void NORFLASH_Dequeue() {
+	NORFlashOp *op = &_norflash_queue[_norflash_queue_head % NORFLASH_QUEUE_SIZE];
+	if (op->type == NORFLASH_OP_PROGRAM) {
+		_norflash_pages_head++;
+	}
+	_norflash_queue_head++;
+	_norflash_state = NORFLASH_STATE_IDLE;
+}
+
+/**
+ * Page program transaction done, CS high starts the program (DMA interrupt).
+ */
+static void NORFLASH_ProgramCallback(SPIBusTransaction *transaction) {
+	_norflash_dma_status = transaction->status;
+	_norflash_state = NORFLASH_STATE_BUSY;
+}
+
+/**
+ * Start the next operation (chip ready).
+ *
+ * @retval 0 OK, erase started (chip busy)
+ * @retval 1 OK, page program transaction queued (done in the DMA interrupt)
+ * @retval -1 ERROR, operation dropped
+ */
+static int8_t NORFLASH_Start() {
+	NORFlashOp *op = &_norflash_queue[_norflash_queue_head % NORFLASH_QUEUE_SIZE];
+	uint8_t command[NORFLASH_COMMAND_SIZE];
+
+	_norflash_start_ms = HAL_GetTick();
+	_norflash_start_us = CLOCK_GetTime_us();
+
+	if (NORFLASH_WriteEnable() != 0) {
+		return -1; // Error
+	}
+
+	if (op->type == NORFLASH_OP_ERASE) {
+		NORFLASH_Address(command, NORFLASH_CMD_SECTOR_ERASE, op->address);
+		if (SPIBUS_Transfer(SPIBUS_DEVICE_NORFLASH, command, NORFLASH_COMMAND_SIZE, NULL, 0) != 0) {
+			return -1; // SPI ERROR
+		}
+		_norflash_state = NORFLASH_STATE_BUSY;
+		return 0; // OK
+	}
+
+	// Page program: command and address in front of the page data, one transaction sent by DMA
+	uint8_t *page = _norflash_pages[_norflash_pages_head % NORFLASH_PAGE_BUFFERS];
+	NORFLASH_Address(page, NORFLASH_CMD_PAGE_PROGRAM, op->address);
+	_norflash_transaction.device = SPIBUS_DEVICE_NORFLASH;
+	_norflash_transaction.tx = page;
+	_norflash_transaction.tx_size = NORFLASH_COMMAND_SIZE + op->size;
+	_norflash_transaction.rx = NULL;
+	_norflash_transaction.rx_size = 0;
+	_norflash_transaction.callback = NORFLASH_ProgramCallback;
+
+	_norflash_dma_status = 0;
+	_norflash_state = NORFLASH_STATE_DMA;
+	if (SPIBUS_Submit(&_norflash_transaction) != 0) {
+		_norflash_state = NORFLASH_STATE_IDLE;
+		return -1; // Error, bus queue full
+	}
+
+	return 1; // OK, done in the DMA interrupt
+}
+
+/**
+ * Initialize the NOR flash.
+ * - Set the chip select on the SPI2 bus manager (SPIBUS_Init() called first)
+ * - Release from power-down
+ * - Wait for an operation started before a reset
+ * - Read and check the JEDEC ID (manufacturer, capacity)
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR SPI or device not found
+ * @retval -2 ERROR device stays busy
+ */
+int8_t NORFLASH_Init() {
+	_norflash_queue_head = _norflash_queue_tail = 0;
+	_norflash_pages_head = _norflash_pages_tail = 0;
+	_norflash_state = NORFLASH_STATE_IDLE;
+	memset(&_norflash_info, 0, sizeof(_norflash_info));
+
+	SPIBUS_SetChipSelect(SPIBUS_DEVICE_NORFLASH, NOR_CS_GPIO_Port, NOR_CS_Pin);
+
+	uint8_t command = NORFLASH_CMD_RELEASE_POWER_DOWN;
+	if (SPIBUS_Transfer(SPIBUS_DEVICE_NORFLASH, &command, 1, NULL, 0) != 0) {
+		return -1; // SPI ERROR
+	}
+	HAL_Delay(1); // tRES1 3 us
+
+	// An erase interrupted by a reset of the MCU keeps running, the ID is only read once done
+	// (status 0xFF: MISO pulled up, no device)
+	uint8_t status = NORFLASH_STATUS_BUSY;
+	uint32_t start_ms = HAL_GetTick();
+	while (NORFLASH_ReadStatus(&status) == 0 && (status & NORFLASH_STATUS_BUSY) != 0 && status != 0xFF
+			&& HAL_GetTick() - start_ms < NORFLASH_ERASE_TIMEOUT_MS);
+
+	uint8_t id[3];
+	command = NORFLASH_CMD_JEDEC_ID;
+	if (SPIBUS_Transfer(SPIBUS_DEVICE_NORFLASH, &command, 1, id, 3) != 0) {
+		return -1; // SPI ERROR
+	}
+	if (id[0] == 0x00 || id[0] == 0xFF || id[2] < NORFLASH_MIN_CAPACITY_ID || id[2] > NORFLASH_MAX_CAPACITY_ID) {
+		return -1; // Error, device not found
+	}
+	if ((status & NORFLASH_STATUS_BUSY) != 0) {
+		return -2; // Error, busy
+	}
+
+	_norflash_info.manufacturer_id = id[0];
+	_norflash_info.memory_type = id[1];
+	_norflash_info.capacity_id = id[2];
+	_norflash_info.size = 1UL << id[2];
+
+	return 0; // OK
+}
+
+/**
+ * Queue a sector erase, programs queued after it wait for its end.
+ *
+ * @param address: address of the sector (multiple of NORFLASH_SECTOR_SIZE).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR queue full
+ * @retval -2 ERROR invalid address or not initialized
+ */
+int8_t NORFLASH_EraseSector(uint32_t address) {
+	if (address % NORFLASH_SECTOR_SIZE != 0 || address >= _norflash_info.size) {
+		return -2; // Error, invalid address
+	}
+	if ((uint8_t)(_norflash_queue_tail - _norflash_queue_head) >= NORFLASH_QUEUE_SIZE) {
+		_norflash_stats.queue_full++;
+		return -1; // Error, queue full
+	}
+
+	NORFlashOp *op = &_norflash_queue[_norflash_queue_tail % NORFLASH_QUEUE_SIZE];
+	op->type = NORFLASH_OP_ERASE;
+	op->size = 0;
+	op->address = address;
+	_norflash_queue_tail++;
+
+	return 0; // OK
+}
+
+/**
+ * Queue a page program, the data is copied. Bytes can only be programmed from
+ * 1 to 0, the page must be erased first.
+ *
+ * @param address: first byte address.
+ * @param data: bytes to program.
+ * @param size: bytes count, the program must not cross a page boundary.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR queue full (see NORFLASH_GetFreePages())
+ * @retval -2 ERROR invalid address or size, or not initialized
+ */
+int8_t NORFLASH_ProgramPage(uint32_t address, const uint8_t *data, uint16_t size) {
+	if (size == 0 || (address % NORFLASH_PAGE_SIZE) + size > NORFLASH_PAGE_SIZE || address + size > _norflash_info.size) {
+		return -2; // Error, invalid address or size
+	}
+	if (NORFLASH_GetFreePages() == 0) {
+		_norflash_stats.queue_full++;
+		return -1; // Error, queue full
+	}
+
+	memcpy(&_norflash_pages[_norflash_pages_tail % NORFLASH_PAGE_BUFFERS][NORFLASH_COMMAND_SIZE], data, size);
+	_norflash_pages_tail++;
+
+	NORFlashOp *op = &_norflash_queue[_norflash_queue_tail % NORFLASH_QUEUE_SIZE];
+	op->type = NORFLASH_OP_PROGRAM;
+	op->size = size;
+	op->address = address;
+	_norflash_queue_tail++;
+
+	return 0; // OK
+}
+
+/**
+ * Run the queue: check if the operation in progress ended, start the next ones.
+ * Never waits for the chip, call it periodically (main loop).
+ */
+void NORFLASH_Update() {
+	if (_norflash_queue_head == _norflash_queue_tail || _norflash_state == NORFLASH_STATE_DMA) {
+		return; // Nothing to do, or page data being sent
+	}
+
+	while (_norflash_queue_head != _norflash_queue_tail) {
+		NORFlashOp *op = &_norflash_queue[_norflash_queue_head % NORFLASH_QUEUE_SIZE];
+
+		if (_norflash_state == NORFLASH_STATE_BUSY) {
+			uint8_t status;
+			if (_norflash_dma_status != 0 || NORFLASH_ReadStatus(&status) != 0) {
+				_norflash_stats.errors++;
+				NORFLASH_Dequeue();
+				continue; // Error, operation dropped
+			}
+
+			if ((status & NORFLASH_STATUS_BUSY) != 0) {
+				uint32_t timeout_ms = op->type == NORFLASH_OP_ERASE ? NORFLASH_ERASE_TIMEOUT_MS : NORFLASH_PROGRAM_TIMEOUT_MS;
+				if (HAL_GetTick() - _norflash_start_ms > timeout_ms) {
+					_norflash_stats.errors++;
+					NORFLASH_Dequeue(); // Error, operation given up, the next one waits for the chip
+				}
+				break; // Chip busy, bus free for other devices
+
+			}
+
+			// Operation done
+			uint32_t elapsed_us = CLOCK_GetTime_us() - _norflash_start_us;
+			if (op->type == NORFLASH_OP_ERASE) {
+				_norflash_stats.sectors_erased++;
+				if (elapsed_us > _norflash_stats.erase_max_us) {
+					_norflash_stats.erase_max_us = elapsed_us;
+				}
+			} else {
+				_norflash_stats.pages_programmed++;
+				_norflash_stats.bytes_programmed += op->size;
+				if (elapsed_us > _norflash_stats.program_max_us) {
+					_norflash_stats.program_max_us = elapsed_us;
+				}
+			}
+			NORFLASH_Dequeue();
+			continue;
+		}
+
+		// The chip may still be busy after an operation given up
+		uint8_t status;
+		if (NORFLASH_ReadStatus(&status) != 0 || (status & NORFLASH_STATUS_BUSY) != 0) {
+			break; // Retry next time
+		}
+
+		int8_t started = NORFLASH_Start();
+		if (started == 1) {
+			break; // Page data being sent
+		}
+		if (started != 0) {
+			_norflash_stats.errors++;
+			NORFLASH_Dequeue();
+			continue; // Error, operation dropped
+		}
+		break; // Erase started
+	}
+}
+
+/**
+ * Run the queue until every queued operation ended (blocking).
+ *
+ * @param timeout_ms: longest wait.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR timeout
+ */
+int8_t NORFLASH_Flush(uint32_t timeout_ms) {
+	uint32_t start_ms = HAL_GetTick();
+	while (_norflash_queue_head != _norflash_queue_tail) {
+		if (HAL_GetTick() - start_ms >= timeout_ms) {
+			return -1; // Error, timeout
+		}
+		NORFLASH_Update();
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Read bytes (blocking). Queued programs are not seen until done.
+ *
+ * @param address: first byte address.
+ * @param data: destination.
+ * @param size: bytes count.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR SPI
+ * @retval -2 ERROR chip busy (erase or program in progress)
+ * @retval -3 ERROR invalid address or size
+ */
+int8_t NORFLASH_Read(uint32_t address, uint8_t *data, uint16_t size) {
+	if (address + size > _norflash_info.size) {
+		return -3; // Error, invalid address
+	}
+	if (_norflash_state != NORFLASH_STATE_IDLE) {
+		return -2; // Error, chip busy
+	}
+
+	uint8_t command[NORFLASH_COMMAND_SIZE];
+	NORFLASH_Address(command, NORFLASH_CMD_READ_DATA, address);
+	if (SPIBUS_Transfer(SPIBUS_DEVICE_NORFLASH, command, NORFLASH_COMMAND_SIZE, data, size) != 0) {
+		return -1; // SPI ERROR
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Get the number of queued operations (including the one in progress).
+ *
+ * @return Operations count
+ */
+uint8_t NORFLASH_GetPending() {
+	return _norflash_queue_tail - _norflash_queue_head;
+}
+
+/**
+ * Get the number of pages that can be queued now.
+ *
+ * @return Pages count
+ */
+uint8_t NORFLASH_GetFreePages() {
+	uint8_t pages = NORFLASH_PAGE_BUFFERS - (uint8_t)(_norflash_pages_tail - _norflash_pages_head);
+	uint8_t ops = NORFLASH_QUEUE_SIZE - NORFLASH_GetPending();
+	return pages < ops ? pages : ops;
+}
+
+/**
+ * Get the JEDEC ID and size of the device (size 0 if not initialized).
+ *
+ * @return Pointer to the device information
+ */
+const NORFlashInfo *NORFLASH_GetInfo() {
+	return &_norflash_info;
+}
+
+/**
+ * Get NOR flash statistics (for debug or telemetry).
+ *
+ * @return Pointer to statistics
+ */
+const NORFlashStats *NORFLASH_GetStats() {
+	return &_norflash_stats;
+}
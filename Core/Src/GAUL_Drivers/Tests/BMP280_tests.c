@@ -8,45 +8,45 @@
 #include "GAUL_Drivers/Tests/BMP280_tests.h"
 
 #include "GAUL_Drivers/BMP280.h"
+#include "GAUL/Profile.h"
+#include "GAUL/Log.h"
 #include "stdio.h"
 
-extern BMP280 bmp_data;
+extern BMP280 _bmp_data; // Barometer.c
 extern UART_HandleTypeDef huart2; // UART via USB on NUCLEO-F103RB
 
 int8_t BMP280_TESTS_LogUART() {
-    // Debug timer High (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+    // Execution time in cycles (PROFILE_ENABLED), see PROFILE_Report()
+    PROFILE_BEGIN(BMP280_READ_ALTITUDE);
 
-    if (BMP280_ReadAltitude(&bmp_data) != 0) {
+    if (BMP280_ReadAltitude(&_bmp_data) != 0) {
     	printf("Error BMP280_ReadAltitude\r\n");
     	return -1; // Error
     }
 
-    // Debug timer Low (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+    PROFILE_END(BMP280_READ_ALTITUDE);
 
     // UART log
     char Data[36];
-    sprintf(Data, "%9.4f kPa %6.2f C %8.2f m\r\n", bmp_data.press_Pa / 1000, bmp_data.temp_C, bmp_data.alt_m);
+    sprintf(Data, "%9.4f kPa %6.2f C %8.2f m\r\n", _bmp_data.press_Pa / 1000, _bmp_data.temp_C, _bmp_data.alt_m);
     HAL_UART_Transmit(&huart2, (uint8_t *)Data, 36, 1000);
 
     return 0; // OK
 }
 
 int8_t BMP280_TESTS_LogSTLINK() {
-    // Debug timer High (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+    // Execution time in cycles (PROFILE_ENABLED), see PROFILE_Report()
+    PROFILE_BEGIN(BMP280_READ_ALTITUDE);
 
-    if (BMP280_ReadAltitude(&bmp_data) != 0) {
-    	printf("Error BMP280_ReadAltitude\r\n");
+    if (BMP280_ReadAltitude(&_bmp_data) != 0) {
+    	LOG("Error BMP280_ReadAltitude");
     	return -1; // Error
     }
 
-    // Debug timer Low (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+    PROFILE_END(BMP280_READ_ALTITUDE);
 
-    // STLINK log
-	printf("%9.4f kPa %6.2f C %8.2f m\r\n", bmp_data.press_Pa / 1000, bmp_data.temp_C, bmp_data.alt_m);
+    // STLINK log (tokenized, formatted by Tools/log_decoder.c)
+	LOG("%9.4f kPa %6.2f C %8.2f m", _bmp_data.press_Pa / 1000, _bmp_data.temp_C, _bmp_data.alt_m);
 
     return 0; // OK
 }
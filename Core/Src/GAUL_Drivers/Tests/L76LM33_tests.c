@@ -8,19 +8,17 @@
 #include "GAUL_Drivers/Tests/L76LM33_tests.h"
 
 #include "GAUL_Drivers/L76LM33.h"
+#include "GAUL/Profile.h"
 #include "stdio.h"
 
 extern UART_HandleTypeDef huart2; // UART via USB on NUCLEO-F103RB
 
 int8_t L76LM33_TESTS_LogDataUART() {
-    // Debug timer High (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+    // Execution time of the code is measured by the L76LM33 profiling zones
+    // (PROFILE_ENABLED), see PROFILE_Report()
 
     // CODE
 
-    // Debug timer Low (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
-
     // UART log
     char Data[36];
     sprintf(Data, "DATA\r\n");
@@ -30,14 +28,11 @@ int8_t L76LM33_TESTS_LogDataUART() {
 }
 
 int8_t L76LM33_TESTS_LogDataSTLINK() {
-    // Debug timer High (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+    // Execution time of the code is measured by the L76LM33 profiling zones
+    // (PROFILE_ENABLED), see PROFILE_Report()
 
     // CODE
 
-    // Debug timer Low (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
-
     // STLINK log
 	printf("DATA\r\n");
 
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
 /* User Defined Header Files */
 #include "circular_buffer.h"
@@ -22,11 +23,11 @@ struct circularBuffer{
     /* Manages the whether circular buffer in use (true) or not (false) */
     bool inUse;
 
-    /* Tracks the pop operation */
-    int head;
+    /* Tracks the pop operation (only written by the consumer) */
+    volatile int head;
     
-    /* Tracks the push operation */
-    int tail;
+    /* Tracks the push operation (only written by the producer) */
+    volatile int tail;
 
     /* Buffer item size */
     size_t itemSize;
@@ -52,6 +53,8 @@ static circularBuffer_t *circular_buffer_find_unused_instance(void)
         if (circularBufferPool[i].inUse == false)
             return &circularBufferPool[i];
     }
+
+    return NULL;
 }
 
 /* Creates and inits new circular buffer object */
@@ -61,6 +64,9 @@ circularBuffer_t *circular_buffer_init(size_t itemSize)
         return NULL;
 
     circularBuffer_t *newCircularBuffer = circular_buffer_find_unused_instance();
+    if (newCircularBuffer == NULL)
+        return NULL;
+
     newCircularBuffer->itemSize = itemSize;
     newCircularBuffer->capacity = CB_MAX_BUFFER_POOL_SIZE / itemSize;
 
@@ -90,31 +96,37 @@ void circular_buffer_destroy(circularBuffer_t *circularBuffer)
 }
 
 /* Pushes new data to buffer and moves tail to next position */
+/* Safe against one concurrent consumer (e.g. push from an interrupt, pop from the main loop):
+   only the producer writes tail, and the data is written before tail moves */
 bool circular_buffer_push(circularBuffer_t *const circularBuffer, const void *data)
 {
     if (circular_buffer_full(circularBuffer))
         return false;
     
-    (void) memcpy((void *)&circularBuffer->data[circularBuffer->tail + 1], data, circularBuffer->itemSize);
-    circularBuffer->tail += circularBuffer->itemSize;
+    int tail = circularBuffer->tail;
+    (void) memcpy((void *)&circularBuffer->data[tail], data, circularBuffer->itemSize);
+
+    /* Publish data before moving tail */
+    atomic_signal_fence(memory_order_seq_cst);
+    circularBuffer->tail = (tail + circularBuffer->itemSize) % (circularBuffer->capacity * circularBuffer->itemSize);
  
     return true;
 }
 
 /* Poppes data from buffer and moves head to next position */
+/* Safe against one concurrent producer: only the consumer writes head,
+   and the data is read before head moves */
 bool circular_buffer_pop(circularBuffer_t *const circularBuffer, void *data)
 {
     if (circular_buffer_empty(circularBuffer))
         return false;
     
-    (void) memcpy(data, (void *)&circularBuffer->data[circularBuffer->head + 1], circularBuffer->itemSize);
-    circularBuffer->data[circularBuffer->head] = 0;
-    circularBuffer->head += circularBuffer->itemSize;
+    int head = circularBuffer->head;
+    (void) memcpy(data, (void *)&circularBuffer->data[head], circularBuffer->itemSize);
 
-    if (circular_buffer_empty(circularBuffer)){
-        circularBuffer->head = 0;
-        circularBuffer->tail = 0;
-    }
+    /* Release slot after reading data */
+    atomic_signal_fence(memory_order_seq_cst);
+    circularBuffer->head = (head + circularBuffer->itemSize) % (circularBuffer->capacity * circularBuffer->itemSize);
  
     return true;
 }
@@ -140,14 +152,10 @@ bool circular_buffer_full(const circularBuffer_t *const circularBuffer)
 /* Gets the free available space in circular buffer */
 int circular_buffer_free_space(const circularBuffer_t *const circularBuffer)
 {
-    int freeSpace = 0;
+    int size = circularBuffer->capacity * circularBuffer->itemSize;
+    int used = (circularBuffer->tail - circularBuffer->head + size) % size;
 
-    if (circularBuffer->head > circularBuffer->tail)
-        freeSpace = circularBuffer->capacity - ((circularBuffer->head - circularBuffer->tail) / circularBuffer->itemSize) - 1;
-    else 
-        freeSpace = circularBuffer->capacity - ((circularBuffer->tail - circularBuffer->head) / circularBuffer->itemSize) - 1;
-    
-    return freeSpace;
+    return circularBuffer->capacity - (used / circularBuffer->itemSize) - 1;
 }
 
 /* Gets the capacity of circular buffer */
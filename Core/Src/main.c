@@ -29,6 +29,26 @@
 #include "GAUL_Drivers/L76LM33.h"
 #include "GAUL_Drivers/Tests/L76LM33_tests.h"
 
+#include "GAUL/Barometer.h"
+#include "GAUL/AltitudeFusion.h"
+#include "GAUL/FlightState.h"
+#include "GAUL/Beacon.h"
+#include "GAUL/Scheduler.h"
+#include "GAUL/Clock.h"
+#include "GAUL/TimeSync.h"
+#include "GAUL/CpuLoad.h"
+#include "GAUL/Profile.h"
+#include "GAUL/Log.h"
+#include "GAUL/Fault.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/Telemetry.h"
+#include "GAUL/Recorder.h"
+#include "GAUL/SPIBus.h"
+#include "GAUL/Crc.h"
+#include "GAUL/Download.h"
+
+#include "GAUL_Drivers/NORFlash.h"
+
 //#include "GAUL_Drivers/NMEA.h"
 
 /* USER CODE END Includes */
@@ -40,6 +60,10 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define GNSS_TASK_PERIOD_MS 100
+#define HEALTH_TASK_PERIOD_MS 500
+#define TELEMETRY_TASK_PERIOD_MS 20
+#define RECORDER_TASK_PERIOD_MS 20
 
 /* USER CODE END PD */
 
@@ -50,24 +74,47 @@
 
 /* Private variables ---------------------------------------------------------*/
 SPI_HandleTypeDef hspi2;
+DMA_HandleTypeDef hdma_spi2_rx;
+DMA_HandleTypeDef hdma_spi2_tx;
+
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim3;
 
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
-BMP280 bmp_data;
+Barometer barometer;
 //GPS_Data gps_data;
 L76LM33 L76_data;
+AltitudeFusion altitude_fusion;
+
+int8_t barometer_task_id;
+int8_t gnss_task_id;
+int8_t health_task_id;
+int8_t telemetry_task_id;
+int8_t recorder_task_id;
+int8_t download_task_id;
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_SPI2_Init(void);
+static void MX_TIM3_Init(void);
+static void MX_TIM2_Init(void);
 /* USER CODE BEGIN PFP */
+static void BarometerTask(void);
+static void GNSSTask(void);
+static void HealthTask(void);
+static void TelemetryTask(void);
+static void RecorderTask(void);
+static void DownloadTask(void);
 
 /* USER CODE END PFP */
 
@@ -85,6 +132,9 @@ int main(void)
 
   /* USER CODE BEGIN 1 */
 
+  // Check the fault record of the previous boot, enable fault handlers
+  FAULT_Init();
+
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -105,11 +155,31 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   MX_USART1_UART_Init();
   MX_SPI2_Init();
+  MX_TIM3_Init();
+  MX_TIM2_Init();
   /* USER CODE BEGIN 2 */
 
+  // Microsecond clock, started first to stamp every sample
+  if (CLOCK_Init(&htim2) != 0) {
+    LOG("Clock Initialization Error");
+    return -1; // Error
+  }
+
+  // Report a fault of the previous boot
+  FAULT_Report();
+
+  // CPU load meter (DWT cycle counter)
+  if (CPULOAD_Init() != 0) {
+    LOG("CPU load Initialization Error");
+  }
+
+  // Profiling zones (only when PROFILE_ENABLED)
+  PROFILE_Init();
+
   // SPI Bug Fix
   /* Note page 704/1136 RM0008 Rev 21 :
    * The idle state of SCK must correspond to the polarity selected in the
@@ -118,20 +188,76 @@ int main(void)
   uint8_t dummy = 0x00;
   HAL_SPI_Transmit(&hspi2, &dummy, 1, 1000);
 
+  // SPI2 bus manager (DMA transactions), shared by the BMP280 and the NOR flash
+  if (SPIBUS_Init(&hspi2) != 0) {
+    LOG("SPI bus Initialization Error");
+    return -1; // Error
+  }
+
   // Barometer
-  if (BMP280_Init(&bmp_data, &hspi2) != 0) {
-    printf("BMP280 Initialization Error\r\n");
+  if (BAROMETER_Init() != 0) {
+    LOG("BMP280 Initialization Error");
     // TODO: Buzzer or led 10 sec
     return -1; // Error
   }
 
+  // External NOR flash (optional, only detected: the recorder does not use it yet)
+  if (NORFLASH_Init() != 0) {
+    LOG("NOR flash Initialization Error");
+  }
+
   // GNSS module
   if (L76LM33_Init(&huart1) != 0) {
-    printf("L76LM33 Initialization Error\r\n");
+    LOG("L76LM33 Initialization Error");
     // TODO: Buzzer or led 10 sec
     return -1; // Error
   }
 
+  // Barometer and GNSS altitude fusion
+  ALTFUSION_Init(&altitude_fusion);
+
+  // GNSS UTC to local clock synchronization
+  TIMESYNC_Init();
+
+  // Start in pad idle (low power) state, or resume the flight after a fault reset
+  if (FLIGHT_Init() != 0) {
+    LOG("Flight state Initialization Error");
+  }
+  if (FLIGHT_GetState() == FLIGHT_STATE_LANDED) {
+    // Resumed once landed, restart recovery beacon
+    BEACON_Init();
+  }
+
+  // Binary telemetry downlink (USART2 DMA)
+  if (TELEMETRY_Init(&huart2) != 0) {
+    LOG("Telemetry Initialization Error");
+  }
+
+  // CRC unit (recorder records, download packets)
+  CRC32_Init();
+
+  // Flight data recorder (internal flash)
+  if (RECORDER_Init() != 0) {
+    LOG("Recorder Initialization Error");
+  }
+
+  // Post-flight log download (USART2, shared with telemetry)
+  if (DOWNLOAD_Init(&huart2) != 0) {
+    LOG("Download Initialization Error");
+  }
+
+  // Tasks, driven by TIM3 (1 ms tick)
+  if (SCHEDULER_Init(&htim3) != 0) {
+    LOG("Scheduler Initialization Error");
+    return -1; // Error
+  }
+  barometer_task_id = SCHEDULER_AddTask("barometer", BarometerTask, FLIGHT_GetPeriod_ms());
+  gnss_task_id = SCHEDULER_AddTask("gnss", GNSSTask, GNSS_TASK_PERIOD_MS);
+  health_task_id = SCHEDULER_AddTask("health", HealthTask, HEALTH_TASK_PERIOD_MS);
+  telemetry_task_id = SCHEDULER_AddTask("telemetry", TelemetryTask, TELEMETRY_TASK_PERIOD_MS);
+  recorder_task_id = SCHEDULER_AddTask("recorder", RecorderTask, RECORDER_TASK_PERIOD_MS);
+  download_task_id = SCHEDULER_AddTask("download", DownloadTask, DOWNLOAD_GetPeriod_ms());
+
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -144,12 +270,8 @@ int main(void)
 
     //BMP280_TESTS_LogSTLINK();
 
-    //L76LM33_Read(&gps_data);
-    L76LM33_Read(&L76_data);
-
-    //printf("%f %f\r\n", L76_data.latitude, L76_data.longitude);
-
-    HAL_Delay(500);
+    // Run ready tasks, sleep in between
+    SCHEDULER_Dispatch();
   }
   /* USER CODE END 3 */
 }
@@ -231,6 +353,96 @@ static void MX_SPI2_Init(void)
 
 }
 
+/**
+  * @brief TIM2 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM2_Init(void)
+{
+
+  /* USER CODE BEGIN TIM2_Init 0 */
+
+  /* USER CODE END TIM2_Init 0 */
+
+  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM2_Init 1 */
+
+  /* USER CODE END TIM2_Init 1 */
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 72-1;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 65535;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim2, &sClockSourceConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM2_Init 2 */
+
+  /* USER CODE END TIM2_Init 2 */
+
+}
+
+/**
+  * @brief TIM3 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM3_Init(void)
+{
+
+  /* USER CODE BEGIN TIM3_Init 0 */
+
+  /* USER CODE END TIM3_Init 0 */
+
+  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM3_Init 1 */
+
+  /* USER CODE END TIM3_Init 1 */
+  htim3.Instance = TIM3;
+  htim3.Init.Prescaler = 72-1;
+  htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim3.Init.Period = 1000-1;
+  htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim3, &sClockSourceConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim3, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM3_Init 2 */
+
+  /* USER CODE END TIM3_Init 2 */
+
+}
+
 /**
   * @brief USART1 Initialization Function
   * @param None
@@ -280,7 +492,7 @@ static void MX_USART2_UART_Init(void)
 
   /* USER CODE END USART2_Init 1 */
   huart2.Instance = USART2;
-  huart2.Init.BaudRate = 9600;
+  huart2.Init.BaudRate = 115200;
   huart2.Init.WordLength = UART_WORDLENGTH_8B;
   huart2.Init.StopBits = UART_STOPBITS_1;
   huart2.Init.Parity = UART_PARITY_NONE;
@@ -297,6 +509,28 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel4_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 2, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+  /* DMA1_Channel5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 2, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+  /* DMA1_Channel7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 4, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -323,6 +557,9 @@ static void MX_GPIO_Init(void)
   /*Configure GPIO pin Output Level */
   HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_SET);
 
+  /*Configure GPIO pin Output Level */
+  HAL_GPIO_WritePin(NOR_CS_GPIO_Port, NOR_CS_Pin, GPIO_PIN_SET);
+
   /*Configure GPIO pin : B1_Pin */
   GPIO_InitStruct.Pin = B1_Pin;
   GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
@@ -336,6 +573,13 @@ static void MX_GPIO_Init(void)
   GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
   HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+  /*Configure GPIO pin : NOR_CS_Pin */
+  GPIO_InitStruct.Pin = NOR_CS_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(NOR_CS_GPIO_Port, &GPIO_InitStruct);
+
   /*Configure GPIO pin : DEBUG_Pin */
   GPIO_InitStruct.Pin = DEBUG_Pin;
   GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
@@ -353,7 +597,7 @@ static void MX_GPIO_Init(void)
   __HAL_AFIO_REMAP_I2C1_ENABLE();
 
   /* EXTI interrupt init*/
-  HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, 6, 0);
   HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
 
 /* USER CODE BEGIN MX_GPIO_Init_2 */
@@ -375,6 +619,128 @@ int _write(int file, char *ptr, int len)
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
   L76LM33_RxCallback(huart);
+  DOWNLOAD_RxCpltCallback(huart);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+  TELEMETRY_TxCpltCallback(huart);
+  DOWNLOAD_TxCpltCallback(huart);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+  L76LM33_ErrorCallback(huart);
+  TELEMETRY_ErrorCallback(huart);
+  DOWNLOAD_ErrorCallback(huart);
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+  SPIBUS_CpltCallback(hspi);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+  SPIBUS_CpltCallback(hspi);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+  SPIBUS_CpltCallback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+  SPIBUS_ErrorCallback(hspi);
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+  SCHEDULER_TickCallback(htim);
+}
+
+/**
+  * @brief Barometer task: altitude, fusion and flight state.
+  *        Its period follows the flight state.
+  */
+static void BarometerTask(void)
+{
+  if (FLIGHT_GetState() == FLIGHT_STATE_LANDED) {
+    return; // BMP280 sleeps once landed
+  }
+
+  if (BAROMETER_ReadAltitude(&barometer) == 0) {
+    BUS_Publish(BUS_TOPIC_BARO, &barometer);
+    ALTFUSION_Update(&altitude_fusion);
+    FLIGHT_Update();
+
+    if (FLIGHT_GetState() == FLIGHT_STATE_LANDED) {
+      // Landed, start recovery beacon
+      BEACON_Init();
+    }
+  }
+
+  SCHEDULER_SetPeriod(barometer_task_id, FLIGHT_GetPeriod_ms());
+}
+
+/**
+  * @brief GNSS task: parse NMEA sentences, publish epochs, time sync, full power
+  *        mode at launch and recovery beacon.
+  */
+static void GNSSTask(void)
+{
+  //L76LM33_Read(&gps_data);
+  if (L76LM33_Read(&L76_data) == 0) {
+    BUS_Publish(BUS_TOPIC_GNSS, &L76_data);
+    TIMESYNC_Update();
+  }
+
+  //printf("%f %f\r\n", L76_data.latitude, L76_data.longitude);
+
+  // Blocking UART command, kept out of the barometer task
+  FLIGHT_UpdateGNSS();
+
+  if (FLIGHT_GetState() == FLIGHT_STATE_LANDED) {
+    BEACON_Update();
+  }
+}
+
+/**
+  * @brief Health task: heartbeat LED and CPU load.
+  */
+static void HealthTask(void)
+{
+  HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
+
+  // CPU load over the last period, see CPULOAD_Get()
+  CPULOAD_Update();
+
+  // SPI2 devices throughput over the last period, see SPIBUS_GetStats()
+  SPIBUS_Update();
+}
+
+/**
+  * @brief Telemetry task: send new samples, events and health.
+  */
+static void TelemetryTask(void)
+{
+  TELEMETRY_Update();
+}
+
+/**
+  * @brief Recorder task: record new samples, program flash, erase pages on the pad.
+  *        The log is frozen during a download.
+  */
+static void RecorderTask(void)
+{
+  if (!DOWNLOAD_IsActive()) {
+    RECORDER_Update();
+  }
+}
+
+/**
+  * @brief Download task: log download over USART2 on request (out of flight).
+  *        Its period is short while a download is in progress.
+  */
+static void DownloadTask(void)
+{
+  DOWNLOAD_Update();
+
+  SCHEDULER_SetPeriod(download_task_id, DOWNLOAD_GetPeriod_ms());
 }
 /* USER CODE END 4 */
 
@@ -386,10 +752,8 @@ void Error_Handler(void)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
-  __disable_irq();
-  while (1)
-  {
-  }
+  // Save the context and reset, reported on the next boot (see GAUL/Fault.h)
+  FAULT_Error((uint32_t)__builtin_return_address(0));
   /* USER CODE END Error_Handler_Debug */
 }
 
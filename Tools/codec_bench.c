@@ -0,0 +1,245 @@
+/*
+ * codec_bench.c
+ *
+ * Compression ratio of the sample codec (Core/Inc/GAUL/SampleCodec.h) on
+ * telemetry messages (Core/Inc/GAUL/TelemetrySchema.h). Samples are encoded
+ * like the firmware does (batched in frames, keyframe every N samples), decoded
+ * again and compared, then the sizes are reported for a few keyframe intervals.
+ *
+ * Synthetic profiles: barometer during a flight (boost, coast, descent, landed)
+ * and on the pad, GNSS epochs during a flight. Recorded profiles: CSV files
+ * written by telemetry_decoder -o (e.g. flight_BARO.csv).
+ *
+ * Build: gcc -O2 -Wall -I../Core/Inc -o codec_bench codec_bench.c ../Core/Src/GAUL/SampleCodec.c -lm
+ * Usage: ./codec_bench                     (synthetic profiles)
+ *        ./codec_bench flight_BARO.csv ... (recorded profiles)
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GAUL/TelemetrySchema.h"
+#include "GAUL/SampleCodec.h"
+
+TELEMETRY_DEFINE_MESSAGE_TABLE(messages)
+#define MESSAGE_COUNT (sizeof(messages) / sizeof(messages[0]))
+
+#define FRAME_OVERHEAD 6 // ID, sequence, CRC, COBS code byte, delimiter
+
+#define MAX_SAMPLES 100000
+
+typedef struct {
+	const TelemetryMessage *message;
+	uint32_t count;
+	int32_t (*values)[CODEC_MAX_FIELDS];
+} Profile;
+
+/**
+ * Encode a profile like the firmware, check the round trip.
+ *
+ * @return 0 OK, -1 ERROR round trip
+ */
+static int bench(const char *name, const Profile *profile) {
+	static const uint16_t intervals[] = { 8, 32, 128 };
+	uint32_t raw = profile->count * profile->message->size;
+	uint32_t raw_frames = profile->count * (profile->message->size + FRAME_OVERHEAD);
+
+	printf("%-24s %6u samples, raw %7u B body, %7u B framed\n", name, profile->count, raw, raw_frames);
+
+	for (size_t k = 0; k < sizeof(intervals) / sizeof(intervals[0]); k++) {
+		SampleCodec encoder, decoder;
+		CODEC_Init(&encoder, profile->message->field_count, intervals[k]);
+		CODEC_Init(&decoder, profile->message->field_count, intervals[k]);
+
+		uint32_t encoded = 0;
+		uint32_t frames = 0;
+		uint32_t batch = 0;
+		for (uint32_t i = 0; i < profile->count; i++) {
+			uint8_t sample[CODEC_MAX_SAMPLE_SIZE];
+			int32_t decoded[CODEC_MAX_FIELDS];
+
+			uint8_t keyframe = CODEC_KeyframeDue(&encoder);
+			uint8_t length = CODEC_Encode(&encoder, profile->values[i], sample);
+			if (CODEC_Decode(&decoder, sample, length, keyframe, decoded) != length
+					|| memcmp(decoded, profile->values[i], profile->message->field_count * sizeof(int32_t)) != 0) {
+				printf("FAIL %s: sample %u round trip\n", name, i);
+				return -1;
+			}
+
+			// Batching: a keyframe or a full body starts a new frame
+			if (batch == 0 || keyframe || batch + length > TELEMETRY_MAX_BODY) {
+				frames++;
+				batch = 0;
+			}
+			batch += length;
+			encoded += length;
+		}
+
+		uint32_t framed = encoded + frames * FRAME_OVERHEAD;
+		printf("    keyframe every %3u: %7u B body (%.2fx), %7u B framed (%.2fx), %.1f B/sample\n", intervals[k],
+				encoded, (double)raw / encoded, framed, (double)raw_frames / framed, (double)encoded / profile->count);
+	}
+
+	return 0;
+}
+
+static double noise(double amplitude) {
+	return amplitude * ((double)rand() / RAND_MAX * 2 - 1);
+}
+
+/**
+ * Scale and store a sample (same truncation as TELEMETRY_SET()).
+ */
+static void add_baro(Profile *profile, uint32_t t_ms, double altitude, double speed, double acceleration, uint8_t flags) {
+	TelemetryBaro body;
+	TELEMETRY_SET(BARO, body, timestamp_ms, t_ms);
+	TELEMETRY_SET(BARO, body, altitude_m, altitude);
+	TELEMETRY_SET(BARO, body, speed_mps, speed);
+	TELEMETRY_SET(BARO, body, acceleration_mps2, acceleration);
+	TELEMETRY_SET(BARO, body, flags, flags);
+	TELEMETRY_BaroToValues(&body, profile->values[profile->count++]);
+}
+
+static void synthetic_flight(Profile *profile) {
+	// 3 s boost at 100 m/s^2, coast to apogee, descent at 20 m/s, landed (40 ms samples)
+	for (uint32_t t_ms = 0; t_ms < 120000; t_ms += 40) {
+		double t = t_ms / 1000.0;
+		double altitude, speed, acceleration;
+		if (t < 3) {
+			acceleration = 100;
+			speed = 100 * t;
+			altitude = 50 * t * t;
+		} else if (t < 3 + 300 / 9.81) {
+			acceleration = -9.81;
+			speed = 300 - 9.81 * (t - 3);
+			altitude = 450 + 300 * (t - 3) - 4.905 * (t - 3) * (t - 3);
+		} else {
+			double apogee = 450 + 300 * 300 / (2 * 9.81);
+			double t_apogee = 3 + 300 / 9.81;
+			acceleration = 0;
+			speed = -20;
+			altitude = apogee - 20 * (t - t_apogee);
+			if (altitude < 0) {
+				altitude = 0;
+				speed = 0;
+			}
+		}
+		add_baro(profile, t_ms, altitude + noise(0.3), speed + noise(1), acceleration + noise(2), t > 3 && speed > 0 ? 0x02 : 0);
+	}
+}
+
+static void synthetic_pad(Profile *profile) {
+	// 10 min on the pad, 100 ms samples, sensor noise only
+	for (uint32_t t_ms = 0; t_ms < 600000; t_ms += 100) {
+		add_baro(profile, t_ms, noise(0.2), noise(0.5), noise(0.5), 0);
+	}
+}
+
+static void synthetic_gnss(Profile *profile) {
+	// 1 Hz epochs, drifting north-east at 10 m/s while climbing then descending
+	for (uint32_t t_ms = 0; t_ms < 600000; t_ms += 1000) {
+		double t = t_ms / 1000.0;
+		TelemetryGNSS body;
+		TELEMETRY_SET(GNSS, body, timestamp_ms, t_ms);
+		TELEMETRY_SET(GNSS, body, latitude, 46.78 + 10 * t / 111320 + noise(2e-6));
+		TELEMETRY_SET(GNSS, body, longitude, -71.27 + 10 * t / 76400 + noise(2e-6));
+		TELEMETRY_SET(GNSS, body, altitude_m, (t < 40 ? 120 * t : fmax(0, 4800 - 20 * (t - 40))) + noise(3));
+		TELEMETRY_SET(GNSS, body, hdop, 1.2 + noise(0.2));
+		TELEMETRY_SET(GNSS, body, fix_quality, 1);
+		TELEMETRY_SET(GNSS, body, satellites, 9 + (rand() % 3));
+		TELEMETRY_GNSSToValues(&body, profile->values[profile->count++]);
+	}
+}
+
+/**
+ * Load a CSV written by telemetry_decoder -o: message,sequence,field values...
+ *
+ * @return 0 OK, -1 ERROR
+ */
+static int load_csv(const char *path, Profile *profile) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	char line[1024];
+	while (fgets(line, sizeof(line), file) != NULL && profile->count < MAX_SAMPLES) {
+		char *token = strtok(line, ",\n");
+		if (token == NULL || line[0] == '#' || strcmp(token, "message") == 0) {
+			continue; // Header
+		}
+
+		const TelemetryMessage *message = NULL;
+		for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+			if (strcmp(messages[i].name, token) == 0) {
+				message = &messages[i];
+			}
+		}
+		if (message == NULL || (profile->message != NULL && profile->message != message)) {
+			continue; // Other message
+		}
+		profile->message = message;
+
+		strtok(NULL, ",\n"); // Sequence
+		for (uint8_t f = 0; f < message->field_count; f++) {
+			token = strtok(NULL, ",\n");
+			double value = token != NULL ? atof(token) : 0;
+			profile->values[profile->count][f] = (int32_t)llround(value * message->fields[f].scale);
+		}
+		profile->count++;
+	}
+
+	fclose(file);
+	return profile->message != NULL ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+	Profile profile = { NULL, 0, calloc(MAX_SAMPLES, sizeof(*profile.values)) };
+	int errors = 0;
+
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++) {
+			profile.message = NULL;
+			profile.count = 0;
+			if (load_csv(argv[i], &profile) != 0) {
+				fprintf(stderr, "%s: no telemetry samples\n", argv[i]);
+				errors++;
+				continue;
+			}
+			errors += bench(argv[i], &profile) != 0;
+		}
+		return errors ? 1 : 0;
+	}
+
+	srand(1);
+	for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+		if (messages[i].id == TELEMETRY_MSG_BARO) {
+			profile.message = &messages[i];
+		}
+	}
+	profile.count = 0;
+	synthetic_flight(&profile);
+	errors += bench("barometer flight", &profile) != 0;
+
+	profile.count = 0;
+	synthetic_pad(&profile);
+	errors += bench("barometer pad", &profile) != 0;
+
+	for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+		if (messages[i].id == TELEMETRY_MSG_GNSS) {
+			profile.message = &messages[i];
+		}
+	}
+	profile.count = 0;
+	synthetic_gnss(&profile);
+	errors += bench("GNSS flight", &profile) != 0;
+
+	return errors ? 1 : 0;
+}
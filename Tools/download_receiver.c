@@ -0,0 +1,446 @@
+/*
+ * download_receiver.c
+ *
+ * Linux receiver of the post-flight log download (protocol in
+ * Core/Inc/GAUL/DownloadProtocol.h, board side in Core/Inc/GAUL/Download.h).
+ * Asks the board for a download at 115200 baud (telemetry frames are ignored
+ * meanwhile), switches to the baud rate of INFO, then writes DATA blocks to the
+ * output file in order. Go-back-N: blocks after a missing one are dropped and
+ * the missing offset is sent in a NACK, again after a timeout. The file is
+ * checked against the CRC-32 of the whole log (DONE) before BYE. With -e, a
+ * log that matches DONE is then erased on the board (ERASE until ERASED).
+ *
+ * A partial file is kept when the link is lost, -r resumes it if the board
+ * still has the same log (same log ID), else the download starts over.
+ *
+ * Build: gcc -O2 -Wall -I../Core/Inc -o download_receiver download_receiver.c
+ * Usage: ./download_receiver [-b baud] [-r] [-e] [-t seconds] device output.bin
+ *        -b baud: download baud rate (default 921600), 0 keeps 115200
+ *        -r: resume a partial output file
+ *        -e: erase the log on the board once the file matches DONE
+ *        -t seconds: wait for the board at most this long (default 10)
+ *
+ * Board: ./download_receiver /dev/ttyACM0 flight.bin
+ * Test:  see Tools/download_simulator.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "GAUL/DownloadProtocol.h"
+
+#define HELLO_PERIOD_MS 200		// HELLO repeated until INFO
+#define NACK_TIMEOUT_MS 300		// NACK sent again without the missing block
+#define LINK_TIMEOUT_MS 3000	// Board lost without a valid packet
+#define SWITCH_DELAY_MS 20		// Board switches baud rate within a task period after INFO
+#define ERASE_PERIOD_MS 1000	// ERASE repeated until ERASED
+#define ERASE_TIMEOUT_MS 15000	// Whole log erase (~20-40 ms per page)
+
+typedef union {
+	DownloadHeader header;
+	DownloadInfo info;
+	DownloadData data;
+	DownloadDone done;
+	DownloadErased erased;
+	uint32_t words[DOWNLOAD_MAX_FRAME / 4 + 1];
+} Packet;
+
+static int port = -1;
+
+// Frame being received
+static uint8_t frame[DOWNLOAD_MAX_FRAME];
+static uint32_t frame_length = 0;	// Above DOWNLOAD_MAX_FRAME: too long, dropped at the next delimiter
+
+static struct {
+	uint32_t packets;
+	uint32_t invalid;		// COBS, CRC or version errors (telemetry frames included before INFO)
+	uint32_t duplicates;	// Blocks already received (after a go back)
+	uint32_t dropped;		// Blocks after a missing one
+	uint32_t nacks;
+	uint32_t acks;
+} stats;
+
+static uint64_t now_ms() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static speed_t baud_to_speed(uint32_t baud_rate) {
+	switch (baud_rate) {
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+	case 460800: return B460800;
+	case 500000: return B500000;
+	case 576000: return B576000;
+	case 921600: return B921600;
+	case 1000000: return B1000000;
+	case 1152000: return B1152000;
+	case 1500000: return B1500000;
+	case 2000000: return B2000000;
+	default: return B0;
+	}
+}
+
+static int set_baud_rate(uint32_t baud_rate) {
+	struct termios tio;
+	speed_t speed = baud_to_speed(baud_rate);
+
+	if (speed == B0 || tcgetattr(port, &tio) != 0) {
+		return -1;
+	}
+	tcdrain(port);
+	cfsetspeed(&tio, speed);
+	return tcsetattr(port, TCSANOW, &tio);
+}
+
+/**
+ * Send a host packet: header, body, CRC, COBS and delimiter.
+ */
+static void send_packet(uint8_t type, const void *body, uint16_t length) {
+	uint32_t words[8];
+	uint8_t encoded[sizeof(words) + 2];
+
+	DownloadHeader header = { .type = type, .version = DOWNLOAD_PROTOCOL_VERSION, .length = length };
+	memcpy(words, &header, sizeof(header));
+	if (length != 0) {
+		memcpy(&words[1], body, length);
+	}
+	uint32_t crc = DOWNLOAD_Crc32(0xFFFFFFFF, words, 1 + length / 4);
+	memcpy(&words[1 + length / 4], &crc, sizeof(crc));
+
+	uint16_t frame_length = COBS_Encode((const uint8_t *)words, sizeof(header) + length + sizeof(crc), encoded);
+	if (write(port, encoded, frame_length) != frame_length) {
+		perror("write");
+	}
+}
+
+static void send_offset(uint8_t type, uint32_t offset) {
+	send_packet(type, &offset, sizeof(offset));
+	if (type == DOWNLOAD_PACKET_NACK) {
+		stats.nacks++;
+	} else {
+		stats.acks++;
+	}
+}
+
+/**
+ * Read the next valid board packet.
+ *
+ * @return Packet length, 0 on timeout, -1 if the link is lost
+ */
+static int receive_packet(Packet *packet, int timeout_ms) {
+	uint64_t deadline = now_ms() + timeout_ms;
+
+	while (1) {
+		uint8_t byte;
+		ssize_t count = read(port, &byte, 1);
+		if (count < 0 && errno != EAGAIN) {
+			return -1; // Link lost (unplugged, simulator exited)
+		}
+		if (count <= 0) {
+			int64_t left = (int64_t)(deadline - now_ms());
+			if (left <= 0) {
+				return 0;
+			}
+			struct pollfd fd = { .fd = port, .events = POLLIN };
+			if (poll(&fd, 1, left) > 0 && (fd.revents & (POLLERR | POLLHUP))) {
+				return -1; // Hang up, bytes left were read above
+			}
+			continue;
+		}
+
+		if (byte != 0x00) {
+			if (frame_length < DOWNLOAD_MAX_FRAME) {
+				frame[frame_length] = byte;
+			}
+			if (frame_length <= DOWNLOAD_MAX_FRAME) {
+				frame_length++;
+			}
+			continue;
+		}
+
+		uint32_t length = frame_length;
+		frame_length = 0;
+		if (length == 0) {
+			continue;
+		}
+		uint16_t packet_length = length <= DOWNLOAD_MAX_FRAME ? COBS_Decode(frame, length, (uint8_t *)packet) : 0;
+		if (packet_length < sizeof(DownloadHeader) + 4 || packet_length % 4 != 0
+				|| packet->header.version != DOWNLOAD_PROTOCOL_VERSION
+				|| packet->header.length != packet_length - sizeof(DownloadHeader) - 4
+				|| packet->words[packet_length / 4 - 1] != DOWNLOAD_Crc32(0xFFFFFFFF, packet->words, packet_length / 4 - 1)) {
+			stats.invalid++;
+			continue;
+		}
+		stats.packets++;
+		return packet_length;
+	}
+}
+
+/**
+ * Erase the log on the board after DONE: ERASE until ERASED.
+ *
+ * @return 0 erased, 1 refused or failed, 2 no answer
+ */
+static int erase_log(const DownloadDone *done) {
+	uint32_t body[2] = { done->size, done->log_crc };
+	uint64_t give_up = now_ms() + ERASE_TIMEOUT_MS;
+	Packet packet;
+
+	fprintf(stderr, "Erasing the log on the board\n");
+	while (now_ms() < give_up) {
+		send_packet(DOWNLOAD_PACKET_ERASE, body, sizeof(body));
+		uint64_t resend = now_ms() + ERASE_PERIOD_MS;
+		while (now_ms() < resend) {
+			int length = receive_packet(&packet, ERASE_PERIOD_MS / 4);
+			if (length < 0) {
+				return 2; // Link lost
+			}
+			if (length > 0 && packet.header.type == DOWNLOAD_PACKET_ERASED) {
+				if (packet.erased.status != DOWNLOAD_ERASE_OK) {
+					fprintf(stderr, "Erase %s\n", packet.erased.status == DOWNLOAD_ERASE_REFUSED ? "refused" : "failed");
+					return 1;
+				}
+				fprintf(stderr, "Log erased\n");
+				return 0;
+			}
+		}
+	}
+	fprintf(stderr, "Erase: no answer\n");
+	return 2;
+}
+
+/**
+ * CRC-32 of the first bytes of a file (whole words).
+ */
+static uint32_t file_crc(int fd, uint32_t size) {
+	uint32_t crc = 0xFFFFFFFF;
+	uint32_t words[DOWNLOAD_BLOCK_SIZE / 4];
+
+	for (uint32_t offset = 0; offset < size; offset += sizeof(words)) {
+		uint32_t length = size - offset < sizeof(words) ? size - offset : sizeof(words);
+		if (pread(fd, words, length, offset) != (ssize_t)length) {
+			return 0;
+		}
+		crc = DOWNLOAD_Crc32(crc, words, length / 4);
+	}
+	return crc;
+}
+
+int main(int argc, char **argv) {
+	uint32_t baud_rate = DOWNLOAD_DEFAULT_BAUD_RATE;
+	int resume = 0;
+	int erase = 0;
+	int timeout_s = 10;
+	int usage = 0;
+	int option;
+
+	while ((option = getopt(argc, argv, "b:ret:")) != -1) {
+		switch (option) {
+		case 'b': baud_rate = strtoul(optarg, NULL, 0); break;
+		case 'r': resume = 1; break;
+		case 'e': erase = 1; break;
+		case 't': timeout_s = atoi(optarg); break;
+		default: usage = 1; break;
+		}
+	}
+	if (usage || optind + 2 != argc || (baud_rate != 0 && baud_to_speed(baud_rate) == B0)) {
+		fprintf(stderr, "Usage: %s [-b baud] [-r] [-e] [-t seconds] device output.bin\n", argv[0]);
+		return 2;
+	}
+	const char *device = argv[optind];
+	const char *output = argv[optind + 1];
+
+	port = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	struct termios tio;
+	if (port < 0 || tcgetattr(port, &tio) != 0) {
+		perror(device);
+		return 2;
+	}
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	cfsetspeed(&tio, baud_to_speed(DOWNLOAD_INITIAL_BAUD_RATE));
+	tcsetattr(port, TCSANOW, &tio);
+	tcflush(port, TCIOFLUSH);
+
+	// HELLO until INFO (the board ignores it in flight)
+	Packet packet;
+	DownloadInfo info;
+	uint64_t give_up = now_ms() + timeout_s * 1000;
+	while (1) {
+		if (now_ms() >= give_up) {
+			fprintf(stderr, "%s: no answer (board in flight or not connected)\n", device);
+			return 2;
+		}
+		send_packet(DOWNLOAD_PACKET_HELLO, &baud_rate, sizeof(baud_rate));
+		int length = receive_packet(&packet, HELLO_PERIOD_MS);
+		if (length < 0) {
+			fprintf(stderr, "%s: link lost\n", device);
+			return 2;
+		}
+		if (length > 0 && packet.header.type == DOWNLOAD_PACKET_INFO) {
+			info = packet.info;
+			break;
+		}
+	}
+	if (info.block_size == 0 || info.block_size > DOWNLOAD_BLOCK_SIZE || info.window_blocks == 0) {
+		fprintf(stderr, "Unsupported block size %u or window %u\n", info.block_size, info.window_blocks);
+		return 2;
+	}
+	fprintf(stderr, "Log: %u bytes, ID %08X, %u baud\n", info.size, info.log_id, info.baud_rate);
+
+	// Resume a partial file of the same log, else start over
+	int fd = open(output, O_RDWR | O_CREAT, 0644);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		perror(output);
+		return 2;
+	}
+	uint32_t expected = 0;
+	if (resume && st.st_size > 0) {
+		uint32_t partial = st.st_size - st.st_size % info.block_size;
+		if (partial >= DOWNLOAD_LOG_ID_SIZE && partial <= info.size && file_crc(fd, DOWNLOAD_LOG_ID_SIZE) == info.log_id) {
+			expected = partial;
+			fprintf(stderr, "Resuming at %u bytes\n", expected);
+		} else {
+			fprintf(stderr, "Partial file of another log, starting over\n");
+		}
+	}
+	if (ftruncate(fd, expected) != 0) {
+		perror(output);
+		return 2;
+	}
+
+	if (info.baud_rate != DOWNLOAD_INITIAL_BAUD_RATE && set_baud_rate(info.baud_rate) != 0) {
+		fprintf(stderr, "%s: cannot set %u baud\n", device, info.baud_rate);
+		return 2;
+	}
+	usleep(SWITCH_DELAY_MS * 1000);
+
+	// Blocks in order, NACK the first missing one
+	uint64_t start_ms = now_ms();
+	uint64_t last_rx_ms = start_ms;
+	uint64_t nack_ms = start_ms;
+	uint64_t ack_ms = start_ms;
+	uint32_t resumed = expected;
+	uint32_t acked = expected;
+	uint32_t ack_step = info.block_size * (info.window_blocks / 2 > 0 ? info.window_blocks / 2 : 1);
+	int nack_pending = 1; // The first NACK starts the download
+	int result = 1;
+	send_offset(DOWNLOAD_PACKET_NACK, expected);
+
+	while (1) {
+		uint64_t tick = now_ms();
+		if (tick - last_rx_ms >= LINK_TIMEOUT_MS) {
+			fprintf(stderr, "Board not responding\n");
+			result = 2;
+			break;
+		}
+		if (nack_pending && tick - nack_ms >= NACK_TIMEOUT_MS) {
+			send_offset(DOWNLOAD_PACKET_NACK, expected);
+			nack_ms = tick;
+		}
+
+		int length = receive_packet(&packet, NACK_TIMEOUT_MS / 3);
+		if (length < 0) {
+			fprintf(stderr, "Link lost\n");
+			result = 2;
+			break;
+		}
+		if (length == 0) {
+			if (!nack_pending && now_ms() - last_rx_ms >= NACK_TIMEOUT_MS) {
+				nack_pending = 1; // Last blocks of the window lost, NACK on the next pass
+				nack_ms = 0;
+			}
+			continue;
+		}
+		last_rx_ms = now_ms();
+
+		if (packet.header.type == DOWNLOAD_PACKET_DATA) {
+			uint32_t offset = packet.data.offset;
+			uint32_t size = packet.header.length - sizeof(uint32_t);
+			if (offset < expected) {
+				stats.duplicates++;
+				// Tell the board to skip ahead, at most once per NACK timeout
+				if (last_rx_ms - ack_ms >= NACK_TIMEOUT_MS) {
+					send_offset(DOWNLOAD_PACKET_ACK, expected);
+					ack_ms = last_rx_ms;
+				}
+				continue;
+			}
+			if (offset > expected) {
+				stats.dropped++;
+				if (!nack_pending) {
+					send_offset(DOWNLOAD_PACKET_NACK, expected);
+					nack_pending = 1;
+					nack_ms = last_rx_ms;
+				}
+				continue;
+			}
+			if (size == 0 || size > info.block_size || offset + size > info.size
+					|| pwrite(fd, packet.data.data, size, offset) != (ssize_t)size) {
+				fprintf(stderr, "Invalid block at %u\n", offset);
+				result = 2;
+				break;
+			}
+			expected += size;
+			nack_pending = 0;
+			if (expected - acked >= ack_step || expected == info.size) {
+				send_offset(DOWNLOAD_PACKET_ACK, expected);
+				acked = expected;
+				ack_ms = last_rx_ms;
+			}
+			if (expected % (16 * info.block_size) == 0) {
+				fprintf(stderr, "\r%u / %u bytes", expected, info.size);
+			}
+		} else if (packet.header.type == DOWNLOAD_PACKET_DONE && expected == info.size) {
+			uint32_t crc = file_crc(fd, info.size);
+			uint64_t elapsed_ms = now_ms() - start_ms;
+			fprintf(stderr, "\r%s: %u bytes, ", output, info.size);
+			if (packet.done.size != info.size || crc != packet.done.log_crc) {
+				fprintf(stderr, "CRC error (%08X, board %08X)\n", crc, packet.done.log_crc);
+				result = 1;
+			} else {
+				fprintf(stderr, "CRC ok, %.1f KB/s\n",
+						(info.size - resumed) / 1024.0 / (elapsed_ms > 0 ? elapsed_ms / 1000.0 : 1));
+				result = 0;
+				// Only a log checked against DONE is erased
+				if (erase && fsync(fd) == 0) {
+					result = erase_log(&packet.done);
+				}
+			}
+			send_packet(DOWNLOAD_PACKET_BYE, NULL, 0);
+			send_packet(DOWNLOAD_PACKET_BYE, NULL, 0); // Else the board leaves after its idle timeout
+			break;
+		}
+	}
+
+	fprintf(stderr, "%u packets, %u invalid, %u duplicates, %u dropped, %u NACK, %u ACK\n", stats.packets, stats.invalid,
+			stats.duplicates, stats.dropped, stats.nacks, stats.acks);
+	fsync(fd);
+	close(fd);
+	tcdrain(port);
+	close(port);
+
+	return result;
+}
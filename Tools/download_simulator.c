@@ -0,0 +1,536 @@
+/*
+ * download_simulator.c
+ *
+ * Board simulator of the log download mode (Core/Inc/GAUL/Download.h) on a
+ * pseudo terminal, for end to end tests of Tools/download_receiver.c. The
+ * firmware module is compiled as is against the HAL stub (Tools/hal_stub):
+ * - USART2: bytes leave at the configured baud rate (8N1, real time), the
+ *   TX complete interrupt fires after the last byte. Bytes are garbled both
+ *   ways while the receiver speed (pty termios) differs from the UART baud rate
+ * - telemetry frames every 50 ms until paused, the recorder is replaced by a
+ *   log image of valid recorder pages (headers, records and CRC-32), an erase
+ *   (ERASE after DONE) empties it
+ * - faults: bytes dropped or corrupted both ways, DMA errors (transfer cut) and
+ *   RX overruns, link cut after some bytes (resume tests)
+ * Rule violations (baud rate changed or frame started during a transfer,
+ * download frame while telemetry runs, RX armed twice) fail the run.
+ *
+ * Build: gcc -O2 -Wall -Ihal_stub -I../Core/Inc -o download_simulator download_simulator.c ../Core/Src/GAUL/Download.c
+ * Usage: ./download_simulator [-p pages] [-s seed] [-d drop] [-c corrupt] [-e errors] [-k bytes] [-a] [-o image.bin]
+ *        -p pages: log size in 1 KB recorder pages (default 40)
+ *        -s seed: log content (same seed, same log ID) and faults
+ *        -d, -c, -e: bytes dropped, bytes corrupted, UART errors (per 10000 bytes)
+ *        -k bytes: cut the link (exit) after sending this many bytes
+ *        -a: in flight (ascent), HELLO is refused
+ *        -o image.bin: write the log image, to compare with the download
+ * Prints the pty path on stdout, then exits when the first download session
+ * ends (BYE or idle timeout), with statistics on stderr.
+ *
+ * Test: ./download_simulator -o image.bin > pty.txt & sleep 0.2
+ *       ./download_receiver $(cat pty.txt) log.bin && cmp image.bin log.bin
+ *       (with download_receiver -e, the board reports "log erased")
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/Download.h"
+#include "GAUL/Recorder.h"
+#include "GAUL/Telemetry.h"
+#include "GAUL/FlightState.h"
+#include "GAUL/Crc.h"
+
+#define SIM_PCLK1 36000000	// APB1 (USART2)
+#define SIM_PCLK2 72000000	// APB2 (USART1)
+#define SIM_PAGE_SIZE 1024	// STM32F103RB flash page
+#define SIM_RECORD_SIZE 64
+#define SIM_TELEMETRY_PERIOD_MS 50
+#define SIM_TELEMETRY_FRAME 24
+
+// Hardware model
+GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+SPI_TypeDef sim_spi2;
+USART_TypeDef sim_usart1, sim_usart2;
+volatile int sim_irq_disabled = 0;
+
+static DMA_HandleTypeDef sim_dma_usart2_tx;
+static UART_HandleTypeDef sim_huart2;
+static int sim_master = -1;
+static struct timespec sim_start;
+
+// Current TX transfer
+static struct {
+	const uint8_t *data;
+	uint16_t length;
+	uint16_t sent;
+	uint16_t cut;			// Length sent before an injected DMA error, 0: none
+	uint64_t start_us;
+	int telemetry;			// 1: telemetry frame, else download frame
+} sim_tx;
+static uint8_t *sim_rx_data = NULL;
+
+// Faults (per 10000 bytes)
+static uint32_t sim_drop = 0;
+static uint32_t sim_corrupt = 0;
+static uint32_t sim_errors = 0;
+static long sim_cut_after = -1;
+
+// Firmware stubs
+static FlightState sim_flight_state = FLIGHT_STATE_LANDED;
+static int sim_telemetry_paused = 0;
+static uint32_t sim_crc = 0xFFFFFFFF;
+
+// Log image (log order: oldest page first)
+static uint8_t *sim_log = NULL;
+static uint32_t sim_log_size = 0;
+
+static struct {
+	uint64_t bytes_out;
+	uint64_t bytes_in;
+	uint32_t garbled;		// Bytes at a mismatched baud rate
+	uint32_t dropped;
+	uint32_t corrupted;
+	uint32_t dma_errors;
+	uint32_t rx_overruns;
+	uint32_t rx_lost;		// Bytes received while RX was not armed
+	uint32_t telemetry_frames;
+	uint32_t violations;
+} sim_stats;
+
+static void violation(const char *message) {
+	fprintf(stderr, "VIOLATION: %s\n", message);
+	sim_stats.violations++;
+}
+
+static uint64_t now_us() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - sim_start.tv_sec) * 1000000 + (now.tv_nsec - sim_start.tv_nsec) / 1000;
+}
+
+static int chance(uint32_t per_10000) {
+	return per_10000 != 0 && (uint32_t)(rand() % 10000) < per_10000;
+}
+
+// HAL stub
+uint32_t HAL_GetTick(void) {
+	return now_us() / 1000;
+}
+
+void HAL_Delay(uint32_t Delay) {
+	usleep(Delay * 1000);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+	(void)GPIOx;
+	(void)GPIO_Pin;
+	(void)PinState;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+	return SIM_PCLK1;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void) {
+	return SIM_PCLK2;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+	if (huart->gState == HAL_UART_STATE_BUSY_TX) {
+		violation("UART reconfigured during a transfer");
+	}
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	sim_rx_data = NULL;
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef sim_transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, int telemetry) {
+	if (huart->gState != HAL_UART_STATE_READY) {
+		if (!telemetry) {
+			violation("download frame started during a transfer");
+		}
+		return HAL_BUSY;
+	}
+	if (Size == 0) {
+		return HAL_ERROR;
+	}
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+	sim_tx.data = pData;
+	sim_tx.length = Size;
+	sim_tx.sent = 0;
+	sim_tx.cut = chance(sim_errors) ? 1 + rand() % Size : 0;
+	sim_tx.start_us = now_us();
+	sim_tx.telemetry = telemetry;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+	if (sim_telemetry_paused == 0) {
+		violation("download frame sent while telemetry runs");
+	}
+	return sim_transmit(huart, pData, Size, 0);
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+	if (huart->RxState != HAL_UART_STATE_READY) {
+		violation("receive armed twice");
+		return HAL_BUSY;
+	}
+	if (Size != 1) {
+		violation("receive of more than one byte");
+	}
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	sim_rx_data = pData;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart) {
+	huart->RxState = HAL_UART_STATE_READY;
+	sim_rx_data = NULL;
+	return HAL_OK;
+}
+
+// Firmware stubs: CRC unit in software, recorder log image, telemetry and flight state
+void CRC32_Init() {
+	sim_crc = 0xFFFFFFFF;
+}
+
+uint32_t CRC32_Compute(const uint32_t *words, uint32_t count) {
+	sim_crc = 0xFFFFFFFF;
+	return CRC32_Accumulate(words, count);
+}
+
+uint32_t CRC32_Accumulate(const uint32_t *words, uint32_t count) {
+	sim_crc = DOWNLOAD_Crc32(sim_crc, words, count);
+	return sim_crc;
+}
+
+uint32_t RECORDER_GetLogSize() {
+	return sim_log_size;
+}
+
+int8_t RECORDER_ReadLog(uint32_t offset, uint8_t *data, uint16_t size) {
+	if (offset + size > sim_log_size) {
+		return -1;
+	}
+	memcpy(data, &sim_log[offset], size);
+	return 0;
+}
+
+int8_t RECORDER_Erase() {
+	if (sim_flight_state == FLIGHT_STATE_ASCENT || sim_flight_state == FLIGHT_STATE_DESCENT) {
+		return -1;
+	}
+	usleep(sim_log_size / SIM_PAGE_SIZE * 20000); // Blocking, ~20 ms per page
+	sim_log_size = 0;
+	return 0;
+}
+
+void TELEMETRY_Pause(uint8_t paused) {
+	sim_telemetry_paused = paused;
+}
+
+uint8_t TELEMETRY_IsIdle() {
+	return !(sim_huart2.gState == HAL_UART_STATE_BUSY_TX && sim_tx.telemetry);
+}
+
+FlightState FLIGHT_GetState() {
+	return sim_flight_state;
+}
+
+/**
+ * Build a log of valid recorder pages: page header record (consecutive
+ * sequence), then records of random data, the last page partly written.
+ */
+static void build_log(uint32_t pages) {
+	sim_log_size = pages * SIM_PAGE_SIZE;
+	sim_log = malloc(sim_log_size > 0 ? sim_log_size : 1);
+	memset(sim_log, 0xFF, sim_log_size);
+
+	uint32_t sequence = rand() % 1000;
+	for (uint32_t page = 0; page < pages; page++) {
+		uint32_t records = page == pages - 1 ? 1 + rand() % (SIM_PAGE_SIZE / SIM_RECORD_SIZE) : SIM_PAGE_SIZE / SIM_RECORD_SIZE;
+		for (uint32_t slot = 0; slot < records; slot++) {
+			uint8_t *record = &sim_log[page * SIM_PAGE_SIZE + slot * SIM_RECORD_SIZE];
+			if (slot == 0) {
+				uint32_t seq = sequence + page;
+				record[0] = 0x3F; // Page header
+				record[1] = 8;
+				memcpy(&record[2], &seq, sizeof(seq));
+				record[6] = FLIGHT_STATE_PAD_IDLE;
+				record[7] = 2; // Recorder version
+				record[8] = 1;
+				record[9] = 0x01;
+			} else {
+				record[0] = 1 + rand() % 8;
+				record[1] = 1 + rand() % (SIM_RECORD_SIZE - 6);
+				for (uint8_t i = 0; i < record[1]; i++) {
+					record[2 + i] = rand() % 4 == 0 ? 0x00 : rand(); // Zeros exercise COBS
+				}
+			}
+			uint32_t words[SIM_RECORD_SIZE / 4];
+			memcpy(words, record, sizeof(words));
+			uint32_t crc = DOWNLOAD_Crc32(0xFFFFFFFF, words, SIM_RECORD_SIZE / 4 - 1);
+			memcpy(&record[SIM_RECORD_SIZE - 4], &crc, sizeof(crc));
+		}
+	}
+}
+
+/**
+ * Receiver speed (pty termios, shared by master and slave).
+ */
+static uint32_t host_baud_rate() {
+	static const struct {
+		speed_t speed;
+		uint32_t baud_rate;
+	} speeds[] = {
+		{ B9600, 9600 }, { B19200, 19200 }, { B38400, 38400 }, { B57600, 57600 }, { B115200, 115200 },
+		{ B230400, 230400 }, { B460800, 460800 }, { B500000, 500000 }, { B576000, 576000 },
+		{ B921600, 921600 }, { B1000000, 1000000 }, { B1152000, 1152000 }, { B1500000, 1500000 },
+		{ B2000000, 2000000 }
+	};
+	struct termios tio;
+
+	if (tcgetattr(sim_master, &tio) != 0) {
+		return 0;
+	}
+	speed_t speed = cfgetospeed(&tio);
+	for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+		if (speeds[i].speed == speed) {
+			return speeds[i].baud_rate;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Apply the link model to a byte: garbled at a mismatched baud rate, then
+ * injected faults.
+ *
+ * @return 1 if the byte goes through, 0 if dropped
+ */
+static int link_byte(uint8_t *byte) {
+	if (host_baud_rate() != sim_huart2.Init.BaudRate) {
+		*byte = rand();
+		sim_stats.garbled++;
+		return 1;
+	}
+	if (chance(sim_drop)) {
+		sim_stats.dropped++;
+		return 0;
+	}
+	if (chance(sim_corrupt)) {
+		*byte ^= 1 << (rand() % 8);
+		sim_stats.corrupted++;
+	}
+	return 1;
+}
+
+/**
+ * Send the bytes of the current transfer due at the baud rate, then complete
+ * it (TX complete interrupt, or error interrupt for a cut transfer).
+ */
+static void uart_tx() {
+	if (sim_huart2.gState != HAL_UART_STATE_BUSY_TX) {
+		return;
+	}
+	uint64_t elapsed_us = now_us() - sim_tx.start_us;
+	uint32_t due = elapsed_us * sim_huart2.Init.BaudRate / 10 / 1000000;
+	uint16_t end = sim_tx.cut != 0 ? sim_tx.cut : sim_tx.length;
+	if (due > end) {
+		due = end;
+	}
+
+	while (sim_tx.sent < due) {
+		uint8_t byte = sim_tx.data[sim_tx.sent];
+		if (link_byte(&byte)) {
+			ssize_t written = write(sim_master, &byte, 1);
+			if (written != 1 && errno == EAGAIN) {
+				return; // Receiver not reading, retried (transfer slowed down)
+			}
+		}
+		sim_tx.sent++;
+		sim_stats.bytes_out++;
+		if (sim_cut_after >= 0 && sim_stats.bytes_out >= (uint64_t)sim_cut_after) {
+			fprintf(stderr, "Link cut after %llu bytes\n", (unsigned long long)sim_stats.bytes_out);
+			exit(0);
+		}
+	}
+
+	if (sim_tx.sent == end) {
+		sim_huart2.gState = HAL_UART_STATE_READY;
+		if (sim_tx.cut != 0) {
+			sim_stats.dma_errors++;
+			DOWNLOAD_ErrorCallback(&sim_huart2);
+		} else {
+			DOWNLOAD_TxCpltCallback(&sim_huart2);
+		}
+	}
+}
+
+/**
+ * Deliver received bytes, one RX complete interrupt per byte.
+ */
+static void uart_rx() {
+	uint8_t buffer[64];
+	ssize_t count = read(sim_master, buffer, sizeof(buffer));
+
+	for (ssize_t i = 0; i < count; i++) {
+		uint8_t byte = buffer[i];
+		sim_stats.bytes_in++;
+		if (!link_byte(&byte)) {
+			continue;
+		}
+		if (sim_huart2.RxState != HAL_UART_STATE_BUSY_RX) {
+			sim_stats.rx_lost++;
+			continue;
+		}
+		if (chance(sim_errors)) {
+			// Overrun: the HAL stops receiving and reports the error
+			sim_stats.rx_overruns++;
+			sim_huart2.RxState = HAL_UART_STATE_READY;
+			DOWNLOAD_ErrorCallback(&sim_huart2);
+			continue;
+		}
+		*sim_rx_data = byte;
+		sim_huart2.RxState = HAL_UART_STATE_READY;
+		DOWNLOAD_RxCpltCallback(&sim_huart2);
+	}
+}
+
+/**
+ * Send a telemetry frame (random COBS-like bytes and delimiter) while not paused.
+ */
+static void telemetry() {
+	static uint8_t frame[SIM_TELEMETRY_FRAME];
+	static uint32_t last_ms = 0;
+	uint32_t tick = HAL_GetTick();
+
+	if (tick - last_ms < SIM_TELEMETRY_PERIOD_MS) {
+		return;
+	}
+	last_ms = tick;
+	if (sim_telemetry_paused) {
+		return;
+	}
+	for (int i = 0; i < SIM_TELEMETRY_FRAME - 1; i++) {
+		frame[i] = 1 + rand() % 255;
+	}
+	frame[SIM_TELEMETRY_FRAME - 1] = 0x00;
+	if (sim_transmit(&sim_huart2, frame, SIM_TELEMETRY_FRAME, 1) == HAL_OK) {
+		sim_stats.telemetry_frames++;
+	}
+}
+
+int main(int argc, char **argv) {
+	uint32_t pages = 40;
+	unsigned int seed = 1;
+	const char *image_path = NULL;
+	int option;
+
+	while ((option = getopt(argc, argv, "p:s:d:c:e:k:ao:")) != -1) {
+		switch (option) {
+		case 'p': pages = strtoul(optarg, NULL, 0); break;
+		case 's': seed = strtoul(optarg, NULL, 0); break;
+		case 'd': sim_drop = strtoul(optarg, NULL, 0); break;
+		case 'c': sim_corrupt = strtoul(optarg, NULL, 0); break;
+		case 'e': sim_errors = strtoul(optarg, NULL, 0); break;
+		case 'k': sim_cut_after = strtol(optarg, NULL, 0); break;
+		case 'a': sim_flight_state = FLIGHT_STATE_ASCENT; break;
+		case 'o': image_path = optarg; break;
+		default:
+			fprintf(stderr, "Usage: %s [-p pages] [-s seed] [-d drop] [-c corrupt] [-e errors] [-k bytes] [-a] [-o image.bin]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// Same seed, same log
+	srand(seed);
+	build_log(pages);
+	if (image_path != NULL) {
+		FILE *image = fopen(image_path, "wb");
+		if (image == NULL || fwrite(sim_log, 1, sim_log_size, image) != sim_log_size) {
+			perror(image_path);
+			return 2;
+		}
+		fclose(image);
+	}
+	srand(seed * 7919 + 1); // Faults
+
+	sim_master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (sim_master < 0 || grantpt(sim_master) != 0 || unlockpt(sim_master) != 0) {
+		perror("pty");
+		return 2;
+	}
+	struct termios tio;
+	tcgetattr(sim_master, &tio);
+	cfmakeraw(&tio);
+	cfsetspeed(&tio, B115200);
+	tcsetattr(sim_master, TCSANOW, &tio);
+	fcntl(sim_master, F_SETFL, O_NONBLOCK);
+	signal(SIGPIPE, SIG_IGN);
+	printf("%s\n", ptsname(sim_master));
+	fflush(stdout);
+
+	clock_gettime(CLOCK_MONOTONIC, &sim_start);
+	sim_huart2 = (UART_HandleTypeDef){ .Instance = USART2, .Init = { .BaudRate = DOWNLOAD_INITIAL_BAUD_RATE },
+		.hdmatx = &sim_dma_usart2_tx, .gState = HAL_UART_STATE_READY, .RxState = HAL_UART_STATE_READY };
+	if (DOWNLOAD_Init(&sim_huart2) != 0) {
+		fprintf(stderr, "DOWNLOAD_Init failed\n");
+		return 1;
+	}
+
+	// Main loop: UART model, download task at its period, telemetry until paused
+	uint32_t next_ms = 0;
+	int was_active = 0;
+	while (1) {
+		uart_tx();
+		uart_rx();
+		telemetry();
+
+		uint32_t tick = HAL_GetTick();
+		if ((int32_t)(tick - next_ms) >= 0) {
+			DOWNLOAD_Update();
+			next_ms = tick + DOWNLOAD_GetPeriod_ms();
+		}
+
+		if (DOWNLOAD_IsActive()) {
+			was_active = 1;
+		} else if (was_active) {
+			break; // Session ended
+		}
+		if (sim_flight_state == FLIGHT_STATE_ASCENT && tick > 3000) {
+			break; // Refusal test
+		}
+		usleep(50);
+	}
+
+	const DownloadStats *stats = DOWNLOAD_GetStats();
+	fprintf(stderr, "Board: %lu sessions, %lu completed, %lu refused, %lu erases, %lu blocks sent, %lu resent, %lu NACK, "
+			"%lu ACK timeouts, %lu RX errors, %lu TX errors, %lu baud, %lu B/s\n",
+			(unsigned long)stats->sessions, (unsigned long)stats->completed, (unsigned long)stats->refused, (unsigned long)stats->erases,
+			(unsigned long)stats->blocks_sent, (unsigned long)stats->blocks_resent, (unsigned long)stats->nacks,
+			(unsigned long)stats->ack_timeouts, (unsigned long)stats->rx_errors, (unsigned long)stats->tx_errors,
+			(unsigned long)stats->baud_rate, (unsigned long)stats->bytes_per_s);
+	fprintf(stderr, "Link: %llu bytes out, %llu in, %u garbled, %u dropped, %u corrupted, %u DMA errors, "
+			"%u RX overruns, %u lost, %u telemetry frames, %u violations\n",
+			(unsigned long long)sim_stats.bytes_out, (unsigned long long)sim_stats.bytes_in, sim_stats.garbled,
+			sim_stats.dropped, sim_stats.corrupted, sim_stats.dma_errors, sim_stats.rx_overruns, sim_stats.rx_lost,
+			sim_stats.telemetry_frames, sim_stats.violations);
+
+	return sim_stats.violations != 0;
+}
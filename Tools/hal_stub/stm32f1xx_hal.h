@@ -0,0 +1,183 @@
+/*
+ * stm32f1xx_hal.h
+ *
+ * Host stub of the HAL subset used by the drivers compiled in host tools
+ * (e.g. Tools/norflash_emulator.c, Tools/download_simulator.c,
+ * Tools/interleaving_test.c, Tools/recorder_test.c). Each tool implements the
+ * functions it needs on top of its own hardware model.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#ifndef TOOLS_HAL_STUB_STM32F1XX_HAL_H_
+#define TOOLS_HAL_STUB_STM32F1XX_HAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+// GPIO
+typedef struct {
+	uint16_t ODR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+#define GPIOA (&sim_gpioa)
+#define GPIOB (&sim_gpiob)
+#define GPIOC (&sim_gpioc)
+
+typedef enum {
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+
+// Interrupts: masked sections delay the emulated interrupts. Compiler barriers
+// like the CMSIS intrinsics, emulated interrupts may be signal handlers
+#define SIM_BARRIER() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+extern volatile int sim_irq_disabled;
+#define __disable_irq() do { SIM_BARRIER(); sim_irq_disabled = 1; SIM_BARRIER(); } while (0)
+#define __enable_irq() do { SIM_BARRIER(); sim_irq_disabled = 0; SIM_BARRIER(); } while (0)
+#define __get_PRIMASK() ((uint32_t)sim_irq_disabled)
+#define __set_PRIMASK(primask) do { SIM_BARRIER(); sim_irq_disabled = (int)(primask); SIM_BARRIER(); } while (0)
+#define __DMB() SIM_BARRIER()
+
+// PendSV request (SCB->ICSR), delivered by the tool
+typedef struct {
+	volatile uint32_t ICSR;
+} SCB_Type;
+
+extern SCB_Type sim_scb;
+#define SCB (&sim_scb)
+#define SCB_ICSR_PENDSVSET_Msk (1UL << 28)
+
+// DMA
+typedef struct {
+	uint32_t id;
+} DMA_HandleTypeDef;
+
+// SPI
+typedef struct {
+	uint32_t id;
+} SPI_TypeDef;
+
+extern SPI_TypeDef sim_spi2;
+#define SPI2 (&sim_spi2)
+
+typedef struct {
+	SPI_TypeDef *Instance;
+	DMA_HandleTypeDef *hdmatx;
+	DMA_HandleTypeDef *hdmarx;
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+
+// UART
+typedef struct {
+	uint32_t id;
+} USART_TypeDef;
+
+extern USART_TypeDef sim_usart1, sim_usart2;
+#define USART1 (&sim_usart1)
+#define USART2 (&sim_usart2)
+
+typedef enum {
+	HAL_UART_STATE_RESET = 0x00,
+	HAL_UART_STATE_READY = 0x20,
+	HAL_UART_STATE_BUSY = 0x24,
+	HAL_UART_STATE_BUSY_TX = 0x21,
+	HAL_UART_STATE_BUSY_RX = 0x22
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+	uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct {
+	USART_TypeDef *Instance;
+	UART_InitTypeDef Init;
+	DMA_HandleTypeDef *hdmatx;
+	volatile HAL_UART_StateTypeDef gState;
+	volatile HAL_UART_StateTypeDef RxState;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+
+// Clocks
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+
+// Timers (handles only)
+typedef struct {
+	void *Instance;
+} TIM_HandleTypeDef;
+
+// Flash: programs are plain stores, the busy flag is read once per halfword so
+// the tool sees each of them (e.g. to cut programming with a reset)
+#define FLASH_PAGE_SIZE 0x400U
+#define __RAM_FUNC
+
+typedef struct {
+	volatile uint32_t CR;
+	volatile uint32_t SR;
+} FLASH_TypeDef;
+
+extern FLASH_TypeDef sim_flash;
+#define FLASH (&sim_flash)
+#define FLASH_CR_PG (1UL << 0)
+#define FLASH_SR_BSY sim_flash_busy()
+#define FLASH_SR_PGERR (1UL << 2)
+#define FLASH_SR_WRPRTERR (1UL << 4)
+#define FLASH_SR_EOP (1UL << 5)
+
+uint32_t sim_flash_busy(void);
+
+#define FLASH_TYPEERASE_PAGES 0x00U
+
+typedef struct {
+	uint32_t TypeErase;
+	uint32_t Banks;
+	uint32_t PageAddress;
+	uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
+
+// Tick
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+#endif /* TOOLS_HAL_STUB_STM32F1XX_HAL_H_ */
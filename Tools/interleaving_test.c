@@ -0,0 +1,535 @@
+/*
+ * interleaving_test.c
+ *
+ * Host test of the state shared between interrupts and the main loop (rules in
+ * Core/Inc/main.h), firmware modules compiled as is against the HAL stub
+ * (Tools/hal_stub). Interrupts are signals delivered at random instructions
+ * by a one-shot timer re-armed with a random delay, like on a single core:
+ * - SIGUSR1: peripheral interrupts (USART1, SPI2 DMA, sample bus reader and
+ *   writer), they preempt the main loop and PendSV
+ * - SIGUSR2: PendSV, deferred work (GAUL/DeferredWork.h), runs after the
+ *   interrupt posting it and preempts the main loop only
+ * Masked sections (__disable_irq(), PRIMASK) delay both until they end.
+ *
+ * Checked paths:
+ * - L76_circularBuffer: USART1 interrupt (L76LM33_RxCallback) pushes NMEA
+ *   bytes, PendSV pops sentences, the main loop parses them. Every sentence
+ *   parsed must be intact, in order, and stamped with the time of its '$'.
+ * - Sample bus seqlock: a topic published by the main loop and read by an
+ *   interrupt, another one the other way around. Every sample read must be
+ *   consistent (no torn read), and published counts never go back.
+ * - BMP280 register reads (local RX buffers, formerly the shared
+ *   BMP_RX_Buffer): SPI2 DMA bytes written by the interrupt through the bus
+ *   manager (GAUL/SPIBus.h), hung transfers reset by the timeout. Every read
+ *   must return one burst of the register file, and no DMA may target the
+ *   buffer once the read returned.
+ *
+ * Build: gcc -O2 -Wall -DPROFILE_ENABLED=0 -Ihal_stub -I../Core/Inc -o interleaving_test interleaving_test.c
+ *        ../Core/Src/GAUL_Drivers/L76LM33.c ../Core/Src/circular_buffer.c ../Core/Src/minmea.c
+ *        ../Core/Src/GAUL/DeferredWork.c ../Core/Src/GAUL/SampleBus.c ../Core/Src/GAUL/SPIBus.c
+ *        ../Core/Src/GAUL_Drivers/BMP280.c -lm
+ * Usage: ./interleaving_test [-t seconds] [-s seed]
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <sys/prctl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/AltitudeFusion.h"
+#include "GAUL/Barometer.h"
+#include "GAUL/DeferredWork.h"
+#include "GAUL/Log.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/SPIBus.h"
+#include "GAUL_Drivers/BMP280.h"
+#include "GAUL_Drivers/L76LM33.h"
+
+#define SIM_SENTENCES 64			// Sentence stamps kept (more than the queued sentences)
+#define SIM_BMP_HANG_PER_10000 20	// SPI2 DMA transfers that never end
+#define SIM_INTERRUPT_MIN_NS 2000	// Delay between two interrupts
+#define SIM_INTERRUPT_MAX_NS 40000
+#define SIM_BUS_READS 1024		// Reads of the interrupt topic per main loop iteration
+
+// L76LM33.c state checked by the test
+extern volatile uint8_t L76_NMEA_Head;
+extern volatile uint8_t L76_NMEA_Tail;
+extern volatile uint32_t L76_BytesDropped;
+
+// Hardware model
+GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+SPI_TypeDef sim_spi2;
+USART_TypeDef sim_usart1, sim_usart2;
+SCB_Type sim_scb;
+volatile int sim_irq_disabled = 0;
+
+static DMA_HandleTypeDef sim_dma_tx, sim_dma_rx;
+static SPI_HandleTypeDef sim_hspi2 = { SPI2, &sim_dma_tx, &sim_dma_rx };
+static UART_HandleTypeDef sim_huart1 = { .Instance = USART1 };
+
+static timer_t sim_timer;
+static volatile int sim_pendsv_pending = 0;	// PendSV delayed by a masked section
+static volatile int sim_in_interrupt = 0;	// SIGUSR1 handler running
+static uint64_t sim_interrupt_us;			// Clock seen by the SIGUSR1 handler (entry time)
+static struct timespec sim_start;
+
+// Main thread random numbers (interrupts use their own)
+static unsigned int sim_main_seed;
+static unsigned int sim_irq_seed;
+
+static uint64_t now_us() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - sim_start.tv_sec) * 1000000 + (now.tv_nsec - sim_start.tv_nsec) / 1000;
+}
+
+// USART1: NMEA stream, one byte per interrupt while the reception is armed
+static struct {
+	uint8_t *data;				// Armed by HAL_UART_Receive_IT
+	char sentence[96];
+	uint16_t length;
+	uint16_t index;
+	uint32_t number;			// Sentence being sent
+	uint64_t start_us[SIM_SENTENCES];	// Stamp of each sentence '$'
+} sim_uart;
+
+// SPI2 DMA: bytes written by interrupts, register file of the BMP280
+static struct {
+	volatile uint8_t active;
+	uint8_t hang;
+	uint8_t *rx;				// NULL: transmit
+	uint16_t size;
+	uint16_t done;
+	uint8_t selected;			// BMP280 chip select low
+	uint8_t reg;				// Register address of the burst
+	uint8_t burst[6];			// Registers 0xF7 to 0xFC at the start of the burst
+	uint32_t sample;			// Conversions done
+} sim_spi;
+
+static struct {
+	// Stream counters
+	uint32_t bytes;
+	uint32_t sentences_parsed;
+	uint32_t sentences_skipped;	// Dropped by the full sentence queue
+	uint32_t rx_not_armed;		// Bytes arriving while USART1 reception is not armed
+	uint32_t baro_published;
+	uint32_t baro_read;
+	uint32_t baro_busy;			// Interrupt read while the main loop was publishing
+	uint32_t altitude_published;
+	uint32_t altitude_read;
+	uint32_t bmp_reads;
+	uint32_t bmp_hangs;
+	uint32_t bmp_errors;
+	uint32_t interrupts;
+	uint32_t interrupts_delayed;
+	uint32_t pendsv;
+	// Violations
+	uint32_t bad_sentences;		// Parse error or wrong content
+	uint32_t out_of_order;
+	uint32_t bad_stamps;
+	uint32_t torn_reads;
+	uint32_t count_back;
+	uint32_t bad_bursts;
+	uint32_t dma_after_return;
+	uint32_t dma_overlaps;
+} sim;
+
+// HAL stub
+uint32_t HAL_GetTick(void) {
+	return now_us() / 1000;
+}
+
+void HAL_Delay(uint32_t Delay) {
+	uint64_t end_us = now_us() + Delay * 1000;
+	while (now_us() < end_us) {
+	}
+}
+
+uint64_t CLOCK_GetTime_us() {
+	return sim_in_interrupt ? sim_interrupt_us : now_us();
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+	if (GPIOx == BMP_CS_GPIO_Port && GPIO_Pin == BMP_CS_Pin) {
+		sim_spi.selected = PinState == GPIO_PIN_RESET;
+		sim_spi.reg = 0;
+	}
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+	sim_uart.data = pData;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef spi_dma(uint8_t *tx, uint8_t *rx, uint16_t size) {
+	if (sim_spi.active) {
+		sim.dma_overlaps++;
+		return HAL_BUSY;
+	}
+
+	if (rx == NULL) {
+		sim_spi.reg = tx[0] | 0x80; // Register address, bit 7 is replaced by the read/write bit in SPI
+	} else {
+		// Burst read: registers shadowed at the start of the burst
+		uint32_t sample = sim_spi.sample;
+		for (uint8_t i = 0; i < sizeof(sim_spi.burst); i++) {
+			sim_spi.burst[i] = (uint8_t)(sample * 7 + i * 31);
+		}
+	}
+	sim_spi.rx = rx;
+	sim_spi.size = size;
+	sim_spi.done = 0;
+	sim_spi.hang = (uint32_t)rand_r(sim_in_interrupt ? &sim_irq_seed : &sim_main_seed) % 10000 < SIM_BMP_HANG_PER_10000;
+	sim.bmp_hangs += sim_spi.hang;
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	sim_spi.active = 1;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
+	return spi_dma(pData, NULL, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
+	return spi_dma(pData, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi) {
+	sim_spi.active = 0;
+	return HAL_OK;
+}
+
+// Firmware stubs
+void LOG_Write(uint32_t token, const LogArg args[]) {
+	(void)token;
+	(void)args;
+}
+
+/**
+ * Fill a sample with one byte value (padding included): a torn read mixes values.
+ */
+static void fill_sample(void *sample, size_t size, uint32_t number) {
+	memset(sample, (uint8_t)number, size);
+	memcpy(sample, &number, sizeof(number));
+}
+
+static int check_sample(const void *sample, size_t size, uint32_t *number) {
+	const uint8_t *bytes = sample;
+	memcpy(number, bytes, sizeof(*number));
+	for (size_t i = sizeof(*number); i < size; i++) {
+		if (bytes[i] != (uint8_t)*number) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Next NMEA sentence: GGA with the sentence number as altitude.
+ */
+static void next_sentence() {
+	char body[80];
+	uint32_t number = ++sim_uart.number;
+	snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.00,4647.0000,N,07113.0000,W,1,08,0.9,%lu.0,M,0.0,M,,",
+			(number / 3600) % 24, (number / 60) % 60, number % 60, (unsigned long)number);
+	uint8_t checksum = 0;
+	for (char *c = body; *c != 0; c++) {
+		checksum ^= *c;
+	}
+	sim_uart.length = snprintf(sim_uart.sentence, sizeof(sim_uart.sentence), "$%s*%02X\r\n", body, checksum);
+	sim_uart.index = 0;
+}
+
+/**
+ * USART1 interrupt: one byte received.
+ */
+static void usart1_interrupt() {
+	uint8_t byte = sim_uart.sentence[sim_uart.index];
+	if (sim_uart.data == NULL) {
+		sim.rx_not_armed++; // Overrun, the byte is lost
+	} else {
+		if (byte == '$') {
+			sim_uart.start_us[sim_uart.number % SIM_SENTENCES] = sim_interrupt_us;
+		}
+		*sim_uart.data = byte;
+		sim_uart.data = NULL;
+		sim.bytes++;
+		L76LM33_RxCallback(&sim_huart1);
+	}
+	if (++sim_uart.index == sim_uart.length) {
+		next_sentence();
+	}
+}
+
+/**
+ * SPI2 DMA interrupt: a few bytes transferred, completion at the end.
+ */
+static void spi2_interrupt() {
+	if (!sim_spi.active || sim_spi.hang) {
+		return;
+	}
+
+	uint16_t count = 1 + rand_r(&sim_irq_seed) % 4;
+	for (; count > 0 && sim_spi.done < sim_spi.size; count--, sim_spi.done++) {
+		if (sim_spi.rx != NULL) {
+			uint8_t index = sim_spi.reg - BMP280_REG_PRESS_MSB + sim_spi.done;
+			sim_spi.rx[sim_spi.done] = sim_spi.selected && index < sizeof(sim_spi.burst) ? sim_spi.burst[index] : 0xFF;
+		}
+	}
+	if (sim_spi.done == sim_spi.size) {
+		sim_spi.active = 0;
+		SPIBUS_CpltCallback(&sim_hspi2);
+	}
+}
+
+/**
+ * Sample bus interrupt: read the topic of the main loop, publish another one.
+ */
+static void bus_interrupt() {
+	static uint32_t baro_count = 0;
+	static uint32_t baro_last = 0;
+	static uint32_t altitude_number = 0;
+	Barometer barometer;
+
+	int8_t status = BUS_Read(BUS_TOPIC_BARO, &barometer, &baro_count);
+	if (status == 0) {
+		uint32_t number;
+		if (check_sample(&barometer, sizeof(barometer), &number) != 0) {
+			sim.torn_reads++;
+		} else if (number < baro_last) {
+			sim.count_back++;
+		}
+		baro_last = number;
+		sim.baro_read++;
+	} else if (status == -2) {
+		sim.baro_busy++;
+	}
+
+	if (rand_r(&sim_irq_seed) % 4 == 0) {
+		AltitudeFusion altitude;
+		fill_sample(&altitude, sizeof(altitude), ++altitude_number);
+		BUS_Publish(BUS_TOPIC_ALTITUDE, &altitude);
+		sim.altitude_published++;
+	}
+}
+
+/**
+ * Arm the timer of the next interrupt.
+ */
+static void next_interrupt() {
+	struct itimerspec delay = { 0 };
+	delay.it_value.tv_nsec = SIM_INTERRUPT_MIN_NS + rand_r(&sim_irq_seed) % (SIM_INTERRUPT_MAX_NS - SIM_INTERRUPT_MIN_NS);
+	timer_settime(sim_timer, 0, &delay, NULL);
+}
+
+/**
+ * Peripheral interrupts (SIGUSR1), delayed while masked.
+ */
+static void interrupt_handler(int signal) {
+	next_interrupt();
+	if (sim_irq_disabled) {
+		sim.interrupts_delayed++; // Delivered by the next timer expiry
+		return;
+	}
+	sim_interrupt_us = now_us();
+	sim_in_interrupt = 1;
+	sim.interrupts++;
+
+	switch (rand_r(&sim_irq_seed) % 4) {
+	case 0:
+	case 1: usart1_interrupt(); break;
+	case 2: spi2_interrupt(); break;
+	default: bus_interrupt(); break;
+	}
+	if (rand_r(&sim_irq_seed) % 16 == 0) {
+		sim_spi.sample++; // BMP280 conversion
+	}
+
+	// Tail chained after this handler (SIGUSR2 blocked meanwhile)
+	if ((sim_scb.ICSR & SCB_ICSR_PENDSVSET_Msk) || sim_pendsv_pending) {
+		sim_scb.ICSR = 0;
+		sim_pendsv_pending = 0;
+		raise(SIGUSR2);
+	}
+	sim_in_interrupt = 0;
+}
+
+/**
+ * PendSV (SIGUSR2): deferred work, preempted by peripheral interrupts.
+ */
+static void pendsv_handler(int signal) {
+	if (sim_irq_disabled) {
+		sim_pendsv_pending = 1; // Raised again by the next interrupt
+		return;
+	}
+	sim.pendsv++;
+	DEFERRED_Run();
+}
+
+/**
+ * Main loop: parse sentences, publish and read the bus, read the BMP280.
+ */
+static void main_loop(uint32_t duration_s) {
+	L76LM33 gnss = { 0 };
+	uint32_t last_sentence = 0;
+	uint32_t baro_number = 0;
+	uint32_t altitude_count = 0;
+	uint32_t altitude_last = 0;
+
+	while (now_us() < (uint64_t)duration_s * 1000000) {
+		// GNSS sentences queued by PendSV
+		while (L76_NMEA_Head != L76_NMEA_Tail) {
+			int8_t status = L76LM33_Read(&gnss);
+			uint32_t number = (uint32_t)gnss.altitude_m;
+			if (status != 0 || number <= last_sentence) {
+				if (status != 0) {
+					sim.bad_sentences++;
+				} else {
+					sim.out_of_order++;
+				}
+				continue;
+			}
+			sim.sentences_skipped += number - last_sentence - 1;
+			if (gnss.timestamp_us != sim_uart.start_us[number % SIM_SENTENCES]) {
+				sim.bad_stamps++;
+			}
+			last_sentence = number;
+			sim.sentences_parsed++;
+		}
+
+		// Topic read by the bus interrupt
+		Barometer barometer;
+		fill_sample(&barometer, sizeof(barometer), ++baro_number);
+		BUS_Publish(BUS_TOPIC_BARO, &barometer);
+		sim.baro_published++;
+
+		// Topic published by the bus interrupt, read often to be preempted while reading
+		for (uint16_t i = 0; i < SIM_BUS_READS; i++) {
+			AltitudeFusion altitude;
+			uint32_t number;
+			uint32_t count = altitude_count;
+			if (BUS_Read(BUS_TOPIC_ALTITUDE, &altitude, &altitude_count) == 0) {
+				if (check_sample(&altitude, sizeof(altitude), &number) != 0) {
+					sim.torn_reads++;
+				} else if (number < altitude_last || altitude_count < count) {
+					sim.count_back++;
+				}
+				altitude_last = number;
+				sim.altitude_read++;
+			}
+			if (BUS_ReadHistory(BUS_TOPIC_ALTITUDE, 1 + i % (BUS_ALTITUDE_HISTORY - 1), &altitude) == 0
+					&& check_sample(&altitude, sizeof(altitude), &number) != 0) {
+				sim.torn_reads++;
+			}
+		}
+
+		// BMP280 burst read (local buffer), one burst of the register file
+		uint8_t data[6];
+		sim.bmp_reads++;
+		if (BMP280_Read(BMP280_REG_PRESS_MSB, data, sizeof(data)) == 0) {
+			for (uint8_t i = 0; i < sizeof(data); i++) {
+				if (data[i] != (uint8_t)(data[0] + i * 31)) {
+					sim.bad_bursts++;
+					break;
+				}
+			}
+		} else {
+			sim.bmp_errors++;
+		}
+		if (sim_spi.active) {
+			sim.dma_after_return++; // Would write a dead stack buffer
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	uint32_t duration_s = 2;
+	unsigned int seed = (unsigned int)time(NULL);
+	int option;
+
+	while ((option = getopt(argc, argv, "t:s:")) != -1) {
+		switch (option) {
+		case 't': duration_s = strtoul(optarg, NULL, 0); break;
+		case 's': seed = strtoul(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "Usage: %s [-t seconds] [-s seed]\n", argv[0]);
+			return 2;
+		}
+	}
+	sim_main_seed = seed;
+	sim_irq_seed = seed * 31 + 1;
+	clock_gettime(CLOCK_MONOTONIC, &sim_start);
+
+	// SIGUSR1 preempts PendSV, PendSV waits for SIGUSR1 to end
+	struct sigaction action = { 0 };
+	action.sa_handler = interrupt_handler;
+	sigemptyset(&action.sa_mask);
+	sigaddset(&action.sa_mask, SIGUSR2);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGUSR1, &action, NULL);
+	action.sa_handler = pendsv_handler;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGUSR2, &action, NULL);
+
+	// Firmware initialization, before interrupts
+	next_sentence();
+	if (L76LM33_Init(&sim_huart1) != 0 || SPIBUS_Init(&sim_hspi2) != 0) {
+		fprintf(stderr, "Initialization failed\n");
+		return 1;
+	}
+	SPIBUS_SetChipSelect(SPIBUS_DEVICE_BMP280, BMP_CS_GPIO_Port, BMP_CS_Pin);
+
+	prctl(PR_SET_TIMERSLACK, 1); // Interrupts at the requested delays
+	struct sigevent event = { 0 };
+	event.sigev_notify = SIGEV_SIGNAL;
+	event.sigev_signo = SIGUSR1;
+	if (timer_create(CLOCK_MONOTONIC, &event, &sim_timer) != 0) {
+		perror("timer_create");
+		return 1;
+	}
+	next_interrupt();
+	main_loop(duration_s);
+	timer_delete(sim_timer);
+
+	printf("Seed %u, %lu interrupts (%lu delayed by masked sections), %lu PendSV\n", seed,
+			(unsigned long)sim.interrupts, (unsigned long)sim.interrupts_delayed, (unsigned long)sim.pendsv);
+	printf("GNSS: %lu bytes, %lu sentences parsed, %lu skipped (queue full), %lu bytes dropped (buffer full), %lu bytes while not armed\n",
+			(unsigned long)sim.bytes, (unsigned long)sim.sentences_parsed, (unsigned long)sim.sentences_skipped,
+			(unsigned long)L76_BytesDropped, (unsigned long)sim.rx_not_armed);
+	printf("Bus: %lu baro published, %lu read by the interrupt (%lu writer busy), %lu altitude published, %lu read\n",
+			(unsigned long)sim.baro_published, (unsigned long)sim.baro_read, (unsigned long)sim.baro_busy,
+			(unsigned long)sim.altitude_published, (unsigned long)sim.altitude_read);
+	printf("BMP280: %lu reads, %lu errors (%lu hung transfers, %lu bus resets)\n", (unsigned long)sim.bmp_reads,
+			(unsigned long)sim.bmp_errors, (unsigned long)sim.bmp_hangs, (unsigned long)SPIBUS_GetStats()->resets);
+
+	uint32_t violations = sim.bad_sentences + sim.out_of_order + sim.bad_stamps + sim.torn_reads + sim.count_back
+			+ sim.bad_bursts + sim.dma_after_return + sim.dma_overlaps + sim.rx_not_armed;
+	if (violations != 0) {
+		printf("FAIL: %lu bad sentences, %lu out of order, %lu bad stamps, %lu torn reads, %lu counts back, "
+				"%lu bad bursts, %lu DMA after return, %lu DMA overlaps, %lu bytes while not armed\n",
+				(unsigned long)sim.bad_sentences, (unsigned long)sim.out_of_order, (unsigned long)sim.bad_stamps,
+				(unsigned long)sim.torn_reads, (unsigned long)sim.count_back, (unsigned long)sim.bad_bursts,
+				(unsigned long)sim.dma_after_return, (unsigned long)sim.dma_overlaps, (unsigned long)sim.rx_not_armed);
+		return 1;
+	}
+	if (sim.sentences_parsed == 0 || sim.baro_read == 0 || sim.altitude_read == 0 || sim.bmp_reads == sim.bmp_errors) {
+		printf("FAIL: a path was not exercised\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,323 @@
+/*
+ * log_decoder.c
+ *
+ * Host decoder of the tokenized logs (Core/Inc/GAUL/Log.h). Reads the raw SWO
+ * stream (ITM packets, e.g. captured by OpenOCD "tpiu config ... output swo.bin"
+ * or the STM32CubeProgrammer SWV file), formats the log frames of stimulus
+ * port 1 with the format strings of the firmware ELF (.log_fmt section), and
+ * prints the printf text of stimulus port 0 as is.
+ *
+ * Build: gcc -O2 -Wall -o log_decoder log_decoder.c
+ * Usage: ./log_decoder firmware.elf [swo.bin]   (stdin if no SWO file)
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_ITM_PORT 1
+#define LOG_FRAME_MARKER 0xA5000000u
+#define LOG_MARKER_MASK 0xFF000000u
+#define LOG_TOKEN_MASK 0x00FFFFFFu
+#define LOG_MAX_STRING_LENGTH 128
+
+// Format strings section of the ELF
+static char *formats = NULL;
+static uint32_t formats_address = 0;
+static uint32_t formats_size = 0;
+
+// Words of the current frame (port 1)
+#define MAX_FRAME_WORDS 256
+static uint32_t frame[MAX_FRAME_WORDS];
+static uint32_t frame_length = 0;
+
+/**
+ * Load the .log_fmt section of a 32-bit ELF file.
+ *
+ * @return 0 OK, -1 ERROR
+ */
+static int load_formats(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	Elf32_Ehdr header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.e_ident, ELFMAG, SELFMAG) != 0
+			|| header.e_ident[EI_CLASS] != ELFCLASS32) {
+		fprintf(stderr, "%s: not a 32-bit ELF file\n", path);
+		fclose(file);
+		return -1;
+	}
+
+	Elf32_Shdr *sections = calloc(header.e_shnum, sizeof(Elf32_Shdr));
+	if (sections == NULL || header.e_shstrndx >= header.e_shnum) {
+		fprintf(stderr, "%s: invalid section headers\n", path);
+		free(sections);
+		fclose(file);
+		return -1;
+	}
+	fseek(file, header.e_shoff, SEEK_SET);
+	if (fread(sections, sizeof(Elf32_Shdr), header.e_shnum, file) != header.e_shnum) {
+		fprintf(stderr, "%s: cannot read section headers\n", path);
+		free(sections);
+		fclose(file);
+		return -1;
+	}
+
+	Elf32_Shdr *names = &sections[header.e_shstrndx];
+	char *section_names = malloc(names->sh_size + 1);
+	if (section_names == NULL) {
+		fprintf(stderr, "%s: invalid section names\n", path);
+		free(sections);
+		fclose(file);
+		return -1;
+	}
+	fseek(file, names->sh_offset, SEEK_SET);
+	if (fread(section_names, 1, names->sh_size, file) != names->sh_size) {
+		fprintf(stderr, "%s: cannot read section names\n", path);
+		free(section_names);
+		free(sections);
+		fclose(file);
+		return -1;
+	}
+	section_names[names->sh_size] = '\0';
+
+	int status = -1;
+	for (int i = 0; i < header.e_shnum; i++) {
+		if (sections[i].sh_name < names->sh_size && strcmp(&section_names[sections[i].sh_name], ".log_fmt") == 0) {
+			formats_address = sections[i].sh_addr;
+			formats_size = sections[i].sh_size;
+			formats = malloc(formats_size + 1);
+			if (formats == NULL) {
+				break;
+			}
+			fseek(file, sections[i].sh_offset, SEEK_SET);
+			if (fread(formats, 1, formats_size, file) == formats_size) {
+				formats[formats_size] = '\0';
+				status = 0;
+			}
+			break;
+		}
+	}
+	if (status != 0) {
+		fprintf(stderr, "%s: no .log_fmt section\n", path);
+	}
+
+	free(section_names);
+	free(sections);
+	fclose(file);
+	return status;
+}
+
+/**
+ * Print a frame with its format string. Conversions of the format select how
+ * many words each argument takes (see LogType in Log.h).
+ *
+ * @return Number of words used (the whole frame must be available)
+ *         0 if more words are needed, -1 if the frame is invalid
+ */
+static int print_frame(const uint32_t *words, uint32_t count) {
+	uint32_t token = words[0] & LOG_TOKEN_MASK;
+	if (token < formats_address || token - formats_address >= formats_size) {
+		return -1; // Unknown format
+	}
+
+	const char *format = &formats[token - formats_address];
+	uint32_t used = 1;
+	char line[1024];
+	size_t length = 0;
+
+	for (const char *c = format; *c != '\0' && length < sizeof(line) - 1; c++) {
+		if (*c != '%') {
+			line[length++] = *c;
+			continue;
+		}
+		if (c[1] == '%') {
+			line[length++] = '%';
+			c++;
+			continue;
+		}
+
+		// Conversion specification: flags, width, precision, length, conversion
+		char spec[32];
+		size_t spec_length = 0;
+		int long_count = 0;
+		spec[spec_length++] = *c++;
+		while (*c != '\0' && strchr("-+ #0123456789.", *c) != NULL && spec_length < sizeof(spec) - 4) {
+			spec[spec_length++] = *c++;
+		}
+		while (*c == 'l' || *c == 'h' || *c == 'z' || *c == 't') {
+			long_count += *c == 'l';
+			c++;
+		}
+		char conversion = *c;
+		if (conversion == '\0') {
+			break;
+		}
+
+		int written = 0;
+		size_t space = sizeof(line) - length;
+		if (strchr("dicuxXo", conversion) != NULL) {
+			if (long_count >= 2) {
+				if (used + 2 > count) {
+					return 0;
+				}
+				uint64_t value = words[used] | ((uint64_t)words[used + 1] << 32);
+				used += 2;
+				spec[spec_length++] = 'l';
+				spec[spec_length++] = 'l';
+				spec[spec_length++] = conversion;
+				spec[spec_length] = '\0';
+				written = snprintf(&line[length], space, spec, value);
+			} else {
+				if (used + 1 > count) {
+					return 0;
+				}
+				uint32_t value = words[used++];
+				spec[spec_length++] = conversion;
+				spec[spec_length] = '\0';
+				if (conversion == 'd' || conversion == 'i') {
+					written = snprintf(&line[length], space, spec, (int32_t)value);
+				} else if (conversion == 'c') {
+					written = snprintf(&line[length], space, spec, (int)(value & 0xFF)); // Promoted to int
+				} else {
+					written = snprintf(&line[length], space, spec, value);
+				}
+			}
+		} else if (strchr("feEgGaA", conversion) != NULL) {
+			if (used + 1 > count) {
+				return 0;
+			}
+			float value;
+			memcpy(&value, &words[used++], sizeof(value));
+			spec[spec_length++] = conversion;
+			spec[spec_length] = '\0';
+			written = snprintf(&line[length], space, spec, (double)value);
+		} else if (conversion == 's') {
+			if (used + 1 > count) {
+				return 0;
+			}
+			uint32_t string_length = words[used];
+			if (string_length > LOG_MAX_STRING_LENGTH) {
+				return -1; // Invalid string
+			}
+			uint32_t string_words = (string_length + 3) / 4;
+			if (used + 1 + string_words > count) {
+				return 0;
+			}
+			char string[LOG_MAX_STRING_LENGTH + 4] = { 0 };
+			memcpy(string, &words[used + 1], string_length);
+			used += 1 + string_words;
+			// Strings with their own line ending (NMEA sentences)
+			while (string_length > 0 && (string[string_length - 1] == '\n' || string[string_length - 1] == '\r')) {
+				string[--string_length] = '\0';
+			}
+			spec[spec_length++] = 's';
+			spec[spec_length] = '\0';
+			written = snprintf(&line[length], space, spec, string);
+		} else {
+			return -1; // Unsupported conversion
+		}
+
+		if (written > 0) {
+			length += (size_t)written < space ? (size_t)written : space - 1;
+		}
+	}
+
+	// One message per line
+	while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+		length--;
+	}
+	line[length] = '\0';
+	printf("%s\n", line);
+
+	return used;
+}
+
+/**
+ * Add a word of stimulus port 1, print the complete frames.
+ */
+static void add_word(uint32_t word) {
+	if (frame_length == 0 && (word & LOG_MARKER_MASK) != LOG_FRAME_MARKER) {
+		return; // Resynchronize on the next frame header
+	}
+	if (frame_length >= MAX_FRAME_WORDS) {
+		frame_length = 0; // Lost
+		return;
+	}
+	frame[frame_length++] = word;
+
+	int used = print_frame(frame, frame_length);
+	if (used != 0) {
+		// Frame printed, or invalid: drop it
+		frame_length = 0;
+	}
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s firmware.elf [swo.bin]\n", argv[0]);
+		return 1;
+	}
+	if (load_formats(argv[1]) != 0) {
+		return 1;
+	}
+
+	FILE *input = stdin;
+	if (argc > 2 && (input = fopen(argv[2], "rb")) == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	// ITM packets: header byte, then 1, 2 or 4 payload bytes
+	int header;
+	while ((header = fgetc(input)) != EOF) {
+		if (header == 0x00 || header == 0x80 || header == 0x70) {
+			continue; // Synchronization or overflow
+		}
+
+		uint8_t size_bits = header & 0x03;
+		if (size_bits == 0) {
+			// Timestamp or extension packet: skip continuation bytes
+			if (header & 0x80) {
+				int c;
+				while ((c = fgetc(input)) != EOF && (c & 0x80)) {
+				}
+			}
+			continue;
+		}
+
+		uint32_t size = size_bits == 3 ? 4 : size_bits;
+		uint32_t payload = 0;
+		for (uint32_t i = 0; i < size; i++) {
+			int c = fgetc(input);
+			if (c == EOF) {
+				return 0;
+			}
+			payload |= (uint32_t)c << (8 * i);
+		}
+
+		if (header & 0x04) {
+			continue; // Hardware source packet (DWT)
+		}
+
+		uint8_t port = header >> 3;
+		if (port == 0) {
+			// printf text, one character per write
+			for (uint32_t i = 0; i < size; i++) {
+				putchar((payload >> (8 * i)) & 0xFF);
+			}
+		} else if (port == LOG_ITM_PORT && size == 4) {
+			add_word(payload);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,658 @@
+/*
+ * norflash_emulator.c
+ *
+ * Host tests of the NOR flash driver (Core/Inc/GAUL_Drivers/NORFlash.h) and of
+ * the SPI2 bus manager transaction queue (Core/Inc/GAUL/SPIBus.h), compiled
+ * with the BMP280 driver against an emulated SPI2 bus (HAL stub in
+ * Tools/hal_stub):
+ * - JEDEC 25-series NOR flash: status, write enable latch, page program (bits
+ *   1 to 0 only, wrap in the page), sector erase, busy times, commands ignored
+ *   while busy
+ * - BMP280 chip select, the barometer is read every millisecond while the NOR
+ *   flash writes pages by DMA
+ * - DMA completion delivered as an interrupt after the transfer time (delayed
+ *   while interrupts are masked), DMA errors and stuck transfers
+ * Rule violations (both chip selects low, command while busy, program without
+ * write enable, 0 to 1 bit programmed, DMA started during a DMA) fail the
+ * tests. Virtual time, SPI2 at 2.25 MHz.
+ *
+ * Build: gcc -O2 -Wall -Ihal_stub -I../Core/Inc -o norflash_emulator norflash_emulator.c ../Core/Src/GAUL_Drivers/NORFlash.c ../Core/Src/GAUL/SPIBus.c ../Core/Src/GAUL_Drivers/BMP280.c -lm
+ * Usage: ./norflash_emulator
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stm32f1xx_hal.h"
+#include "main.h" // for NOR_CS_Pin, BMP_CS_Pin
+
+#include "GAUL/SPIBus.h"
+#include "GAUL_Drivers/NORFlash.h"
+#include "GAUL_Drivers/BMP280.h"
+
+#define SIM_MANUFACTURER_ID 0xEF	// Winbond
+#define SIM_MEMORY_TYPE 0x40
+#define SIM_CAPACITY_ID 0x16		// 4 MB
+#define SIM_SIZE (1UL << SIM_CAPACITY_ID)
+
+#define SIM_BYTE_US 4				// 8 bits at 2.25 MHz (3.6 us)
+#define SIM_PROGRAM_US 700			// Typical page program (W25Q128JV)
+#define SIM_ERASE_US 45000			// Typical sector erase
+
+GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+SPI_TypeDef sim_spi2;
+DMA_HandleTypeDef sim_dma_tx, sim_dma_rx;
+SPI_HandleTypeDef hspi2 = { SPI2, &sim_dma_tx, &sim_dma_rx };
+volatile int sim_irq_disabled = 0;
+
+// Virtual time
+static uint64_t now_us = 0;
+
+// Emulated NOR flash
+static struct {
+	uint8_t *memory;
+	uint8_t present;
+	uint8_t selected;
+	uint8_t command;
+	uint8_t ignored;		// Command ignored (busy or write disabled)
+	uint32_t index;			// Bytes since CS low
+	uint32_t address;
+	uint8_t wel;
+	uint64_t busy_until_us;
+	uint32_t erase_us;		// Busy time of the next erases
+	uint32_t programmed;	// Bytes of the page program in progress
+} nor;
+
+static uint8_t bmp_selected = 0;
+
+// DMA transfer in progress
+#define DMA_IDLE 0
+#define DMA_TX 1
+#define DMA_RX 2
+static uint8_t dma_pending = DMA_IDLE;
+static uint8_t dma_failed = 0;
+static uint64_t dma_done_us = 0;
+
+// Fault injection: refuse the next DMA start, fail or hang the next DMA transfer
+// of at least fail_dma_size bytes
+#define SIM_DMA_ERROR 1
+#define SIM_DMA_HANG 2
+static uint8_t fail_next_spi = 0;
+static uint8_t fail_next_dma = 0;
+static uint16_t fail_dma_size = 0;
+
+static struct {
+	uint32_t bus_conflicts;		// Both chip selects low
+	uint32_t busy_commands;		// Commands other than read status while busy
+	uint32_t missing_wren;		// Program or erase without write enable
+	uint32_t bit_sets;			// Program of a 0 bit to 1
+	uint32_t dma_overlaps;		// DMA started during a DMA transfer
+	uint32_t interrupts;		// DMA interrupts delivered
+	uint32_t program_starts;	// Page programs started
+	uint64_t first_program_us;	// Start of the first page program after an erase
+} sim;
+
+static void advance(uint32_t us);
+
+static uint8_t nor_busy() {
+	return now_us < nor.busy_until_us;
+}
+
+/**
+ * One byte exchanged with the NOR flash (CS low).
+ */
+static uint8_t nor_byte(uint8_t mosi) {
+	uint8_t miso = 0xFF;
+	uint32_t index = nor.index++;
+
+	if (index == 0) {
+		nor.command = mosi;
+		nor.ignored = 0;
+		nor.address = 0;
+		nor.programmed = 0;
+		if (nor_busy() && mosi == NORFLASH_CMD_RELEASE_POWER_DOWN) {
+			nor.ignored = 1; // Ignored while busy, harmless
+		} else if (nor_busy() && mosi != NORFLASH_CMD_READ_STATUS) {
+			sim.busy_commands++;
+			nor.ignored = 1;
+		} else if ((mosi == NORFLASH_CMD_PAGE_PROGRAM || mosi == NORFLASH_CMD_SECTOR_ERASE) && !nor.wel) {
+			sim.missing_wren++;
+			nor.ignored = 1;
+		}
+		return miso;
+	}
+	if (nor.ignored) {
+		return miso;
+	}
+
+	switch (nor.command) {
+	case NORFLASH_CMD_READ_STATUS:
+		miso = (nor_busy() ? NORFLASH_STATUS_BUSY : 0) | (nor.wel ? NORFLASH_STATUS_WEL : 0);
+		break;
+	case NORFLASH_CMD_JEDEC_ID: {
+		static const uint8_t id[3] = { SIM_MANUFACTURER_ID, SIM_MEMORY_TYPE, SIM_CAPACITY_ID };
+		miso = index <= 3 ? id[index - 1] : 0xFF;
+		break;
+	}
+	case NORFLASH_CMD_READ_DATA:
+	case NORFLASH_CMD_PAGE_PROGRAM:
+	case NORFLASH_CMD_SECTOR_ERASE:
+		if (index <= 3) {
+			nor.address = (nor.address << 8) | mosi;
+		} else if (nor.command == NORFLASH_CMD_READ_DATA) {
+			miso = nor.memory[(nor.address + index - 4) % SIM_SIZE];
+		} else if (nor.command == NORFLASH_CMD_PAGE_PROGRAM) {
+			// Wraps in the page, only 1 to 0
+			uint32_t address = (nor.address & ~0xFFUL) | ((nor.address + index - 4) & 0xFF);
+			address %= SIM_SIZE;
+			if (mosi & ~nor.memory[address]) {
+				sim.bit_sets++;
+			}
+			nor.memory[address] &= mosi;
+			nor.programmed++;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return miso;
+}
+
+/**
+ * CS high: commands take effect.
+ */
+static void nor_deselect() {
+	if (nor.ignored || nor.index == 0) {
+		return;
+	}
+
+	if (nor.command == NORFLASH_CMD_WRITE_ENABLE) {
+		nor.wel = 1;
+	} else if (nor.command == NORFLASH_CMD_PAGE_PROGRAM && nor.index >= 4) {
+		nor.wel = 0;
+		nor.busy_until_us = now_us + SIM_PROGRAM_US;
+		if (sim.program_starts++ == 0) {
+			sim.first_program_us = now_us;
+		}
+	} else if (nor.command == NORFLASH_CMD_SECTOR_ERASE && nor.index == 4) {
+		nor.wel = 0;
+		memset(&nor.memory[nor.address & ~(NORFLASH_SECTOR_SIZE - 1UL) % SIM_SIZE], 0xFF, NORFLASH_SECTOR_SIZE);
+		nor.busy_until_us = now_us + nor.erase_us;
+	}
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+	uint8_t selected = PinState == GPIO_PIN_RESET;
+
+	if (GPIOx == NOR_CS_GPIO_Port && GPIO_Pin == NOR_CS_Pin && nor.present) {
+		if (selected && !nor.selected) {
+			nor.index = 0;
+		} else if (!selected && nor.selected) {
+			nor_deselect();
+		}
+		nor.selected = selected;
+	} else if (GPIOx == BMP_CS_GPIO_Port && GPIO_Pin == BMP_CS_Pin) {
+		bmp_selected = selected;
+	}
+
+	if (nor.selected && bmp_selected) {
+		sim.bus_conflicts++;
+	}
+}
+
+/**
+ * One byte on SPI2.
+ */
+static uint8_t spi_byte(uint8_t mosi) {
+	if (nor.selected && bmp_selected) {
+		sim.bus_conflicts++;
+	}
+	if (nor.selected) {
+		return nor_byte(mosi);
+	}
+	return bmp_selected ? 0x58 : 0xFF; // BMP280 answers its ID to any register
+}
+
+/**
+ * Start a DMA transfer: bytes exchanged now, completion interrupt after the
+ * transfer time.
+ */
+static HAL_StatusTypeDef spi_dma(const uint8_t *tx, uint8_t *rx, uint16_t size, uint8_t direction) {
+	if (dma_pending) {
+		sim.dma_overlaps++;
+		return HAL_BUSY;
+	}
+	if (fail_next_spi) {
+		fail_next_spi = 0;
+		return HAL_ERROR;
+	}
+
+	for (uint16_t i = 0; i < size; i++) {
+		uint8_t miso = spi_byte(tx[i]);
+		if (rx != NULL) {
+			rx[i] = miso;
+		}
+	}
+	uint8_t fault = size >= fail_dma_size ? fail_next_dma : 0;
+	dma_pending = direction;
+	dma_failed = fault == SIM_DMA_ERROR;
+	dma_done_us = fault == SIM_DMA_HANG ? UINT64_MAX : now_us + (uint64_t)size * SIM_BYTE_US;
+	if (fault) {
+		fail_next_dma = 0;
+		fail_dma_size = 0;
+	}
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
+	return spi_dma(pData, NULL, Size, DMA_TX);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
+	return spi_dma(pData, pData, Size, DMA_RX); // Full duplex, the buffer is sent
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi) {
+	dma_pending = DMA_IDLE;
+	return HAL_OK;
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+	SPIBUS_CpltCallback(hspi);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+	SPIBUS_CpltCallback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+	SPIBUS_ErrorCallback(hspi);
+}
+
+/**
+ * Advance the virtual time, deliver the DMA interrupt (unless masked).
+ */
+static void advance(uint32_t us) {
+	now_us += us;
+	if (dma_pending && !sim_irq_disabled && now_us >= dma_done_us) {
+		uint8_t direction = dma_pending;
+		dma_pending = DMA_IDLE;
+		sim.interrupts++;
+		if (dma_failed) {
+			HAL_SPI_ErrorCallback(&hspi2);
+		} else if (direction == DMA_TX) {
+			HAL_SPI_TxCpltCallback(&hspi2);
+		} else {
+			HAL_SPI_RxCpltCallback(&hspi2);
+		}
+	}
+}
+
+uint32_t HAL_GetTick(void) {
+	advance(1); // Busy loops progress
+	return now_us / 1000;
+}
+
+void HAL_Delay(uint32_t Delay) {
+	advance(Delay * 1000);
+}
+
+uint64_t CLOCK_GetTime_us() {
+	advance(1); // Busy loops progress (SPIBUS_Transfer() timeout)
+	return now_us;
+}
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		printf("FAIL %s:%d: %s\n", __func__, __LINE__, #condition); \
+		failures++; \
+	} \
+} while (0)
+
+static void reset_device(uint8_t present) {
+	memset(nor.memory, 0xA5, SIM_SIZE); // Not erased
+	nor.present = present;
+	nor.selected = 0;
+	nor.wel = 0;
+	nor.busy_until_us = 0;
+	nor.erase_us = SIM_ERASE_US;
+	dma_pending = DMA_IDLE;
+	memset(&sim, 0, sizeof(sim));
+}
+
+static void check_rules() {
+	CHECK(sim.bus_conflicts == 0);
+	CHECK(sim.busy_commands == 0);
+	CHECK(sim.missing_wren == 0);
+	CHECK(sim.bit_sets == 0);
+	CHECK(sim.dma_overlaps == 0);
+	CHECK(!nor.selected && !bmp_selected);
+	CHECK(SPIBUS_GetPending() == 0);
+}
+
+static void fill_page(uint8_t *page, uint32_t address) {
+	for (uint16_t i = 0; i < NORFLASH_PAGE_SIZE; i++) {
+		page[i] = (uint8_t)((address + i) * 7 + (address >> 8));
+	}
+}
+
+/**
+ * Main loop: NOR flash updates every poll_us, barometer read every 1 ms.
+ * Pages are queued as soon as a buffer is free.
+ *
+ * @return Virtual time of the write (us)
+ */
+static uint64_t write_log(uint32_t start, uint32_t bytes, uint32_t poll_us, uint32_t *bmp_errors) {
+	uint64_t start_us = now_us;
+	uint64_t next_bmp_us = now_us;
+	uint64_t next_poll_us = now_us;
+	uint32_t address = start;
+	uint8_t page[NORFLASH_PAGE_SIZE];
+
+	while (address < start + bytes || NORFLASH_GetPending() > 0) {
+		// Erase a sector when reaching it, pages are queued behind the erase
+		while (address < start + bytes && NORFLASH_GetFreePages() > 0) {
+			if (address % NORFLASH_SECTOR_SIZE == 0) {
+				if (NORFLASH_EraseSector(address) != 0) {
+					break;
+				}
+			}
+			if (NORFLASH_GetFreePages() == 0) {
+				break;
+			}
+			fill_page(page, address);
+			CHECK(NORFLASH_ProgramPage(address, page, NORFLASH_PAGE_SIZE) == 0);
+			address += NORFLASH_PAGE_SIZE;
+		}
+
+		if (now_us >= next_bmp_us) {
+			uint8_t data[6];
+			*bmp_errors += BMP280_Read(BMP280_REG_PRESS_MSB, data, 6) != 0;
+			next_bmp_us += 1000;
+		}
+		if (now_us >= next_poll_us) {
+			NORFLASH_Update();
+			next_poll_us += poll_us;
+		}
+		advance(10);
+	}
+
+	return now_us - start_us;
+}
+
+static int8_t verify_log(uint32_t start, uint32_t bytes) {
+	uint8_t page[NORFLASH_PAGE_SIZE];
+	uint8_t read[NORFLASH_PAGE_SIZE];
+	for (uint32_t address = start; address < start + bytes; address += NORFLASH_PAGE_SIZE) {
+		fill_page(page, address);
+		if (NORFLASH_Read(address, read, NORFLASH_PAGE_SIZE) != 0 || memcmp(page, read, NORFLASH_PAGE_SIZE) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void test_init() {
+	reset_device(0);
+	CHECK(NORFLASH_Init() == -1); // No device
+	CHECK(NORFLASH_EraseSector(0) == -2);
+
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	CHECK(NORFLASH_GetInfo()->manufacturer_id == SIM_MANUFACTURER_ID);
+	CHECK(NORFLASH_GetInfo()->size == SIM_SIZE);
+	check_rules();
+}
+
+static void test_arguments() {
+	uint8_t page[NORFLASH_PAGE_SIZE] = { 0 };
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+
+	CHECK(NORFLASH_EraseSector(100) == -2);				// Not aligned
+	CHECK(NORFLASH_EraseSector(SIM_SIZE) == -2);		// Out of the device
+	CHECK(NORFLASH_ProgramPage(200, page, 100) == -2);	// Crosses a page
+	CHECK(NORFLASH_ProgramPage(0, page, 0) == -2);
+	CHECK(NORFLASH_Read(SIM_SIZE - 1, page, 2) == -3);
+
+	// Queue full: page buffers, then operations
+	CHECK(NORFLASH_ProgramPage(0, page, 16) == 0);
+	CHECK(NORFLASH_ProgramPage(256, page, 16) == 0);
+	CHECK(NORFLASH_ProgramPage(512, page, 16) == -1);
+	CHECK(NORFLASH_EraseSector(4096) == 0);
+	CHECK(NORFLASH_EraseSector(8192) == 0);
+	CHECK(NORFLASH_EraseSector(12288) == -1);
+	CHECK(NORFLASH_GetPending() == 4);
+	CHECK(NORFLASH_Flush(1000) == 0);
+	check_rules();
+}
+
+static void test_pipeline() {
+	uint32_t bmp_errors = 0;
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	NORFlashStats before = *NORFLASH_GetStats();
+
+	// 64 KB, erase then program of each sector, NOR flash polled every 100 us
+	uint64_t elapsed_us = write_log(0, 65536, 100, &bmp_errors);
+	const NORFlashStats *stats = NORFLASH_GetStats();
+	CHECK(stats->sectors_erased - before.sectors_erased == 16);
+	CHECK(stats->pages_programmed - before.pages_programmed == 256);
+	CHECK(stats->errors == before.errors);
+	CHECK(bmp_errors == 0);
+	CHECK(verify_log(0, 65536) == 0);
+	check_rules();
+	printf("64 KB, polled every 100 us: %6.1f KB/s, erase max %u us, program max %u us, bus queue max %u\n",
+			65536 / 1.024 / elapsed_us * 1000, stats->erase_max_us, stats->program_max_us,
+			SPIBUS_GetStats()->queue_max);
+
+	// Programs queued behind an erase start right after it
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	uint8_t page[NORFLASH_PAGE_SIZE];
+	fill_page(page, 0);
+	CHECK(NORFLASH_EraseSector(0) == 0);
+	CHECK(NORFLASH_ProgramPage(0, page, NORFLASH_PAGE_SIZE) == 0);
+	uint64_t start_us = now_us;
+	for (int i = 0; i < 100000 && NORFLASH_GetPending() > 0; i++) {
+		NORFLASH_Update();
+		advance(100);
+	}
+	CHECK(NORFLASH_GetPending() == 0);
+	// Erase, one poll period, page DMA (the program starts when CS goes high)
+	CHECK(sim.first_program_us - start_us < SIM_ERASE_US + 100 + (NORFLASH_PAGE_SIZE + 64) * SIM_BYTE_US);
+	check_rules();
+
+	// Recorder task rate (20 ms)
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	elapsed_us = write_log(0, 16384, 20000, &bmp_errors);
+	CHECK(bmp_errors == 0);
+	CHECK(verify_log(0, 16384) == 0);
+	check_rules();
+	printf("16 KB, polled every 20 ms:  %6.1f KB/s\n", 16384 / 1.024 / elapsed_us * 1000);
+}
+
+static void test_errors() {
+	uint8_t page[NORFLASH_PAGE_SIZE];
+	uint8_t data[6];
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	uint32_t errors = NORFLASH_GetStats()->errors;
+
+	// BMP280 DMA refused: chip select raised, queue empty
+	fail_next_spi = 1;
+	CHECK(BMP280_Read(BMP280_REG_PRESS_MSB, data, 6) == -1);
+	CHECK(!bmp_selected);
+	CHECK(SPIBUS_GetPending() == 0);
+
+	// DMA error: page dropped, next operations still run
+	CHECK(NORFLASH_EraseSector(0) == 0);
+	CHECK(NORFLASH_Flush(1000) == 0);
+	fill_page(page, 0);
+	fail_next_dma = SIM_DMA_ERROR;
+	fail_dma_size = NORFLASH_PAGE_SIZE; // The page program transaction, not the status reads
+	CHECK(NORFLASH_ProgramPage(0, page, NORFLASH_PAGE_SIZE) == 0);
+	fill_page(page, 256);
+	CHECK(NORFLASH_ProgramPage(256, page, NORFLASH_PAGE_SIZE) == 0);
+	CHECK(NORFLASH_Flush(1000) == 0);
+	CHECK(NORFLASH_GetStats()->errors == errors + 1);
+	CHECK(verify_log(256, 256) == 0);
+	check_rules();
+
+	// Erase stuck busy: given up after the timeout, the next operation waits for the chip
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	errors = NORFLASH_GetStats()->errors;
+	nor.erase_us = 2 * NORFLASH_ERASE_TIMEOUT_MS * 1000;
+	CHECK(NORFLASH_EraseSector(0) == 0);
+	CHECK(NORFLASH_EraseSector(4096) == 0);
+	CHECK(NORFLASH_Flush(5000) == 0);
+	CHECK(NORFLASH_GetStats()->errors == errors + 2);
+	check_rules();
+
+	// MCU reset during an erase: initialization waits for the chip
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	CHECK(NORFLASH_EraseSector(0) == 0);
+	NORFLASH_Update();
+	CHECK(nor_busy());
+	CHECK(NORFLASH_Init() == 0);
+	CHECK(!nor_busy());
+	check_rules();
+}
+
+static uint8_t callbacks = 0;
+static uint8_t callback_order[4];
+
+static void test_callback(SPIBusTransaction *transaction) {
+	// Chip select already high
+	CHECK(!nor.selected && !bmp_selected);
+	callback_order[callbacks++ % 4] = *(uint8_t *)transaction->context;
+}
+
+static void test_bus() {
+	uint8_t data[6];
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+
+	// Transactions of both devices queued back-to-back, run in order from the DMA interrupt
+	static const uint8_t status_cmd = NORFLASH_CMD_READ_STATUS;
+	static const uint8_t press_reg = BMP280_REG_PRESS_MSB | 0x80;
+	static uint8_t ids[4] = { 0, 1, 2, 3 };
+	uint8_t rx[4][6];
+	SPIBusTransaction transactions[4];
+	for (uint8_t i = 0; i < 4; i++) {
+		SPIBusDevice device = i % 2 ? SPIBUS_DEVICE_NORFLASH : SPIBUS_DEVICE_BMP280;
+		transactions[i] = (SPIBusTransaction){ device, device == SPIBUS_DEVICE_BMP280 ? &press_reg : &status_cmd, 1,
+			rx[i], 6, test_callback, &ids[i], 0 };
+	}
+	callbacks = 0;
+	uint32_t interrupts = sim.interrupts;
+	for (uint8_t i = 0; i < 4; i++) {
+		CHECK(SPIBUS_Submit(&transactions[i]) == 0);
+	}
+	CHECK(SPIBUS_GetPending() == 4);
+	while (SPIBUS_GetPending() > 0) {
+		advance(1);
+	}
+	CHECK(callbacks == 4);
+	for (uint8_t i = 0; i < 4; i++) {
+		CHECK(callback_order[i] == i);
+		CHECK(transactions[i].status == 0);
+	}
+	CHECK(rx[0][0] == 0x58 && rx[1][0] == 0x00);
+	CHECK(sim.interrupts - interrupts == 8); // TX then RX phase of each
+	check_rules();
+
+	// Queue full (the first transaction starts right away, out of the queue), then invalid transactions
+	SPIBusTransaction full[SPIBUS_QUEUE_SIZE + 2];
+	for (uint8_t i = 0; i < SPIBUS_QUEUE_SIZE + 2; i++) {
+		full[i] = (SPIBusTransaction){ SPIBUS_DEVICE_NORFLASH, &status_cmd, 1, NULL, 0, NULL, NULL, 0 };
+	}
+	uint32_t queue_full = SPIBUS_GetStats()->queue_full;
+	for (uint8_t i = 0; i < SPIBUS_QUEUE_SIZE + 1; i++) {
+		CHECK(SPIBUS_Submit(&full[i]) == 0);
+	}
+	CHECK(SPIBUS_Submit(&full[SPIBUS_QUEUE_SIZE + 1]) == -1);
+	CHECK(SPIBUS_GetStats()->queue_full == queue_full + 1);
+	while (SPIBUS_GetPending() > 0) {
+		advance(1);
+	}
+	SPIBusTransaction empty = { SPIBUS_DEVICE_NORFLASH, NULL, 0, NULL, 0, NULL, NULL, 0 };
+	CHECK(SPIBUS_Submit(&empty) == -2);
+	empty = (SPIBusTransaction){ SPIBUS_DEVICE_COUNT, &status_cmd, 1, NULL, 0, NULL, NULL, 0 };
+	CHECK(SPIBUS_Submit(&empty) == -2);
+	check_rules();
+
+	// Stuck DMA: blocking transfer times out, bus reset, queued transactions fail
+	uint32_t resets = SPIBUS_GetStats()->resets;
+	uint32_t bmp_errors = SPIBUS_GetStats()->device[SPIBUS_DEVICE_BMP280].errors;
+	SPIBusTransaction queued = { SPIBUS_DEVICE_NORFLASH, &status_cmd, 1, rx[0], 1, NULL, NULL, 0 };
+	fail_next_dma = SIM_DMA_HANG;
+	CHECK(SPIBUS_Submit(&queued) == 0);
+	uint64_t start_us = now_us;
+	CHECK(BMP280_Read(BMP280_REG_PRESS_MSB, data, 6) == -1);
+	CHECK(now_us - start_us <= (SPIBUS_TIMEOUT_MS + 1) * 1000 + 1000);
+	CHECK(queued.status == -1);
+	CHECK(SPIBUS_GetStats()->resets == resets + 1);
+	CHECK(SPIBUS_GetStats()->device[SPIBUS_DEVICE_BMP280].errors == bmp_errors + 1);
+	CHECK(BMP280_Read(BMP280_REG_PRESS_MSB, data, 6) == 0);
+	CHECK(data[0] == 0x58);
+	check_rules();
+
+	// Interrupts masked: the completion is delayed, not lost
+	CHECK(SPIBUS_Submit(&queued) == 0);
+	__disable_irq();
+	advance(1000);
+	CHECK(queued.status == SPIBUS_PENDING);
+	__enable_irq();
+	while (SPIBUS_GetPending() > 0) {
+		advance(1);
+	}
+	CHECK(queued.status == 0);
+	check_rules();
+
+	// Per device throughput over a window
+	SPIBUS_Update();
+	bmp_errors = 0;
+	reset_device(1);
+	CHECK(NORFLASH_Init() == 0);
+	SPIBUS_Update();
+	write_log(0, 8192, 100, &bmp_errors);
+	SPIBUS_Update();
+	const SPIBusStats *stats = SPIBUS_GetStats();
+	CHECK(bmp_errors == 0);
+	CHECK(stats->device[SPIBUS_DEVICE_NORFLASH].bytes_per_s > 8192);
+	CHECK(stats->device[SPIBUS_DEVICE_BMP280].bytes_per_s >= 6000); // 7 bytes every ms
+	CHECK(stats->queue_max <= SPIBUS_QUEUE_SIZE + 1);
+	check_rules();
+	printf("Bus: NOR flash %u B/s, BMP280 %u B/s, queue max %u, resets %u\n",
+			stats->device[SPIBUS_DEVICE_NORFLASH].bytes_per_s, stats->device[SPIBUS_DEVICE_BMP280].bytes_per_s,
+			stats->queue_max, stats->resets);
+}
+
+int main() {
+	nor.memory = malloc(SIM_SIZE);
+	SPI_HandleTypeDef no_dma = { SPI2, NULL, NULL };
+	CHECK(SPIBUS_Init(&no_dma) == -1);
+	CHECK(SPIBUS_Init(&hspi2) == 0);
+	SPIBUS_SetChipSelect(SPIBUS_DEVICE_BMP280, BMP_CS_GPIO_Port, BMP_CS_Pin);
+
+	test_init();
+	test_arguments();
+	test_pipeline();
+	test_errors();
+	test_bus();
+
+	printf("%s (%d failures)\n", failures ? "FAIL" : "PASS", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,602 @@
+/*
+ * recorder_test.c
+ *
+ * Host test of the recorder mount and head handling (Core/Src/GAUL/Recorder.c),
+ * compiled as is against the HAL stub (Tools/hal_stub). The recorder region is
+ * a RAM image, every programmed halfword and page erase goes through the flash
+ * model, which can cut them with a reset (longjmp back to the boot).
+ *
+ * Checked:
+ * - Flash images built by hand: empty log, log in progress, cut record, cut
+ *   page header, cut erase, ring wrap (with a cut header at the oldest page).
+ *   The head, slot, next sequence and erased pages found by the mount must
+ *   match, and records written after the mount must land on the next page.
+ * - Reset in the first page after launch (page header written on the pad), and
+ *   boot after a fault reset: nothing may be erased ahead.
+ * - Random resets: flight event records are written on the pad (pages erased
+ *   ahead), in flight (no erase) then the log is erased once landed, with
+ *   resets cutting records, page headers and erases (the erase once landed is
+ *   done again after its cut). After each boot, valid
+ *   records of the pages with a valid header must be in order in the log
+ *   (RECORDER_ReadLog()), no valid record may be lost in flight, and records
+ *   may only be dropped in flight once no erased page is left.
+ *
+ * Build: gcc -O2 -Wall -Ihal_stub -I../Core/Inc -o recorder_test recorder_test.c
+ *        ../Core/Src/GAUL/Recorder.c ../Core/Src/GAUL/SampleBus.c ../Core/Src/GAUL/SampleCodec.c -lm
+ * Usage: ./recorder_test [-r rounds] [-s seed]
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL/Recorder.h"
+#include "GAUL/Telemetry.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/Scheduler.h"
+#include "GAUL/Clock.h"
+#include "GAUL/Crc.h"
+#include "GAUL/Fault.h"
+#include "GAUL/DownloadProtocol.h" // for DOWNLOAD_Crc32(), same as the CRC unit
+
+#define SIM_PAGES 16
+#define SIM_SIZE (SIM_PAGES * RECORDER_PAGE_SIZE)
+#define SIM_UPDATE_MS 50			// Recorder task period
+#define SIM_MAX_CUT_OPS 600			// Flash operations (halfwords, erases) before a reset
+#define SIM_ERASE_OPS 100			// Operations per page erase (~20 ms, a halfword takes ~50 us)
+#define SIM_SESSION_UPDATES 200		// Longest session between two resets
+
+// Recorder region (linker script symbols)
+uint8_t _recorder_start[SIM_SIZE] __attribute__((aligned(RECORDER_PAGE_SIZE)));
+__asm__(".globl _recorder_end\n.set _recorder_end, _recorder_start + 16384");
+_Static_assert(SIM_SIZE == 16384, "_recorder_end");
+
+// Recorder head (Recorder.c)
+extern uint16_t _recorder_page;
+extern uint8_t _recorder_slot;
+extern uint32_t _recorder_sequence;
+extern uint8_t _recorder_launched;
+
+// Hardware model
+GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+FLASH_TypeDef sim_flash;
+SCB_Type sim_scb;
+volatile int sim_irq_disabled = 0;
+
+static uint32_t sim_ms = 0;
+static uint32_t sim_crc = 0xFFFFFFFF;
+static FlightState sim_state = FLIGHT_STATE_PAD_IDLE;
+static const FaultRecord *sim_fault = NULL;	// Boot after a fault reset
+
+// Resets: flash operations left before the cut (-1: none)
+static jmp_buf sim_boot;
+static long sim_cut_ops = -1;
+
+static struct {
+	uint32_t resets;
+	uint32_t cut_programs;
+	uint32_t cut_erases;
+	uint32_t events;		// Events published
+	uint32_t skipped;		// Pages skipped (cut headers and erases)
+	uint32_t flights;
+	uint32_t failures;
+} sim_stats;
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		printf("FAIL %s:%d: %s\n", __func__, __LINE__, #condition); \
+		sim_stats.failures++; \
+	} \
+} while (0)
+
+// HAL stub
+uint32_t HAL_GetTick(void) {
+	return sim_ms;
+}
+
+void HAL_Delay(uint32_t Delay) {
+	sim_ms += Delay;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+	(void)GPIOx;
+	(void)GPIO_Pin;
+	(void)PinState;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+	return HAL_OK;
+}
+
+/**
+ * Spend flash operations of the budget, cut by a reset when it runs out.
+ *
+ * @param ops: operations of the flash access.
+ *
+ * @return 1 if cut (the caller applies the cut state, then longjmps)
+ */
+static int sim_cut(long ops) {
+	if (sim_cut_ops < 0) {
+		return 0;
+	}
+	if (sim_cut_ops < ops) {
+		sim_cut_ops = -1;
+		return 1;
+	}
+	sim_cut_ops -= ops;
+	return 0;
+}
+
+uint32_t sim_flash_busy(void) {
+	sim_flash.SR = 0; // No programming error (flags written by the firmware are write 1 to clear)
+
+	// The halfword is programmed, reset before the next one
+	if (sim_cut(1)) {
+		sim_stats.cut_programs++;
+		longjmp(sim_boot, 1);
+	}
+	return 0; // Ready
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError) {
+	// 32-bit flash addresses: offset in the recorder region (host pointers are 64-bit)
+	uint8_t *start = &_recorder_start[pEraseInit->PageAddress - (uint32_t)(uintptr_t)_recorder_start];
+
+	*PageError = 0xFFFFFFFF;
+	for (uint32_t page = 0; page < pEraseInit->NbPages; page++) {
+		uint32_t *words = (uint32_t *)&start[page * RECORDER_PAGE_SIZE];
+		if (sim_cut(SIM_ERASE_OPS)) {
+			// Erase cut: some words erased, the others left as they were (any slot 0)
+			for (uint32_t i = 0; i < RECORDER_PAGE_SIZE / 4; i++) {
+				if (rand() % 2) {
+					words[i] = 0xFFFFFFFF;
+				}
+			}
+			sim_stats.cut_erases++;
+			longjmp(sim_boot, 1);
+		}
+		memset(words, 0xFF, RECORDER_PAGE_SIZE);
+	}
+	return HAL_OK;
+}
+
+// Firmware stubs
+uint64_t CLOCK_GetTime_us() {
+	return (uint64_t)sim_ms * 1000;
+}
+
+uint32_t SCHEDULER_GetTick_ms() {
+	return sim_ms;
+}
+
+FlightState FLIGHT_GetState() {
+	return sim_state;
+}
+
+const FaultRecord *FAULT_GetLast() {
+	return sim_fault;
+}
+
+uint32_t CRC32_Compute(const uint32_t *words, uint32_t count) {
+	sim_crc = 0xFFFFFFFF;
+	return CRC32_Accumulate(words, count);
+}
+
+uint32_t CRC32_Accumulate(const uint32_t *words, uint32_t count) {
+	sim_crc = DOWNLOAD_Crc32(sim_crc, words, count);
+	return sim_crc;
+}
+
+void TELEMETRY_PackEvent(const FlightEvent *event, TelemetryEvent *body) {
+	TELEMETRY_SET(EVENT, *body, timestamp_ms, event->timestamp_ms);
+	TELEMETRY_SET(EVENT, *body, state, event->state);
+}
+
+void TELEMETRY_PackBarometer(const Barometer *barometer, TelemetryBaro *body) {
+	memset(body, 0, sizeof(*body));
+}
+
+void TELEMETRY_PackAltitude(const AltitudeFusion *fusion, TelemetryAltitude *body) {
+	memset(body, 0, sizeof(*body));
+}
+
+void TELEMETRY_PackGNSS(const L76LM33 *gnss, TelemetryGNSS *body) {
+	memset(body, 0, sizeof(*body));
+}
+
+// Flash images
+static RecorderRecord *sim_slot(uint16_t page, uint8_t slot) {
+	return (RecorderRecord *)&_recorder_start[page * RECORDER_PAGE_SIZE + slot * RECORDER_RECORD_SIZE];
+}
+
+static void sim_seal(RecorderRecord *record) {
+	memset(&record->data[record->length], 0xFF, RECORDER_RECORD_DATA - record->length);
+	record->crc = CRC32_Compute((const uint32_t *)record, (RECORDER_RECORD_SIZE - sizeof(record->crc)) / 4);
+}
+
+static void sim_header(uint16_t page, uint32_t sequence, uint8_t flags) {
+	RecorderRecord *record = sim_slot(page, 0);
+	RecorderPageHeader header = {
+		.sequence = sequence,
+		.state = (flags & RECORDER_PAGE_FLIGHT) ? FLIGHT_STATE_ASCENT : FLIGHT_STATE_PAD_IDLE,
+		.version = RECORDER_VERSION,
+		.schema = TELEMETRY_SCHEMA_VERSION,
+		.flags = flags
+	};
+
+	record->id = RECORDER_ID_PAGE;
+	record->length = sizeof(header);
+	memcpy(record->data, &header, sizeof(header));
+	sim_seal(record);
+}
+
+static void sim_event(uint16_t page, uint8_t slot, uint32_t timestamp_ms, FlightState state) {
+	RecorderRecord *record = sim_slot(page, slot);
+	FlightEvent event = { timestamp_ms, 0, state };
+	TelemetryEvent body;
+
+	TELEMETRY_PackEvent(&event, &body);
+	record->id = TELEMETRY_MSG_EVENT;
+	record->length = sizeof(body);
+	memcpy(record->data, &body, sizeof(body));
+	sim_seal(record);
+}
+
+/**
+ * Write a page: header and event records (timestamps from the sequence).
+ */
+static void sim_page(uint16_t page, uint32_t sequence, uint8_t records, uint8_t flags) {
+	sim_header(page, sequence, flags);
+	for (uint8_t slot = 1; slot <= records; slot++) {
+		sim_event(page, slot, sequence * 100 + slot, FLIGHT_STATE_PAD_IDLE);
+	}
+}
+
+/**
+ * Erase a record after its first halfwords: programming cut by a reset.
+ */
+static void sim_cut_record(uint16_t page, uint8_t slot, uint8_t halfwords) {
+	memset((uint8_t *)sim_slot(page, slot) + halfwords * 2, 0xFF, RECORDER_RECORD_SIZE - halfwords * 2);
+}
+
+static uint8_t sim_blank(uint16_t page) {
+	for (uint32_t i = 0; i < RECORDER_PAGE_SIZE; i++) {
+		if (_recorder_start[page * RECORDER_PAGE_SIZE + i] != 0xFF) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Publish a flight event, recorded by the next RECORDER_Update().
+ */
+static void sim_publish(uint32_t timestamp_ms) {
+	FlightEvent event = { timestamp_ms, (uint64_t)timestamp_ms * 1000, sim_state };
+	BUS_Publish(BUS_TOPIC_EVENT, &event);
+	sim_stats.events++;
+}
+
+static void sim_update(uint8_t count) {
+	for (uint8_t i = 0; i < count; i++) {
+		sim_ms += SIM_UPDATE_MS;
+		RECORDER_Update();
+	}
+}
+
+/**
+ * Read the whole log (oldest first) and check the order of valid event records.
+ *
+ * @param last_ms: timestamp of the last valid event record, 0 if none.
+ *
+ * @return Valid event records
+ */
+static uint32_t sim_read_log(uint32_t *last_ms) {
+	uint32_t size = RECORDER_GetLogSize();
+	uint32_t count = 0;
+	RecorderRecord record;
+
+	*last_ms = 0;
+	for (uint32_t offset = 0; offset < size; offset += RECORDER_RECORD_SIZE) {
+		CHECK(RECORDER_ReadLog(offset, (uint8_t *)&record, sizeof(record)) == 0);
+		uint8_t valid = record.crc == CRC32_Compute((const uint32_t *)&record, (RECORDER_RECORD_SIZE - sizeof(record.crc)) / 4);
+		if (offset % RECORDER_PAGE_SIZE == 0 && (!valid || record.id != RECORDER_ID_PAGE)) {
+			offset += RECORDER_PAGE_SIZE - RECORDER_RECORD_SIZE; // Page not opened: skipped, stale records of a cut erase
+			continue;
+		}
+		if (!valid || record.id != TELEMETRY_MSG_EVENT || record.length != sizeof(TelemetryEvent)) {
+			continue; // Cut, page header or erased
+		}
+		TelemetryEvent body;
+		memcpy(&body, record.data, sizeof(body));
+		if (count > 0 && body.timestamp_ms <= *last_ms) {
+			printf("FAIL log order: %u after %u at offset %u\n", body.timestamp_ms, *last_ms, offset);
+			sim_stats.failures++;
+		}
+		*last_ms = body.timestamp_ms;
+		count++;
+	}
+	CHECK(RECORDER_ReadLog(size, (uint8_t *)&record, 1) == -1);
+
+	return count;
+}
+
+static void sim_mount(uint16_t page, uint8_t slot, uint32_t sequence, uint16_t pages_ready) {
+	const RecorderStats *stats = RECORDER_GetStats();
+
+	CHECK(RECORDER_Init() == 0);
+	if (_recorder_page != page || _recorder_slot != slot || _recorder_sequence != sequence || stats->pages_ready != pages_ready) {
+		printf("FAIL mount: page %u slot %u sequence %u ready %u, expected %u %u %u %u\n", _recorder_page, _recorder_slot,
+				_recorder_sequence, stats->pages_ready, page, slot, sequence, pages_ready);
+		sim_stats.failures++;
+	}
+}
+
+static void test_empty() {
+	memset(_recorder_start, 0xFF, SIM_SIZE);
+	sim_mount(0, 0, 0, SIM_PAGES);
+
+	sim_publish(1);
+	sim_update(2);
+	CHECK(sim_slot(0, 0)->id == RECORDER_ID_PAGE);
+	sim_mount(0, 2, 1, SIM_PAGES - 1);
+}
+
+static void test_in_progress() {
+	memset(_recorder_start, 0xFF, SIM_SIZE);
+	for (uint16_t page = 0; page < 4; page++) {
+		sim_page(page, 10 + page, RECORDER_RECORDS_PER_PAGE - 1, 0);
+	}
+	sim_page(4, 14, 3, 0);
+	sim_mount(4, 4, 15, SIM_PAGES - 5);
+	CHECK(RECORDER_GetStats()->mount_scan == 0);
+
+	// Cut record: its slot is not reused
+	sim_event(4, 4, 1404, FLIGHT_STATE_PAD_IDLE);
+	sim_cut_record(4, 4, 10);
+	sim_mount(4, 5, 15, SIM_PAGES - 5);
+
+	uint32_t last_ms;
+	CHECK(sim_read_log(&last_ms) == 4 * (RECORDER_RECORDS_PER_PAGE - 1) + 3 && last_ms == 1403);
+}
+
+static void test_cut_header() {
+	memset(_recorder_start, 0xFF, SIM_SIZE);
+	for (uint16_t page = 0; page < 5; page++) {
+		sim_page(page, 10 + page, RECORDER_RECORDS_PER_PAGE - 1, RECORDER_PAGE_FLIGHT);
+	}
+	sim_header(5, 15, RECORDER_PAGE_FLIGHT);
+	sim_cut_record(5, 0, 3);
+
+	// Page 5 skipped, the log still takes records in flight
+	sim_state = FLIGHT_STATE_DESCENT;
+	sim_mount(6, 0, 16, SIM_PAGES - 6);
+	CHECK(RECORDER_GetStats()->flight_logged == 1 && RECORDER_GetStats()->pages_skipped == 1);
+
+	sim_publish(2000);
+	sim_update(2);
+	CHECK(RECORDER_GetStats()->dropped == 0);
+	sim_mount(6, 2, 17, SIM_PAGES - 7);
+
+	uint32_t last_ms;
+	CHECK(sim_read_log(&last_ms) == 5 * (RECORDER_RECORDS_PER_PAGE - 1) + 1 && last_ms == 2000);
+	sim_state = FLIGHT_STATE_PAD_IDLE;
+}
+
+static void test_cut_erase() {
+	memset(_recorder_start, 0xFF, SIM_SIZE);
+	for (uint16_t page = 0; page < 5; page++) {
+		sim_page(page, 10 + page, RECORDER_RECORDS_PER_PAGE - 1, RECORDER_PAGE_FLIGHT);
+	}
+	// Erase cut: first slot erased, not the rest of the page
+	_recorder_start[5 * RECORDER_PAGE_SIZE + 300] = 0x12;
+
+	sim_state = FLIGHT_STATE_DESCENT;
+	sim_mount(5, 0, 15, SIM_PAGES - 5);
+
+	sim_publish(2000);
+	sim_update(2);
+	CHECK(RECORDER_GetStats()->dropped == 0 && RECORDER_GetStats()->pages_skipped == 1);
+	CHECK(sim_slot(5, 0)->id == RECORDER_ID_SKIPPED);
+	CHECK(sim_slot(6, 0)->id == RECORDER_ID_PAGE);
+	sim_mount(6, 2, 17, SIM_PAGES - 7);
+	sim_state = FLIGHT_STATE_PAD_IDLE;
+}
+
+static void test_ring_wrap() {
+	// Pages 7 to 15 from the previous lap, head in page 6
+	for (uint16_t page = 0; page < SIM_PAGES; page++) {
+		uint32_t sequence = page < 7 ? 116 + page : 100 + page;
+		sim_page(page, sequence, page == 6 ? 5 : RECORDER_RECORDS_PER_PAGE - 1, 0);
+	}
+	sim_mount(6, 6, 123, 0);
+
+	// Oldest page erased ahead on the pad
+	sim_update(RECORDER_ERASE_PERIOD_MS / SIM_UPDATE_MS + 1);
+	CHECK(RECORDER_GetStats()->pages_ready == 1 && sim_blank(7));
+
+	// Full head page, cut header at the oldest page (erase cut): skipped, older pages kept
+	for (uint16_t page = 0; page < SIM_PAGES; page++) {
+		uint32_t sequence = page < 8 ? 116 + page : 100 + page;
+		sim_page(page, sequence, RECORDER_RECORDS_PER_PAGE - 1, 0);
+	}
+	sim_cut_record(8, 0, 2);
+	sim_mount(9, 0, 125, 0);
+	CHECK(RECORDER_GetStats()->pages_skipped == 1);
+}
+
+static void test_launch_reset() {
+	static FaultRecord fault;
+
+	// Full ring, head in page 4 opened on the pad, launch event in it, then reset (flight state lost)
+	memset(_recorder_start, 0xFF, SIM_SIZE);
+	for (uint16_t page = 0; page < SIM_PAGES; page++) {
+		uint32_t sequence = page < 5 ? 116 + page : 100 + page;
+		sim_page(page, sequence, page == 4 ? 2 : RECORDER_RECORDS_PER_PAGE - 1, 0);
+	}
+	sim_event(4, 3, 12003, FLIGHT_STATE_ASCENT);
+	sim_mount(4, 4, 121, 0);
+	CHECK(RECORDER_GetStats()->flight_logged == 1 && _recorder_launched == 1);
+
+	// The oldest page is not erased ahead, the flight is kept
+	sim_update(RECORDER_ERASE_PERIOD_MS / SIM_UPDATE_MS + 1);
+	CHECK(RECORDER_GetStats()->pages_ready == 0 && !sim_blank(5));
+
+	// Pad only in the head page: erased ahead, unless booting after a fault reset
+	sim_event(4, 3, 12003, FLIGHT_STATE_PAD_IDLE);
+	sim_fault = &fault;
+	sim_mount(4, 4, 121, 0);
+	CHECK(RECORDER_GetStats()->flight_logged == 0 && _recorder_launched == 0);
+	sim_update(RECORDER_ERASE_PERIOD_MS / SIM_UPDATE_MS + 1);
+	CHECK(RECORDER_GetStats()->pages_ready == 0 && !sim_blank(5));
+
+	sim_fault = NULL;
+	sim_mount(4, 4, 121, 0);
+	sim_update(RECORDER_ERASE_PERIOD_MS / SIM_UPDATE_MS + 1);
+	CHECK(RECORDER_GetStats()->pages_ready == 1 && sim_blank(5));
+}
+
+/**
+ * Boot, write events for a random number of updates, until a random flash
+ * operation resets the board (or the session ends).
+ *
+ * @param valid: valid event records in the log before the session, updated.
+ *
+ * @retval 1 reset
+ * @retval 0 session ended
+ */
+static int run_session(uint32_t *valid) {
+	static volatile uint32_t published_ms;
+	static volatile int booted;
+	uint32_t last_ms;
+
+	sim_cut_ops = rand() % 4 == 0 ? -1 : rand() % SIM_MAX_CUT_OPS;
+	booted = 0;
+	published_ms = 0;
+	if (setjmp(sim_boot) != 0) {
+		if (sim_state == FLIGHT_STATE_PAD_IDLE) {
+			*valid = 0; // Pages may have been erased ahead
+		}
+		sim_stats.resets++;
+		sim_stats.skipped += booted ? RECORDER_GetStats()->pages_skipped : 0;
+		return 1;
+	}
+
+	CHECK(RECORDER_Init() == 0);
+	booted = 1;
+	uint32_t count = sim_read_log(&last_ms);
+	if (sim_state != FLIGHT_STATE_PAD_IDLE && count < *valid) {
+		printf("FAIL %u valid records lost in flight\n", *valid - count);
+		sim_stats.failures++;
+	}
+	*valid = count;
+
+	uint32_t updates = 1 + rand() % SIM_SESSION_UPDATES;
+	for (uint32_t i = 0; i < updates; i++) {
+		if (i % 2 == 0) {
+			published_ms = sim_ms + 1;
+			sim_publish(published_ms);
+		}
+		sim_update(1);
+	}
+	sim_update(4); // Program the buffered records
+	sim_cut_ops = -1;
+
+	const RecorderStats *stats = RECORDER_GetStats();
+	sim_stats.skipped += stats->pages_skipped;
+	count = sim_read_log(&last_ms);
+	if (stats->dropped == 0) {
+		CHECK(last_ms == published_ms);
+	}
+	if (sim_state != FLIGHT_STATE_PAD_IDLE && stats->dropped != 0) {
+		// Dropped in flight: no erased page left
+		for (uint16_t page = 0; page < SIM_PAGES; page++) {
+			if (sim_blank(page)) {
+				printf("FAIL %u records dropped in flight, page %u erased\n", stats->dropped, page);
+				sim_stats.failures++;
+				break;
+			}
+		}
+	}
+	*valid = count;
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
+	uint32_t rounds = 50;
+	int option;
+
+	while ((option = getopt(argc, argv, "r:s:")) != -1) {
+		switch (option) {
+			case 'r': rounds = strtoul(optarg, NULL, 0); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+				return 1;
+		}
+	}
+	srand(seed);
+
+	test_empty();
+	test_in_progress();
+	test_cut_header();
+	test_cut_erase();
+	test_ring_wrap();
+	test_launch_reset();
+	printf("Flash images: %s\n", sim_stats.failures == 0 ? "OK" : "FAIL");
+
+	// Pad (ring wraps, pages erased ahead), flight until the log is full, erase once landed
+	memset(_recorder_start, 0xFF, SIM_SIZE);
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t valid = 0;
+
+		sim_state = FLIGHT_STATE_PAD_IDLE;
+		for (uint32_t i = 0; i < 10; i++) {
+			run_session(&valid);
+		}
+
+		sim_state = FLIGHT_STATE_ASCENT;
+		for (uint32_t i = 0; i < 100; i++) {
+			run_session(&valid);
+			if (RECORDER_GetStats()->pages_ready == 0 && RECORDER_GetStats()->dropped != 0) {
+				break; // Log full
+			}
+		}
+		sim_stats.flights++;
+
+		// Erase once landed, cut by a reset then done again
+		sim_state = FLIGHT_STATE_LANDED;
+		if (setjmp(sim_boot) == 0) {
+			sim_cut_ops = rand() % (SIM_PAGES * SIM_ERASE_OPS);
+			RECORDER_Erase();
+		} else {
+			sim_stats.resets++;
+		}
+		sim_cut_ops = -1;
+		uint32_t last_ms;
+		CHECK(RECORDER_Init() == 0);
+		sim_read_log(&last_ms);
+		CHECK(RECORDER_Erase() == 0);
+	}
+
+	printf("Seed %u, %u flights, %u resets (%u cut programs, %u cut erases), %u pages skipped, %u events\n", seed,
+			sim_stats.flights, sim_stats.resets, sim_stats.cut_programs, sim_stats.cut_erases, sim_stats.skipped,
+			sim_stats.events);
+	printf("%s (%u failures)\n", sim_stats.failures == 0 ? "PASS" : "FAIL", sim_stats.failures);
+
+	return sim_stats.failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,639 @@
+/*
+ * telemetry_decoder.c
+ *
+ * Host decoder of the binary telemetry downlink (Core/Inc/GAUL/Telemetry.h).
+ * Splits the byte stream on frame delimiters, COBS decodes (Core/Inc/GAUL/Cobs.h)
+ * and CRC checks each frame, then decodes the message with the same schema as
+ * the firmware (Core/Inc/GAUL/TelemetrySchema.h) and writes it as CSV. Lost
+ * frames are counted from the sequence numbers (one sequence per message).
+ * Recovery beacons (NMEA like text between frames) are printed on stderr.
+ * Compressed frames (Core/Inc/GAUL/SampleCodec.h) are decoded from the first
+ * keyframe, and again from the next keyframe after a lost frame.
+ *
+ * The self-test (-t) runs the firmware telemetry (Core/Src/GAUL/Telemetry.c,
+ * built against Tools/hal_stub): samples are packed and queued by the firmware
+ * functions, the TX ring is sent by a UART DMA stub, and the captured bytes
+ * are decoded back and compared.
+ *
+ * Build: gcc -O2 -Wall -Ihal_stub -I../Core/Inc -o telemetry_decoder telemetry_decoder.c
+ *        ../Core/Src/GAUL/Telemetry.c ../Core/Src/GAUL/SampleBus.c ../Core/Src/GAUL/SampleCodec.c -lm
+ * Usage: ./telemetry_decoder [-o prefix] [capture.bin]   (stdin if no capture file)
+ *        -o prefix: one CSV file per message (prefix_BARO.csv, ...), else all on stdout
+ *        ./telemetry_decoder -t   (round trip self-test through the firmware telemetry)
+ *
+ * Live: stty -F /dev/ttyACM0 115200 raw && ./telemetry_decoder < /dev/ttyACM0
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GAUL/TelemetrySchema.h"
+#include "GAUL/SampleCodec.h"
+#include "GAUL/Telemetry.h"
+#include "GAUL/SampleBus.h"
+#include "GAUL/CpuLoad.h"
+#include "GAUL/TimeSync.h"
+#include "GAUL/Fault.h"
+
+TELEMETRY_DEFINE_MESSAGE_TABLE(messages)
+#define MESSAGE_COUNT (sizeof(messages) / sizeof(messages[0]))
+
+#define MAX_FRAME 512
+
+// CSV output per message, NULL if not opened yet
+static const char *output_prefix = NULL;
+static FILE *outputs[MESSAGE_COUNT];
+
+static struct {
+	uint32_t frames;
+	uint32_t lost;
+	uint32_t crc_errors;
+	uint32_t unknown;		// Unknown message ID or wrong body size
+	uint32_t text;
+	uint32_t unsynced;		// Compressed frames before a keyframe
+	int last_sequence[256];	// Per message ID, -1 before the first frame
+	int version_checked;
+} stats;
+
+// Delta decoder of each compressed message
+static struct {
+	SampleCodec codec;
+	int synced;				// 0 until a keyframe, and after a lost frame
+} decoders[TELEMETRY_ID_MASK + 1];
+
+/**
+ * CRC-16/CCITT-FALSE, same as the firmware.
+ */
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		crc ^= (uint16_t)data[i] << 8;
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+static const TelemetryMessage *find_message(uint8_t id) {
+	for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+		if (messages[i].id == id) {
+			return &messages[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Read a field of a message body (little endian, sign extended).
+ */
+static int64_t field_raw(const TelemetryField *field, const uint8_t *body) {
+	const uint8_t *p = body + field->offset;
+	switch (field->type) {
+	case TELEMETRY_FIELD_U8:
+		return p[0];
+	case TELEMETRY_FIELD_I8:
+		return (int8_t)p[0];
+	case TELEMETRY_FIELD_U16:
+		return (uint16_t)(p[0] | p[1] << 8);
+	case TELEMETRY_FIELD_I16:
+		return (int16_t)(p[0] | p[1] << 8);
+	case TELEMETRY_FIELD_U32:
+		return (uint32_t)(p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+	case TELEMETRY_FIELD_I32:
+		return (int32_t)(p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+	}
+	return 0;
+}
+
+static double field_value(const TelemetryField *field, const uint8_t *body) {
+	return (double)field_raw(field, body) / field->scale;
+}
+
+static void print_field(FILE *out, const TelemetryField *field, const uint8_t *body) {
+	if (field->scale == 1) {
+		fprintf(out, ",%lld", (long long)field_raw(field, body));
+	} else {
+		int digits = (int)ceil(log10(field->scale));
+		fprintf(out, ",%.*f", digits, field_value(field, body));
+	}
+}
+
+/**
+ * Get the CSV output of a message, write the header on first use.
+ */
+static FILE *message_output(const TelemetryMessage *message) {
+	size_t index = message - messages;
+	if (outputs[index] != NULL) {
+		return outputs[index];
+	}
+
+	if (output_prefix != NULL) {
+		char path[256];
+		snprintf(path, sizeof(path), "%s_%s.csv", output_prefix, message->name);
+		outputs[index] = fopen(path, "w");
+		if (outputs[index] == NULL) {
+			perror(path);
+			exit(1);
+		}
+	} else {
+		outputs[index] = stdout;
+	}
+
+	FILE *out = outputs[index];
+	fprintf(out, "%smessage,sequence", output_prefix != NULL ? "" : "# ");
+	for (uint8_t i = 0; i < message->field_count; i++) {
+		const TelemetryField *field = &message->fields[i];
+		fprintf(out, ",%s%s%s%s", field->name, field->unit[0] ? " (" : "", field->unit, field->unit[0] ? ")" : "");
+	}
+	fprintf(out, "\n");
+	return out;
+}
+
+/**
+ * Write scaled field values to a message body (inverse of TELEMETRY_<type>ToValues()).
+ */
+static void values_to_body(const TelemetryMessage *message, const int32_t *values, uint8_t *body) {
+	static const uint8_t sizes[] = { 1, 1, 2, 2, 4, 4 };
+	for (uint8_t i = 0; i < message->field_count; i++) {
+		const TelemetryField *field = &message->fields[i];
+		for (uint8_t b = 0; b < sizes[field->type]; b++) {
+			body[field->offset + b] = (uint32_t)values[i] >> (8 * b);
+		}
+	}
+}
+
+static void print_message(const TelemetryMessage *message, uint8_t sequence, const uint8_t *body) {
+	FILE *out = message_output(message);
+	fprintf(out, "%s,%u", message->name, sequence);
+	for (uint8_t i = 0; i < message->field_count; i++) {
+		print_field(out, &message->fields[i], body);
+	}
+	fprintf(out, "\n");
+}
+
+// Decoded messages go to the CSV output, or to the self-test
+static void (*message_sink)(const TelemetryMessage *message, uint8_t sequence, const uint8_t *body) = print_message;
+
+/**
+ * Decode the samples of a compressed frame.
+ *
+ * @return 0 OK, -1 ERROR not synchronized or malformed
+ */
+static int decode_compressed(const TelemetryMessage *message, int keyframe, uint8_t sequence, const uint8_t *body,
+		size_t length) {
+	if (message->field_count > CODEC_MAX_FIELDS) {
+		stats.unknown++;
+		return -1;
+	}
+	if (keyframe) {
+		CODEC_Init(&decoders[message->id].codec, message->field_count, CODEC_KEYFRAME_INTERVAL);
+		decoders[message->id].synced = 1;
+	}
+	if (!decoders[message->id].synced) {
+		stats.unsynced++;
+		return -1;
+	}
+
+	size_t position = 0;
+	while (position < length) {
+		int32_t values[CODEC_MAX_FIELDS];
+		uint8_t sample[MAX_FRAME];
+		int size = CODEC_Decode(&decoders[message->id].codec, &body[position], length - position,
+				keyframe && position == 0, values);
+		if (size < 0) {
+			decoders[message->id].synced = 0;
+			stats.unknown++;
+			return -1;
+		}
+		position += size;
+
+		values_to_body(message, values, sample);
+		message_sink(message, sequence, sample);
+	}
+	return 0;
+}
+
+/**
+ * Decode one frame (delimiter removed).
+ *
+ * @return 0 OK, -1 ERROR not a valid frame
+ */
+static int decode_frame(const uint8_t *frame, size_t length) {
+	uint8_t payload[MAX_FRAME];
+
+	int payload_length = COBS_Decode(frame, length, payload);
+	if (payload_length < 4 || crc16(0xFFFF, payload, payload_length - 2)
+			!= (payload[payload_length - 2] | payload[payload_length - 1] << 8)) {
+		// Recovery beacon, sent as text between frames
+		if (length > 1 && frame[0] == '$') {
+			fprintf(stderr, "%.*s", (int)length, (const char *)frame);
+			stats.text++;
+			return 0;
+		}
+		stats.crc_errors++;
+		return -1;
+	}
+
+	// Sequence numbers are per message, messages of different priorities are reordered
+	uint8_t id = payload[0] & TELEMETRY_ID_MASK;
+	uint8_t sequence = payload[1];
+	if (stats.last_sequence[id] >= 0 && sequence != (uint8_t)(stats.last_sequence[id] + 1)) {
+		stats.lost += (uint8_t)(sequence - stats.last_sequence[id] - 1);
+		decoders[id].synced = 0; // Delta chain broken
+	}
+	stats.last_sequence[id] = sequence;
+	stats.frames++;
+
+	const TelemetryMessage *message = find_message(id);
+	const uint8_t *body = &payload[2];
+	if (message != NULL && (payload[0] & TELEMETRY_ID_COMPRESSED)) {
+		return decode_compressed(message, payload[0] & TELEMETRY_ID_KEYFRAME, sequence, body, payload_length - 4);
+	}
+	if (message == NULL || payload_length - 4 != message->size) {
+		stats.unknown++; // Firmware built with another schema
+		return -1;
+	}
+
+	if (message->id == TELEMETRY_MSG_HEALTH && !stats.version_checked) {
+		stats.version_checked = 1;
+		int version = -1;
+		for (uint8_t i = 0; i < message->field_count; i++) {
+			if (strcmp(message->fields[i].name, "schema_version") == 0) {
+				version = (int)field_raw(&message->fields[i], body);
+			}
+		}
+		if (version != TELEMETRY_SCHEMA_VERSION) {
+			fprintf(stderr, "warning: firmware schema version %d, decoder version %d\n", version,
+					TELEMETRY_SCHEMA_VERSION);
+		}
+	}
+
+	message_sink(message, sequence, body);
+
+	return 0;
+}
+
+// Firmware stubs (self-test)
+volatile int sim_irq_disabled = 0;
+USART_TypeDef sim_usart1, sim_usart2;
+static uint32_t sim_ms = 0;
+static UART_HandleTypeDef sim_huart;
+static DMA_HandleTypeDef sim_hdmatx;
+static const uint8_t *sim_tx_data = NULL;	// DMA transfer in progress
+static uint16_t sim_tx_size = 0;
+static CpuLoad sim_cpuload;
+static TimeSync sim_timesync;
+
+uint32_t HAL_GetTick(void) {
+	return sim_ms;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+	(void)huart;
+	sim_tx_data = pData;
+	sim_tx_size = Size;
+	return HAL_OK;
+}
+
+const CpuLoad *CPULOAD_Get() {
+	return &sim_cpuload;
+}
+
+const TimeSync *TIMESYNC_Get() {
+	return &sim_timesync;
+}
+
+const FaultRecord *FAULT_GetLast() {
+	return NULL;
+}
+
+FlightState FLIGHT_GetState() {
+	return FLIGHT_STATE_ASCENT;
+}
+
+uint8_t FLIGHT_ApogeeArmed() {
+	return 0;
+}
+
+// Bytes sent by the firmware, and messages decoded from them
+static uint8_t test_capture[1 << 16];
+static size_t test_captured;
+
+#define TEST_MAX_MESSAGES 512
+static struct {
+	const TelemetryMessage *message;
+	uint8_t body[MAX_FRAME];
+} test_messages[TEST_MAX_MESSAGES];
+static int test_count;
+
+static void test_sink(const TelemetryMessage *message, uint8_t sequence, const uint8_t *body) {
+	(void)sequence;
+	if (test_count < TEST_MAX_MESSAGES) {
+		test_messages[test_count].message = message;
+		memcpy(test_messages[test_count].body, body, message->size);
+		test_count++;
+	}
+}
+
+/**
+ * Complete the DMA transfers started by the firmware (the TX complete
+ * callback starts the next one), capture the bytes sent.
+ */
+static void test_drain() {
+	while (sim_tx_data != NULL) {
+		const uint8_t *data = sim_tx_data;
+		uint16_t size = sim_tx_size;
+		sim_tx_data = NULL;
+		if (test_captured + size <= sizeof(test_capture)) {
+			memcpy(&test_capture[test_captured], data, size);
+			test_captured += size;
+		}
+		TELEMETRY_TxCpltCallback(&sim_huart);
+	}
+}
+
+/**
+ * Decode the captured bytes into test_messages (frames split like main()).
+ */
+static void test_decode() {
+	size_t start = 0;
+	test_count = 0;
+	for (size_t i = 0; i < test_captured; i++) {
+		if (test_capture[i] == 0x00) {
+			if (i > start) {
+				decode_frame(&test_capture[start], i - start);
+			}
+			start = i + 1;
+		}
+	}
+}
+
+/**
+ * Find a field of a decoded message by name.
+ *
+ * @return Scaled value, NAN if not found
+ */
+static double test_field(int index, const char *name) {
+	const TelemetryMessage *message = test_messages[index].message;
+	for (uint8_t f = 0; f < message->field_count; f++) {
+		if (strcmp(message->fields[f].name, name) == 0) {
+			return field_value(&message->fields[f], test_messages[index].body);
+		}
+	}
+	return NAN;
+}
+
+/**
+ * Barometer sample of a climbing and coasting flight (with a tick wrap).
+ */
+static Barometer test_barometer(int i) {
+	Barometer barometer = { 0 };
+	barometer.timestamp_ms = 0xFFFFFF00u + 40 * i;
+	barometer.altitude_m = 0.5f * i * i - 10;
+	barometer.speed_mps = 1.0f * i;
+	barometer.acceleration_mps2 = i < 50 ? 30.0f : -9.8f;
+	barometer.coasting = i > 50;
+	barometer.outlier = i == 70;
+	return barometer;
+}
+
+/**
+ * Round trip self-test: samples are packed, framed and queued by the firmware
+ * telemetry, sent by the UART DMA stub, then decoded with the descriptor
+ * tables and compared.
+ *
+ * @return 0 OK, 1 ERROR
+ */
+static int self_test() {
+	int errors = 0;
+
+	sim_huart.Instance = USART2;
+	sim_huart.Init.BaudRate = 115200;
+	sim_huart.hdmatx = &sim_hdmatx;
+	sim_huart.gState = HAL_UART_STATE_READY;
+	if (TELEMETRY_Init(&sim_huart) != 0) {
+		fprintf(stderr, "FAIL telemetry init\n");
+		return 1;
+	}
+	message_sink = test_sink;
+
+	// Raw messages from the firmware packers, including zero bytes and negative values
+	Barometer barometer = { 0 };
+	barometer.timestamp_ms = 65536;
+	barometer.altitude_m = 1234.56f;
+	barometer.speed_mps = -42.5f;
+	barometer.acceleration_mps2 = 400.0f; // Outlier spike, saturates
+	barometer.coasting = 1;
+	TelemetryBaro baro;
+	TELEMETRY_PackBarometer(&barometer, &baro);
+
+	L76LM33 fix = { 0 };
+	fix.timestamp_ms = 1000;
+	fix.latitude = 46.7816f;
+	fix.longitude = -71.2747f;
+	fix.altitude_m = 98.7f;
+	fix.hdop = 1.25f;
+	fix.fix_quality = 1;
+	fix.satellites = 9;
+	TelemetryGNSS gnss;
+	TELEMETRY_PackGNSS(&fix, &gnss);
+
+	FlightEvent event = { 2000, 2000000, FLIGHT_STATE_DESCENT };
+	TelemetryEvent event_body;
+	TELEMETRY_PackEvent(&event, &event_body);
+
+	if (TELEMETRY_Send(TELEMETRY_MSG_BARO, (const uint8_t *)&baro, sizeof(baro)) != 0
+			|| TELEMETRY_Send(TELEMETRY_MSG_GNSS, (const uint8_t *)&gnss, sizeof(gnss)) != 0
+			|| TELEMETRY_Send(TELEMETRY_MSG_EVENT, (const uint8_t *)&event_body, sizeof(event_body)) != 0) {
+		fprintf(stderr, "FAIL firmware send\n");
+		errors++;
+	}
+	test_drain();
+
+	// Delimiter only at the end of each frame: the capture ends with one, no empty frame
+	int delimiters_ok = test_captured > 0 && test_capture[0] != 0 && test_capture[test_captured - 1] == 0;
+	for (size_t i = 1; i < test_captured; i++) {
+		if (test_capture[i - 1] == 0 && test_capture[i] == 0) {
+			delimiters_ok = 0;
+		}
+	}
+	if (!delimiters_ok) {
+		fprintf(stderr, "FAIL frame delimiters\n");
+		errors++;
+	}
+	test_decode();
+
+	struct {
+		const char *message;
+		const char *field;
+		double expected;
+		double tolerance;
+	} cases[] = {
+		{ "BARO", "timestamp_ms", 65536, 0 },
+		{ "BARO", "altitude_m", 1234.56, 0.011 },
+		{ "BARO", "speed_mps", -42.5, 0.011 },
+		{ "BARO", "acceleration_mps2", 327.67, 0.001 },
+		{ "BARO", "flags", 2, 0 },
+		{ "GNSS", "latitude", 46.7816, 1e-5 },
+		{ "GNSS", "longitude", -71.2747, 1e-5 },
+		{ "GNSS", "altitude_m", 98.7, 0.11 },
+		{ "GNSS", "hdop", 1.25, 0.011 },
+		{ "GNSS", "satellites", 9, 0 },
+		{ "EVENT", "timestamp_ms", 2000, 0 },
+		{ "EVENT", "state", FLIGHT_STATE_DESCENT, 0 },
+	};
+	if (test_count != 3) {
+		fprintf(stderr, "FAIL raw messages: %d decoded\n", test_count);
+		errors++;
+	}
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		double value = NAN;
+		for (int m = 0; m < test_count; m++) {
+			if (strcmp(test_messages[m].message->name, cases[i].message) == 0) {
+				value = test_field(m, cases[i].field);
+			}
+		}
+		if (!(fabs(value - cases[i].expected) <= cases[i].tolerance)) {
+			fprintf(stderr, "FAIL %s.%s: %f, expected %f\n", cases[i].message, cases[i].field, value, cases[i].expected);
+			errors++;
+		}
+	}
+
+	// Corrupted frame is rejected
+	size_t first_length = strlen((const char *)test_capture);
+	test_capture[2] ^= 0x10;
+	if (decode_frame(test_capture, first_length) == 0) {
+		fprintf(stderr, "FAIL corrupted frame accepted\n");
+		errors++;
+	}
+	test_capture[2] ^= 0x10;
+
+	// Compressed streams through TELEMETRY_Update(): barometer samples from the bus,
+	// batched and delta encoded by the firmware (health sent once per second)
+	test_captured = 0;
+	TelemetryBaro expected[100];
+	for (int i = 0; i < 100; i++) {
+		Barometer sample = test_barometer(i);
+		TELEMETRY_PackBarometer(&sample, &expected[i]);
+		BUS_Publish(BUS_TOPIC_BARO, &sample);
+		sim_ms += 40;
+		TELEMETRY_Update();
+		test_drain();
+	}
+	sim_ms += TELEMETRY_BATCH_MS;
+	TELEMETRY_Update();
+	test_drain();
+	test_decode();
+
+	int baro_count = 0;
+	int health_count = 0;
+	for (int i = 0; i < test_count; i++) {
+		if (test_messages[i].message->id == TELEMETRY_MSG_BARO) {
+			if (baro_count < 100 && memcmp(test_messages[i].body, &expected[baro_count], sizeof(TelemetryBaro)) != 0) {
+				fprintf(stderr, "FAIL compressed sample %d: values\n", baro_count);
+				errors++;
+			}
+			baro_count++;
+		} else if (test_messages[i].message->id == TELEMETRY_MSG_HEALTH) {
+			if (test_field(i, "schema_version") != TELEMETRY_SCHEMA_VERSION) {
+				fprintf(stderr, "FAIL health schema version\n");
+				errors++;
+			}
+			health_count++;
+		}
+	}
+	if (baro_count != 100 || health_count < 3) {
+		fprintf(stderr, "FAIL compressed stream: %d samples, %d health\n", baro_count, health_count);
+		errors++;
+	}
+	const TelemetryStream *stream = TELEMETRY_GetStream(TELEMETRY_STREAM_BARO);
+	if (stats.lost != 0 || stats.crc_errors != 1 || stats.unsynced != 0 || stats.unknown != 0) {
+		fprintf(stderr, "FAIL decoder stats: %u lost, %u CRC errors, %u unsynced, %u unknown\n", stats.lost,
+				stats.crc_errors, stats.unsynced, stats.unknown);
+		errors++;
+	}
+
+	// Every descriptor covers its whole body, fields in order without overlap
+	for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+		static const uint8_t sizes[] = { 1, 1, 2, 2, 4, 4 };
+		uint8_t offset = 0;
+		for (uint8_t f = 0; f < messages[i].field_count; f++) {
+			if (messages[i].fields[f].offset != offset) {
+				fprintf(stderr, "FAIL %s.%s: offset %u\n", messages[i].name, messages[i].fields[f].name, messages[i].fields[f].offset);
+				errors++;
+			}
+			offset += sizes[messages[i].fields[f].type];
+		}
+		if (offset != messages[i].size) {
+			fprintf(stderr, "FAIL %s: size %u, fields %u\n", messages[i].name, messages[i].size, offset);
+			errors++;
+		}
+	}
+
+	// Out of range values saturate (outlier spike), NaN gives 0
+	TelemetryBaro spike;
+	TELEMETRY_SET(BARO, spike, acceleration_mps2, 400.0f);
+	TELEMETRY_SET(BARO, spike, speed_mps, -1e30f);
+	TELEMETRY_SET(BARO, spike, altitude_m, NAN);
+	TELEMETRY_SET(BARO, spike, flags, 300);
+	if (spike.acceleration_mps2 != INT16_MAX || spike.speed_mps != INT32_MIN || spike.altitude_m != 0
+			|| spike.flags != UINT8_MAX) {
+		fprintf(stderr, "FAIL out of range values: %d %d %d %u\n", spike.acceleration_mps2, spike.speed_mps,
+				spike.altitude_m, spike.flags);
+		errors++;
+	}
+
+	printf("%s: %d error(s), %d barometer samples in %lu compressed bytes\n", errors ? "FAIL" : "OK", errors,
+			baro_count, (unsigned long)stream->encoded_bytes);
+	return errors ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+	int arg = 1;
+	memset(stats.last_sequence, -1, sizeof(stats.last_sequence));
+	if (arg < argc && strcmp(argv[arg], "-t") == 0) {
+		return self_test();
+	}
+	if (arg + 1 < argc && strcmp(argv[arg], "-o") == 0) {
+		output_prefix = argv[arg + 1];
+		arg += 2;
+	}
+
+	FILE *input = stdin;
+	if (arg < argc && (input = fopen(argv[arg], "rb")) == NULL) {
+		perror(argv[arg]);
+		return 1;
+	}
+
+	uint8_t frame[MAX_FRAME];
+	size_t length = 0;
+	int c;
+	while ((c = fgetc(input)) != EOF) {
+		if (c != 0x00) {
+			if (length < sizeof(frame)) {
+				frame[length++] = c;
+			}
+			continue;
+		}
+		if (length > 0 && length < sizeof(frame)) {
+			decode_frame(frame, length);
+		}
+		length = 0;
+	}
+
+	fprintf(stderr, "%u frames, %u lost, %u CRC errors, %u unknown, %u unsynced, %u beacons\n", stats.frames,
+			stats.lost, stats.crc_errors, stats.unknown, stats.unsynced, stats.text);
+
+	for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+		if (outputs[i] != NULL && outputs[i] != stdout) {
+			fclose(outputs[i]);
+		}
+	}
+	return 0;
+}